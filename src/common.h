@@ -77,6 +77,7 @@
 #include <libplacebo/swapchain.h>
 #include <libplacebo/tone_mapping.h>
 #include <libplacebo/utils/frame_queue.h>
+#include <libplacebo/utils/throughput.h>
 #include <libplacebo/utils/upload.h>
 
 #ifdef PL_HAVE_VULKAN
@@ -98,6 +99,9 @@
 // This is faster but must only be called on positive powers of two.
 #define PL_ALIGN2(x, align) (((x) + (align) - 1) & ~((align) - 1))
 
+// Integer division, rounding up
+#define PL_DIV_UP(x, y) (((x) + (y) - 1) / (y))
+
 // Returns the log base 2 of an unsigned long long
 #define PL_LOG2(x) ((unsigned) (8*sizeof (unsigned long long) - __builtin_clzll((x)) - 1))
 
@@ -43,6 +43,7 @@ struct pl_dispatch {
     uint8_t current_index;
     bool dynamic_constants;
     int max_passes;
+    atomic_bool evict; // set on memory pressure, see `pl_gpu_evict`
 
     void (*info_callback)(void *, const struct pl_dispatch_info *);
     void *info_priv;
@@ -115,6 +116,12 @@ static void pass_destroy(pl_dispatch dp, struct pass *pass)
     pl_free(pass);
 }
 
+static void dispatch_evict_cb(void *priv)
+{
+    pl_dispatch dp = priv;
+    atomic_store(&dp->evict, true);
+}
+
 pl_dispatch pl_dispatch_create(pl_log log, pl_gpu gpu)
 {
     struct pl_dispatch *dp = pl_zalloc_ptr(NULL, dp);
@@ -122,6 +129,8 @@ pl_dispatch pl_dispatch_create(pl_log log, pl_gpu gpu)
     dp->log = log;
     dp->gpu = gpu;
     dp->max_passes = MAX_PASSES;
+    atomic_init(&dp->evict, false);
+    pl_gpu_evict_register(gpu, dispatch_evict_cb, dp);
 
     return dp;
 }
@@ -132,6 +141,7 @@ void pl_dispatch_destroy(pl_dispatch *ptr)
     if (!dp)
         return;
 
+    pl_gpu_evict_unregister(dp->gpu, dispatch_evict_cb, dp);
     for (int i = 0; i < dp->passes.num; i++)
         pass_destroy(dp, dp->passes.elem[i]);
     for (int i = 0; i < dp->shaders.num; i++)
@@ -707,6 +717,28 @@ static void garbage_collect_passes(pl_dispatch dp)
     }
 }
 
+// Under memory pressure, drop all passes older than MIN_AGE, regardless of
+// the current cache size
+static void evict_passes(pl_dispatch dp)
+{
+    int num = 0;
+    for (int i = 0; i < dp->passes.num; i++) {
+        struct pass *pass = dp->passes.elem[i];
+        if (pass_age(pass) >= MIN_AGE) {
+            pass_destroy(dp, pass);
+        } else {
+            dp->passes.elem[num++] = pass;
+        }
+    }
+
+    if (num < dp->passes.num) {
+        PL_DEBUG(dp, "Evicted %d passes from dispatch cache due to memory "
+                 "pressure", dp->passes.num - num);
+    }
+
+    dp->passes.num = num;
+}
+
 static struct pass *finalize_pass(pl_dispatch dp, pl_shader sh,
                                   pl_tex target, ident_t vert_pos,
                                   const struct pl_blend_params *blend, bool load,
@@ -1566,6 +1598,8 @@ void pl_dispatch_reset_frame(pl_dispatch dp)
     dp->current_ident = 0;
     dp->current_index++;
     garbage_collect_passes(dp);
+    if (atomic_exchange(&dp->evict, false))
+        evict_passes(dp);
 
     pl_mutex_unlock(&dp->lock);
 }
@@ -16,11 +16,13 @@
  */
 
 #include <math.h>
+#include <stdatomic.h>
 
 #include "common.h"
 #include "log.h"
 #include "shaders.h"
 #include "gpu.h"
+#include "pl_thread.h"
 
 #define require(expr)                                           \
   do {                                                          \
@@ -33,13 +35,32 @@
       }                                                         \
   } while (0)
 
+static void upload_ring_destroy(pl_gpu gpu, struct pl_upload_ring **ring);
+static void buf_pool_destroy(pl_gpu gpu, struct pl_buf_pool **pool);
+static void evict_list_destroy(struct pl_evict_list **list);
+static void buf_pool_evict_cb(void *priv);
+
 void pl_gpu_destroy(pl_gpu gpu)
 {
     if (!gpu)
         return;
 
-    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    // Drain all pending work first, so that no transfer callbacks referring
+    // to the upload ring or buffer pool (e.g. `ring_region_cb`) can fire
+    // after they've been freed
+    struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    impl->gpu_finish(gpu);
+
+    upload_ring_destroy(gpu, &impl->upload_ring);
+    if (impl->buf_pool)
+        pl_gpu_evict_unregister(gpu, buf_pool_evict_cb, impl->buf_pool);
+    buf_pool_destroy(gpu, &impl->buf_pool);
+
+    // Backends unregister their own caches (e.g. the dispatch) while being
+    // destroyed, and `impl` itself is freed along with `gpu`
+    struct pl_evict_list *evict = atomic_load(&impl->evict);
     impl->destroy(gpu);
+    evict_list_destroy(&evict);
 }
 
 bool pl_fmt_is_ordered(pl_fmt fmt)
@@ -195,6 +216,10 @@ static void print_formats(pl_gpu gpu)
     }
 }
 
+static struct pl_upload_ring *upload_ring_create(pl_gpu gpu);
+static struct pl_buf_pool *buf_pool_create(pl_gpu gpu);
+static struct pl_evict_list *evict_list_get(pl_gpu gpu);
+
 pl_gpu pl_gpu_finalize(struct pl_gpu *gpu)
 {
     // Sort formats
@@ -348,6 +373,11 @@ pl_gpu pl_gpu_finalize(struct pl_gpu *gpu)
     gpu->limits.max_gather_offset = gpu->glsl.max_gather_offset;
     gpu->limits.max_variables = gpu->limits.max_variable_comps;
 
+    struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    impl->upload_ring = upload_ring_create(gpu);
+    impl->buf_pool = buf_pool_create(gpu);
+    evict_list_get(gpu); // make sure it exists before `gpu` is shared
+    pl_gpu_evict_register(gpu, buf_pool_evict_cb, impl->buf_pool);
     return gpu;
 }
 
@@ -605,7 +635,8 @@ static inline bool check_mod(pl_gpu gpu, pl_fmt fmt, uint64_t mod)
     return false;
 }
 
-pl_tex pl_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
+static pl_tex tex_create(pl_gpu gpu, const struct pl_tex_params *params,
+                         bool internal)
 {
     require(!params->import_handle || !params->export_handle);
     require(!params->import_handle || !params->initial_data);
@@ -662,6 +693,8 @@ pl_tex pl_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
     require(!params->blit_dst   || fmt->caps & PL_FMT_CAP_BLITTABLE);
 
     const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    if (internal && impl->tex_create_internal)
+        return impl->tex_create_internal(gpu, params);
     return impl->tex_create(gpu, params);
 
 error:
@@ -670,6 +703,16 @@ error:
     return NULL;
 }
 
+pl_tex pl_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
+{
+    return tex_create(gpu, params, false);
+}
+
+pl_tex pl_tex_create_internal(pl_gpu gpu, const struct pl_tex_params *params)
+{
+    return tex_create(gpu, params, true);
+}
+
 void pl_tex_destroy(pl_gpu gpu, pl_tex *tex)
 {
     if (!*tex)
@@ -693,7 +736,8 @@ static bool pl_tex_params_superset(struct pl_tex_params a, struct pl_tex_params
            (a.host_readable  || !b.host_readable);
 }
 
-bool pl_tex_recreate(pl_gpu gpu, pl_tex *tex, const struct pl_tex_params *params)
+static bool tex_recreate(pl_gpu gpu, pl_tex *tex,
+                         const struct pl_tex_params *params, bool internal)
 {
     if (params->initial_data) {
         PL_ERR(gpu, "pl_tex_recreate may not be used with `initial_data`!");
@@ -714,11 +758,22 @@ bool pl_tex_recreate(pl_gpu gpu, pl_tex *tex, const struct pl_tex_params *params
              params->w, params->h, params->d, params->format->name);
 
     pl_tex_destroy(gpu, tex);
-    *tex = pl_tex_create(gpu, params);
+    *tex = tex_create(gpu, params, internal);
 
     return !!*tex;
 }
 
+bool pl_tex_recreate(pl_gpu gpu, pl_tex *tex, const struct pl_tex_params *params)
+{
+    return tex_recreate(gpu, tex, params, false);
+}
+
+bool pl_tex_recreate_internal(pl_gpu gpu, pl_tex *tex,
+                              const struct pl_tex_params *params)
+{
+    return tex_recreate(gpu, tex, params, true);
+}
+
 void pl_tex_clear_ex(pl_gpu gpu, pl_tex dst, const union pl_clear_color color)
 {
     require(dst->params.blit_dst);
@@ -1142,6 +1197,262 @@ bool pl_buf_poll(pl_gpu gpu, pl_buf buf, uint64_t t)
     return impl->buf_poll ? impl->buf_poll(gpu, buf, t) : false;
 }
 
+#define BUF_POOL_MAX_BUFS 64
+#define BUF_POOL_MAX_SIZE ((size_t) 512 << 20) // 512 MiB
+#define BUF_POOL_ALIGN    4096
+
+struct pl_buf_pool {
+    pl_mutex lock;
+    PL_ARRAY(pl_buf) bufs; // idle buffers, in order of release
+    struct pl_buf_pool_stats stats;
+    atomic_bool evict;     // drop all idle buffers on the next put
+};
+
+static void buf_pool_evict_cb(void *priv)
+{
+    struct pl_buf_pool *pool = priv;
+    atomic_store(&pool->evict, true);
+}
+
+static struct pl_buf_pool *buf_pool_create(pl_gpu gpu)
+{
+    struct pl_buf_pool *pool = pl_zalloc_ptr(NULL, pool);
+    pl_mutex_init(&pool->lock);
+    atomic_init(&pool->evict, false);
+    return pool;
+}
+
+static void buf_pool_destroy(pl_gpu gpu, struct pl_buf_pool **pool)
+{
+    if (!*pool)
+        return;
+
+    for (int i = 0; i < (*pool)->bufs.num; i++)
+        pl_buf_destroy(gpu, &(*pool)->bufs.elem[i]);
+    pl_mutex_destroy(&(*pool)->lock);
+    pl_free_ptr(pool);
+}
+
+static bool buf_poolable(const struct pl_buf_params *params)
+{
+    return !params->initial_data && !params->export_handle &&
+           !params->import_handle && !params->user_data;
+}
+
+static bool buf_pool_match(const struct pl_buf_params *a,
+                           const struct pl_buf_params *b)
+{
+    return a->size == b->size &&
+           a->host_writable == b->host_writable &&
+           a->host_readable == b->host_readable &&
+           a->host_mapped == b->host_mapped &&
+           a->uniform == b->uniform &&
+           a->storable == b->storable &&
+           a->drawable == b->drawable &&
+           a->memory_type == b->memory_type &&
+           a->format == b->format;
+}
+
+// Whether the backend would rather have an idle buffer destroyed than re-used
+static bool buf_pool_release(pl_gpu gpu, pl_buf buf)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    return impl->buf_should_release && impl->buf_should_release(gpu, buf);
+}
+
+static void buf_pool_remove(struct pl_buf_pool *pool, int idx)
+{
+    pool->stats.size -= pool->bufs.elem[idx]->params.size;
+    PL_ARRAY_REMOVE_AT(pool->bufs, idx);
+    pool->stats.num_bufs = pool->bufs.num;
+}
+
+static void buf_pool_insert(struct pl_buf_pool *pool, int idx, pl_buf buf)
+{
+    PL_ARRAY_INSERT_AT(pool, pool->bufs, idx, buf);
+    pool->stats.size += buf->params.size;
+    pool->stats.num_bufs = pool->bufs.num;
+}
+
+pl_buf pl_buf_pool_get(pl_gpu gpu, const struct pl_buf_params *params)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_buf_pool *pool = impl->buf_pool;
+    if (!buf_poolable(params))
+        return pl_buf_create(gpu, params);
+
+    // Round up the size, so that slightly differently sized requests (e.g.
+    // due to per-frame alignment padding) can share buffers
+    struct pl_buf_params fixed = *params;
+    size_t max_size = gpu->limits.max_buf_size;
+    if (params->host_mapped)
+        max_size = PL_MIN(max_size, gpu->limits.max_mapped_size);
+    if (params->uniform)
+        max_size = PL_MIN(max_size, gpu->limits.max_ubo_size);
+    if (params->storable)
+        max_size = PL_MIN(max_size, gpu->limits.max_ssbo_size);
+    if (PL_ALIGN2(params->size, BUF_POOL_ALIGN) <= max_size)
+        fixed.size = PL_ALIGN2(params->size, BUF_POOL_ALIGN);
+
+    pl_mutex_lock(&pool->lock);
+    for (int i = 0; i < pool->bufs.num; i++) {
+        pl_buf buf = pool->bufs.elem[i];
+        if (!buf_pool_match(&buf->params, &fixed))
+            continue;
+
+        // Don't hold the lock while polling, since this may dispatch
+        // callbacks which in turn return other buffers to the pool
+        buf_pool_remove(pool, i);
+        pl_mutex_unlock(&pool->lock);
+        bool busy = pl_buf_poll(gpu, buf, 0);
+        if (!busy && buf_pool_release(gpu, buf)) {
+            pl_buf_destroy(gpu, &buf);
+            pl_mutex_lock(&pool->lock);
+            pool->stats.evictions++;
+            i--;
+            continue;
+        }
+
+        pl_mutex_lock(&pool->lock);
+        if (!busy) {
+            pool->stats.hits++;
+            pl_mutex_unlock(&pool->lock);
+            return buf;
+        }
+
+        pool->stats.busy++;
+        buf_pool_insert(pool, PL_MIN(i, pool->bufs.num), buf);
+    }
+
+    pool->stats.misses++;
+    pl_mutex_unlock(&pool->lock);
+    return pl_buf_create(gpu, &fixed);
+}
+
+void pl_buf_pool_put(pl_gpu gpu, pl_buf *pbuf)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_buf_pool *pool = impl->buf_pool;
+    pl_buf buf = *pbuf;
+    *pbuf = NULL;
+    if (!buf)
+        return;
+
+    if (!buf_poolable(&buf->params) || buf_pool_release(gpu, buf)) {
+        pl_buf_destroy(gpu, &buf);
+        return;
+    }
+
+    pl_buf evicted[BUF_POOL_MAX_BUFS + 1];
+    int num_evicted = 0;
+
+    pl_mutex_lock(&pool->lock);
+    buf_pool_insert(pool, pool->bufs.num, buf);
+    size_t max_size = BUF_POOL_MAX_SIZE;
+    if (atomic_exchange(&pool->evict, false))
+        max_size = 0; // under memory pressure, keep nothing around
+    while (pool->bufs.num > BUF_POOL_MAX_BUFS || pool->stats.size > max_size) {
+        evicted[num_evicted++] = pool->bufs.elem[0];
+        buf_pool_remove(pool, 0);
+        pool->stats.evictions++;
+    }
+    pl_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < num_evicted; i++)
+        pl_buf_destroy(gpu, &evicted[i]);
+}
+
+void pl_buf_pool_stats(pl_gpu gpu, struct pl_buf_pool_stats *out_stats)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_buf_pool *pool = impl->buf_pool;
+    pl_mutex_lock(&pool->lock);
+    *out_stats = pool->stats;
+    pl_mutex_unlock(&pool->lock);
+}
+
+struct evict_entry {
+    pl_evict_cb cb;
+    void *priv;
+};
+
+struct pl_evict_list {
+    pl_mutex lock;
+    PL_ARRAY(struct evict_entry) entries;
+};
+
+// Backends may register caches (e.g. their internal `pl_dispatch`) from
+// within their constructor, before `pl_gpu_finalize`, so the list is created
+// lazily by whichever comes first
+static struct pl_evict_list *evict_list_get(pl_gpu gpu)
+{
+    struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_evict_list *list = atomic_load(&impl->evict);
+    if (list)
+        return list;
+
+    list = pl_zalloc_ptr(NULL, list);
+    pl_mutex_init(&list->lock);
+
+    struct pl_evict_list *prev = NULL;
+    if (!atomic_compare_exchange_strong(&impl->evict, &prev, list)) {
+        // Lost the race against another thread
+        pl_mutex_destroy(&list->lock);
+        pl_free(list);
+        list = prev;
+    }
+
+    return list;
+}
+
+static void evict_list_destroy(struct pl_evict_list **list)
+{
+    if (!*list)
+        return;
+
+    pl_mutex_destroy(&(*list)->lock);
+    pl_free_ptr(list);
+}
+
+void pl_gpu_evict_register(pl_gpu gpu, pl_evict_cb cb, void *priv)
+{
+    struct pl_evict_list *list = evict_list_get(gpu);
+    pl_mutex_lock(&list->lock);
+    PL_ARRAY_APPEND(list, list->entries, (struct evict_entry) { cb, priv });
+    pl_mutex_unlock(&list->lock);
+}
+
+void pl_gpu_evict_unregister(pl_gpu gpu, pl_evict_cb cb, void *priv)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_evict_list *list = atomic_load(&impl->evict);
+    if (!list)
+        return; // nothing was ever registered
+
+    pl_mutex_lock(&list->lock);
+    for (int i = 0; i < list->entries.num; i++) {
+        if (list->entries.elem[i].cb == cb && list->entries.elem[i].priv == priv) {
+            PL_ARRAY_REMOVE_AT(list->entries, i);
+            break;
+        }
+    }
+    pl_mutex_unlock(&list->lock);
+}
+
+void pl_gpu_evict(pl_gpu gpu)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_evict_list *list = atomic_load(&impl->evict);
+    if (!list)
+        return; // nothing registered yet
+
+    pl_mutex_lock(&list->lock);
+    PL_DEBUG(gpu, "Memory pressure, evicting %d caches", list->entries.num);
+    for (int i = 0; i < list->entries.num; i++)
+        list->entries.elem[i].cb(list->entries.elem[i].priv);
+    pl_mutex_unlock(&list->lock);
+}
+
 size_t pl_var_type_size(enum pl_var_type type)
 {
     switch (type) {
@@ -1674,6 +1985,241 @@ bool pl_gpu_is_failed(pl_gpu gpu)
 
 // GPU-internal helpers
 
+// Streaming upload ring. Host pointer uploads are copied into successive
+// regions of a single persistently mapped buffer, which are released in
+// submission order once the GPU is done with them.
+#define UPLOAD_RING_SIZE    (64 << 20) // 64 MiB
+#define UPLOAD_RING_REGIONS 64
+
+struct ring_region {
+    struct pl_upload_ring *ring;
+    size_t end;     // end offset of this region
+    size_t span;    // bytes occupied, including alignment and wrap-around
+    bool submitted; // pl_tex_upload was called on this region
+    atomic_bool done;
+
+    // Original transfer callback
+    void (*callback)(void *priv);
+    void *priv;
+};
+
+struct pl_upload_ring {
+    pl_mutex lock;
+    pl_buf buf;
+    bool failed; // don't retry creating `buf`
+    size_t head, tail;
+    struct ring_region regions[UPLOAD_RING_REGIONS];
+    int first, num; // FIFO of regions currently in flight
+    struct pl_gpu_upload_stats stats;
+};
+
+static struct pl_upload_ring *upload_ring_create(pl_gpu gpu)
+{
+    // The ring is pointless unless the buffer can be mapped persistently
+    if (gpu->limits.max_mapped_size < UPLOAD_RING_SIZE ||
+        gpu->limits.max_buf_size < UPLOAD_RING_SIZE)
+        return NULL;
+
+    struct pl_upload_ring *ring = pl_zalloc_ptr(NULL, ring);
+    pl_mutex_init(&ring->lock);
+    for (int i = 0; i < UPLOAD_RING_REGIONS; i++) {
+        ring->regions[i].ring = ring;
+        atomic_init(&ring->regions[i].done, false);
+    }
+    return ring;
+}
+
+static void upload_ring_destroy(pl_gpu gpu, struct pl_upload_ring **ring)
+{
+    if (!*ring)
+        return;
+
+    pl_buf_destroy(gpu, &(*ring)->buf);
+    pl_mutex_destroy(&(*ring)->lock);
+    pl_free_ptr(ring);
+}
+
+static void ring_region_cb(void *priv)
+{
+    struct ring_region *region = priv;
+    void (*callback)(void *priv) = region->callback;
+    void *cb_priv = region->priv;
+
+    // The region may be reused as soon as this flag is set, so read the
+    // original callback first
+    atomic_store(&region->done, true);
+    if (callback)
+        callback(cb_priv);
+}
+
+// Release all completed regions at the start of the FIFO. Must be called
+// with `ring->lock` held.
+static void ring_reclaim(pl_gpu gpu, struct pl_upload_ring *ring)
+{
+    bool idle = false;
+    if (ring->num && !gpu->limits.callbacks) {
+        // Without callbacks, the only indication of completion is the buffer
+        // as a whole becoming idle
+        struct ring_region *oldest = &ring->regions[ring->first];
+        if (oldest->submitted)
+            idle = !pl_buf_poll(gpu, ring->buf, 0);
+    }
+
+    while (ring->num) {
+        struct ring_region *region = &ring->regions[ring->first];
+        if (!region->submitted)
+            break;
+        if (!idle && !atomic_load(&region->done))
+            break;
+
+        ring->tail = region->end;
+        ring->stats.ring_used -= region->span;
+        ring->first = (ring->first + 1) % UPLOAD_RING_REGIONS;
+        ring->num--;
+    }
+
+    if (!ring->num)
+        ring->head = ring->tail = 0;
+}
+
+// Try allocating `size` bytes from the ring. Must be called with
+// `ring->lock` held.
+static struct ring_region *ring_alloc(struct pl_upload_ring *ring, size_t size,
+                                      size_t align, size_t *out_offset)
+{
+    if (ring->num == UPLOAD_RING_REGIONS)
+        return NULL;
+
+    const size_t cap = ring->buf->params.size;
+    size_t offset = PL_ALIGN(ring->head, align);
+    if (ring->head > ring->tail || !ring->num) {
+        if (offset + size > cap) {
+            // Wrap around to the start of the buffer
+            if (size > ring->tail && ring->num)
+                return NULL;
+            offset = 0;
+        }
+    } else if (ring->head == ring->tail || offset + size > ring->tail) {
+        return NULL; // full
+    }
+
+    struct ring_region *region;
+    region = &ring->regions[(ring->first + ring->num++) % UPLOAD_RING_REGIONS];
+    region->end = offset + size;
+    region->span = offset >= ring->head ? region->end - ring->head
+                                        : cap - ring->head + region->end;
+    region->submitted = false;
+    atomic_store(&region->done, false);
+
+    ring->head = region->end;
+    ring->stats.ring_used += region->span;
+    ring->stats.ring_peak = PL_MAX(ring->stats.ring_peak, ring->stats.ring_used);
+    *out_offset = offset;
+    return region;
+}
+
+// Returns NULL if the ring can't be used for an upload of this size
+static struct pl_upload_ring *ring_get(pl_gpu gpu, size_t size)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_upload_ring *ring = impl->upload_ring;
+    if (!ring)
+        return NULL;
+
+    pl_mutex_lock(&ring->lock);
+    if (!ring->buf && !ring->failed) {
+        ring->buf = pl_buf_create(gpu, pl_buf_params(
+            .size = UPLOAD_RING_SIZE,
+            .host_mapped = true,
+            .debug_tag = PL_DEBUG_TAG,
+        ));
+
+        ring->failed = !ring->buf;
+        if (ring->buf)
+            ring->stats.ring_size = ring->buf->params.size;
+    }
+
+    // Limit the size of individual uploads, to ensure at least two of them
+    // can be in flight at the same time
+    if (!ring->buf || size > UPLOAD_RING_SIZE / 2) {
+        ring->stats.fallbacks++;
+        pl_mutex_unlock(&ring->lock);
+        return NULL;
+    }
+
+    pl_mutex_unlock(&ring->lock);
+    return ring;
+}
+
+static bool ring_upload(pl_gpu gpu, struct pl_upload_ring *ring,
+                        const struct pl_tex_transfer_params *params, size_t size)
+{
+    // Keep offsets aligned to the texel size, as well as to a generous
+    // multiple of the typical optimal buffer copy alignment
+    const size_t texel_size = params->tex->params.format->texel_size;
+    size_t align = 256;
+    while (align % texel_size)
+        align += 256;
+
+    size_t offset;
+    struct ring_region *region;
+    bool stalled = false;
+    pl_mutex_lock(&ring->lock);
+    ring_reclaim(gpu, ring);
+    while (!(region = ring_alloc(ring, size, align, &offset))) {
+        // Back-pressure: wait for the GPU to catch up. The lock is released
+        // while waiting, since other threads may need to mark their regions
+        // as submitted before they can be released.
+        ring->stats.stalls += !stalled;
+        stalled = true;
+        pl_mutex_unlock(&ring->lock);
+        pl_buf_poll(gpu, ring->buf, 1000000); // 1 ms
+        pl_mutex_lock(&ring->lock);
+        ring_reclaim(gpu, ring);
+    }
+
+    region->callback = params->callback;
+    region->priv = params->priv;
+    ring->stats.uploads++;
+    ring->stats.bytes += size;
+    pl_mutex_unlock(&ring->lock);
+
+    memcpy((uint8_t *) ring->buf->data + offset, params->ptr, size);
+
+    struct pl_tex_transfer_params newparams = *params;
+    newparams.buf = ring->buf;
+    newparams.buf_offset = offset;
+    newparams.ptr = NULL;
+    if (gpu->limits.callbacks) {
+        newparams.callback = ring_region_cb;
+        newparams.priv = region;
+    }
+
+    bool ok = pl_tex_upload(gpu, &newparams);
+
+    pl_mutex_lock(&ring->lock);
+    region->submitted = true;
+    if (!ok)
+        atomic_store(&region->done, true);
+    pl_mutex_unlock(&ring->lock);
+    return ok;
+}
+
+void pl_gpu_upload_stats(pl_gpu gpu, struct pl_gpu_upload_stats *out_stats)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_upload_ring *ring = impl->upload_ring;
+    if (!ring) {
+        *out_stats = (struct pl_gpu_upload_stats) {0};
+        return;
+    }
+
+    pl_mutex_lock(&ring->lock);
+    ring_reclaim(gpu, ring);
+    *out_stats = ring->stats;
+    pl_mutex_unlock(&ring->lock);
+}
+
 bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params)
 {
     if (params->buf)
@@ -1706,6 +2252,10 @@ bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params)
     }
 
     if (!buf) {
+        struct pl_upload_ring *ring = ring_get(gpu, bufparams.size);
+        if (ring)
+            return ring_upload(gpu, ring, params, bufparams.size);
+
         bufparams.import_handle = 0;
         bufparams.host_writable = true;
         buf = pl_buf_create(gpu, &bufparams);
@@ -64,6 +64,21 @@ struct pl_gpu_fns {
     GPU_PFN(gpu_flush); // optional
     GPU_PFN(gpu_finish);
     GPU_PFN(gpu_is_failed); // optional
+
+    // Optional: returns whether an idle buffer should be destroyed instead of
+    // being re-used, e.g. to allow the backend to defragment its memory
+    bool (*buf_should_release)(pl_gpu, pl_buf);
+
+    // Optional: like `tex_create`, but only used for textures which are never
+    // exposed to the user (see `pl_tex_create_internal`), e.g. to allow the
+    // backend to transparently relocate their memory
+    pl_tex (*tex_create_internal)(pl_gpu, const struct pl_tex_params *);
+
+    // Backend-independent state, managed by `pl_gpu_finalize` and
+    // `pl_gpu_destroy`. Backends must leave this zero-initialized.
+    struct pl_upload_ring *upload_ring;
+    struct pl_buf_pool *buf_pool;
+    _Atomic(struct pl_evict_list *) evict;
 };
 #undef GPU_PFN
 
@@ -83,6 +98,24 @@ static inline bool pl_gpu_supports_interop(pl_gpu gpu)
            gpu->import_caps.sync;
 }
 
+// Memory pressure handling. Objects which hold on to GPU resources purely for
+// caching purposes can register a callback, which backends invoke (through
+// `pl_gpu_evict`) when running out of memory budget. Callbacks may be called
+// from any thread and from within arbitrary `pl_gpu` calls, so they must not
+// call into the `pl_gpu` themselves. Instead, they should flag their caches
+// to be trimmed at the next safe opportunity.
+typedef void (*pl_evict_cb)(void *priv);
+void pl_gpu_evict_register(pl_gpu gpu, pl_evict_cb cb, void *priv);
+void pl_gpu_evict_unregister(pl_gpu gpu, pl_evict_cb cb, void *priv);
+void pl_gpu_evict(pl_gpu gpu);
+
+// Variants of `pl_tex_create` and `pl_tex_recreate` for textures owned by
+// libplacebo itself, such as `pl_renderer` intermediates or shader LUTs, which
+// are never handed out to the user directly.
+pl_tex pl_tex_create_internal(pl_gpu gpu, const struct pl_tex_params *params);
+bool pl_tex_recreate_internal(pl_gpu gpu, pl_tex *tex,
+                              const struct pl_tex_params *params);
+
 // GPU-internal helpers: these should not be used outside of GPU implementations
 
 // This performs several tasks. It sorts the format list, logs GPU metadata,
@@ -104,7 +137,8 @@ uint32_t pl_fmt_fourcc(pl_fmt fmt);
 size_t pl_tex_transfer_size(const struct pl_tex_transfer_params *par);
 
 // Helper that wraps pl_tex_upload/download using texture upload buffers to
-// ensure that params->buf is always set.
+// ensure that params->buf is always set. Uploads are staged through a
+// persistently mapped ring buffer shared by all callers, where possible.
 bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 
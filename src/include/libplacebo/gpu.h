@@ -650,6 +650,40 @@ bool pl_buf_export(pl_gpu gpu, pl_buf buf);
 // by another thread.
 bool pl_buf_poll(pl_gpu gpu, pl_buf buf, uint64_t timeout);
 
+// Every `pl_gpu` maintains a pool of idle buffers, intended for code which
+// repeatedly needs buffers with the same parameters, e.g. host-mapped buffers
+// for decoders or encoders to directly read from or write into.
+//
+// `pl_buf_pool_get` behaves like `pl_buf_create`, except that it first tries
+// re-using an idle buffer with matching parameters. Buffers are matched on
+// their size (rounded up to a multiple of the page size), and all of the
+// usage flags, the memory type and the format. Buffers with `initial_data`,
+// `export_handle`, `import_handle` or `user_data` are never pooled. Note that
+// the returned buffer's contents are undefined, and its size may be larger
+// than `params->size`.
+//
+// `pl_buf_pool_put` returns a buffer to the pool. This may be done while the
+// buffer is still in use by the GPU, in which case it will only be re-used
+// once `pl_buf_poll` reports it as idle. If the pool is already full, the
+// least recently returned buffer is destroyed instead. Sets `*buf` to NULL.
+//
+// Both functions are thread-safe, provided the `pl_gpu` is. Buffers returned
+// by `pl_buf_pool_get` may also be freed with `pl_buf_destroy` as usual.
+pl_buf pl_buf_pool_get(pl_gpu gpu, const struct pl_buf_params *params);
+void pl_buf_pool_put(pl_gpu gpu, pl_buf *buf);
+
+struct pl_buf_pool_stats {
+    int num_bufs;       // number of idle buffers currently in the pool
+    size_t size;        // total size of idle buffers currently in the pool
+    uint64_t hits;      // number of `pl_buf_pool_get` calls served by the pool
+    uint64_t misses;    // number of `pl_buf_pool_get` calls creating a buffer
+    uint64_t busy;      // number of matching buffers skipped for being in use
+    uint64_t evictions; // number of buffers destroyed due to the pool being full
+};
+
+// Retrieve the current buffer pool statistics. Thread-safe.
+void pl_buf_pool_stats(pl_gpu gpu, struct pl_buf_pool_stats *out_stats);
+
 enum pl_tex_sample_mode {
     PL_TEX_SAMPLE_NEAREST,  // nearest neighbour sampling
     PL_TEX_SAMPLE_LINEAR,   // linear filtering, requires PL_FMT_CAP_LINEAR
@@ -904,6 +938,23 @@ bool pl_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 // Download data from a texture. Returns whether successful.
 bool pl_tex_download(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 
+// Uploads from host memory (`ptr`) which can't be performed directly are
+// staged through a persistently mapped ring buffer shared by all uploads on
+// the same `pl_gpu`, rather than through a temporary buffer per upload. If
+// the GPU falls behind, uploads block until enough space has been released.
+struct pl_gpu_upload_stats {
+    size_t ring_size;   // size of the ring buffer, or 0 if not (yet) in use
+    size_t ring_used;   // bytes currently occupied by uploads in flight
+    size_t ring_peak;   // highest value of `ring_used` so far
+    uint64_t uploads;   // number of uploads staged through the ring
+    uint64_t bytes;     // total number of bytes staged through the ring
+    uint64_t stalls;    // number of uploads which had to wait for space
+    uint64_t fallbacks; // number of uploads too large for the ring
+};
+
+// Retrieve the current upload ring statistics. Thread-safe.
+void pl_gpu_upload_stats(pl_gpu gpu, struct pl_gpu_upload_stats *out_stats);
+
 // Returns whether or not a texture is currently "in use". This can either be
 // because of a pending read operation, a pending write operation or a pending
 // texture export operation. Note that this function's usefulness is extremely
@@ -33,6 +33,16 @@
 PL_API_BEGIN
 
 // Thread-safety: Unsafe
+//
+// Note: A single `pl_renderer` must only ever be used by one thread at a time.
+// However, any number of renderers may share the same `pl_gpu`, and be used
+// concurrently from different threads, as long as `pl_gpu_limits.thread_safe`
+// is set. Each renderer keeps its own `pl_dispatch`, shader objects and
+// intermediate textures, so the only state shared between them is the `pl_gpu`
+// itself. On Vulkan, this means the device memory allocator and the command
+// submission queues; the former is locked per memory pool, while the latter
+// serializes command recording, so CPU-side shader generation and parameter
+// setup scale with the number of threads but GPU command recording does not.
 typedef PL_STRUCT(pl_renderer) *pl_renderer;
 
 // Creates a new renderer object, which is backed by a GPU context. This is a
@@ -280,6 +290,20 @@ struct pl_render_params {
     // user, but it should be set to false once those values are "dialed in".
     bool dynamic_constants;
 
+    // If nonzero, `pl_render_image` splits targets larger than this size (in
+    // either dimension) into square tiles of this size, which are rendered
+    // one at a time. This bounds the size of all intermediate textures that
+    // scale with the target size, which is useful for rendering very large
+    // images under limited VRAM, or beyond `max_tex_2d_dim`. Each tile is
+    // rendered with an extra border (based on the scaler and debanding
+    // radius) to avoid visible seams, so smaller tiles increase the amount of
+    // redundant work. Peak detection is performed once for the whole frame.
+    //
+    // Note: Requires all target planes to be blittable. Frames with overlays
+    // or rotation are always rendered in one pass. User hooks which sample
+    // beyond the scaler radius may produce seams.
+    int render_tile_size;
+
     // This callback is invoked for every pass successfully executed in the
     // process of rendering a frame. Optional.
     //
@@ -651,6 +675,11 @@ bool pl_render_image(pl_renderer rr, const struct pl_frame *image,
 // dramatically (e.g. when switching to a different file).
 void pl_renderer_flush_cache(pl_renderer rr);
 
+// Retrieves the most recent HDR peak detection results (including the
+// brightness histogram), if `pl_peak_detect_params.readback_frames` was
+// enabled. This never blocks. See `pl_get_detected_stats`.
+bool pl_renderer_get_peak_stats(pl_renderer rr, struct pl_peak_detect_stats *out);
+
 // Represents a mixture of input frames, distributed temporally.
 //
 // NOTE: Frames must be sorted by timestamp, i.e. `timestamps` must be
@@ -127,6 +127,17 @@ struct pl_peak_detect_params {
     // imposes a hard lower bound on the detected peak. If left as 0.0, it
     // instead defaults to a value of 1.0.
     float minimum_peak;
+
+    // If nonzero, the detected values (along with a histogram of the frame
+    // brightness) are additionally copied into a ring of this many
+    // host-visible buffers, which can be read out without stalling the GPU
+    // using `pl_get_detected_stats`. The results of a frame are copied out
+    // when the next peak detection shader is generated, so they are always
+    // at least one frame behind. Up to this many copies can be in flight at
+    // a time, so higher values make it less likely for results to be
+    // skipped while the GPU is lagging behind. Clamped to
+    // `PL_PEAK_DETECT_MAX_READBACK`. Defaults to 0 (disabled).
+    int readback_frames;
 };
 
 #define PL_PEAK_DETECT_DEFAULTS         \
@@ -176,6 +187,41 @@ bool pl_get_detected_peak(const pl_shader_obj state,
 // state used by `pl_shader_tone_map`.
 void pl_reset_detected_peak(pl_shader_obj state);
 
+#define PL_PEAK_DETECT_MAX_READBACK 8
+#define PL_PEAK_HISTOGRAM_BINS 64
+
+// The histogram covers the range [PL_PEAK_HISTOGRAM_MIN, PL_PEAK_HISTOGRAM_MAX]
+// (in PL_HDR_NORM units), with bins spaced logarithmically.
+#define PL_PEAK_HISTOGRAM_MIN 1e-3f
+#define PL_PEAK_HISTOGRAM_MAX 50.0f
+
+struct pl_peak_detect_stats {
+    // Smoothed CLL and FALL, as returned by `pl_get_detected_peak`.
+    float peak, avg;
+
+    // Raw (unsmoothed) CLL and FALL measured for this frame. Mainly useful
+    // for scene change detection.
+    float frame_peak, frame_avg;
+
+    // Number of pixels per histogram bin, binned by the maximum component
+    // of the linear light RGB value. Bin `i` covers the range starting at
+    // MIN * pow(MAX / MIN, i / PL_PEAK_HISTOGRAM_BINS). Values outside the
+    // histogram range are clamped to the first/last bin.
+    uint32_t histogram[PL_PEAK_HISTOGRAM_BINS];
+
+    // Number of frames this result is behind the most recently generated
+    // peak detection shader. This is 1 if the GPU is keeping up, and higher
+    // if more recent results are still in flight or had to be skipped.
+    int latency;
+};
+
+// Retrieves the most recent results that have been read back asynchronously,
+// for shaders generated with `pl_peak_detect_params.readback_frames` enabled.
+// Unlike `pl_get_detected_peak`, this never blocks. Returns false if no new
+// results have become available since the last call.
+bool pl_get_detected_stats(const pl_shader_obj state,
+                           struct pl_peak_detect_stats *out_stats);
+
 // Deprecated. See <libplacebo/tone_mapping.h> for replacements.
 enum pl_tone_mapping_algorithm {
     PL_TONE_MAPPING_CLIP,
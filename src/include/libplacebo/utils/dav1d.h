@@ -82,6 +82,11 @@ static bool pl_upload_dav1dpicture(pl_gpu gpu,
 // `pl_upload_dav1dpicture`, or on platforms that don't support importing
 // PL_HANDLE_HOST_PTR as buffers. Returns 0 or a negative DAV1D_ERR value.
 //
+// The buffers are taken from the GPU's buffer pool (see `pl_buf_pool_get`),
+// and returned to it by `pl_release_dav1dpicture`. Released buffers are only
+// re-used once any uploads from them have completed, so it's safe to release
+// a picture as soon as `pl_upload_dav1dpicture` returns.
+//
 // Note: These may only be used directly as a Dav1dPicAllocator if the `gpu`
 // passed as the value of `cookie` is `pl_gpu.limits.thread_safe`. Otherwise,
 // the user must manually synchronize this to ensure it runs on the correct
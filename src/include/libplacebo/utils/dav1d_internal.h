@@ -504,6 +504,11 @@ static inline bool pl_upload_dav1dpicture(pl_gpu gpu,
         }
     }
 
+    // Make sure the GPU starts working on asynchronous uploads immediately,
+    // overlapping with the decoding of the next picture
+    if (buf || ref)
+        pl_gpu_flush(gpu);
+
     if (params->asynchronous) {
         if (ref) {
             *pic = (Dav1dPicture) {0};
@@ -549,7 +554,9 @@ static inline int pl_allocate_dav1dpicture(Dav1dPicture *p, void *cookie)
     if (total_size > gpu->limits.max_mapped_size)
         return DAV1D_ERR(ENOMEM);
 
-    pl_buf buf = pl_buf_create(gpu, pl_buf_params(
+    // Pictures of the same stream all have the same size, so in steady state
+    // this re-uses the buffers of previously released pictures
+    pl_buf buf = pl_buf_pool_get(gpu, pl_buf_params(
         .size = total_size,
         .host_mapped = true,
         .memory_type = PL_BUF_MEM_HOST,
@@ -560,7 +567,7 @@ static inline int pl_allocate_dav1dpicture(Dav1dPicture *p, void *cookie)
 
     struct pl_dav1dalloc *alloc = malloc(sizeof(struct pl_dav1dalloc));
     if (!alloc) {
-        pl_buf_destroy(gpu, &buf);
+        pl_buf_pool_put(gpu, &buf);
         return DAV1D_ERR(ENOMEM);
     }
 
@@ -592,7 +599,10 @@ static inline void pl_release_dav1dpicture(Dav1dPicture *p, void *cookie)
     assert(alloc->magic[0] == PL_MAGIC0);
     assert(alloc->magic[1] == PL_MAGIC1);
     assert(alloc->gpu == cookie);
-    pl_buf_destroy(alloc->gpu, &alloc->buf);
+
+    // The buffer may still be in use by an upload, but the pool only hands
+    // it out again once the GPU is done with it
+    pl_buf_pool_put(alloc->gpu, &alloc->buf);
     free(alloc);
 
     p->data[0] = p->data[1] = p->data[2] = p->allocator_data = NULL;
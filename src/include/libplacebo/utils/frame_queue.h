@@ -90,6 +90,54 @@ struct pl_source_frame {
 pl_queue pl_queue_create(pl_gpu gpu);
 void pl_queue_destroy(pl_queue *queue);
 
+struct pl_queue_create_params {
+    // If nonzero, frames are mapped ahead of time by a pool of this many
+    // worker threads, rather than on demand from within `pl_queue_update`.
+    // In this case, `pl_source_frame.map` may be called from any of these
+    // threads, and concurrently for different frames. Requires
+    // `pl_gpu_limits.thread_safe`, otherwise ignored.
+    int map_threads;
+
+    // Maximum number of frames, counting from the oldest frame still in use,
+    // which the worker threads map ahead of time. Also raises the number of
+    // frames `pl_queue_push_block` allows queueing in advance. Defaults to
+    // 4 if left as 0.
+    int prefetch_frames;
+
+    // If nonzero, the worker threads stop mapping additional frames once the
+    // total size of the textures held by mapped frames exceeds this many
+    // bytes. (Optional)
+    size_t memory_budget;
+
+    // Textures of frames that are no longer needed are kept in a pool, keyed
+    // on their format, size and usage, and handed to future `map` calls
+    // expecting the same texture parameters as the previously mapped frame.
+    // The least recently used textures are destroyed once the pool holds more
+    // than `texture_pool_size` textures (defaults to 32 if left as 0), or,
+    // if nonzero, more than `texture_pool_budget` bytes.
+    int texture_pool_size;
+    size_t texture_pool_budget;
+};
+
+#define pl_queue_create_params(...) (&(struct pl_queue_create_params) { __VA_ARGS__ })
+
+// Variant of `pl_queue_create` with additional parameters. When asynchronous
+// mapping is enabled, `pl_queue_update` only blocks on frames which are
+// strictly required for the result and not yet mapped. Otherwise, the
+// returned frame mix is cut off before the first frame still being mapped.
+pl_queue pl_queue_create_ex(pl_gpu gpu, const struct pl_queue_create_params *params);
+
+struct pl_queue_pool_stats {
+    uint64_t hits;      // textures reused as-is by `map`
+    uint64_t misses;    // textures which `map` had to (re)create
+    uint64_t evictions; // textures destroyed to stay within the pool limits
+    int num_textures;   // number of textures currently in the pool
+    size_t size;        // total size of these textures, in bytes
+};
+
+// Retrieve statistics about the internal texture pool.
+void pl_queue_pool_stats(pl_queue queue, struct pl_queue_pool_stats *out_stats);
+
 // Explicitly clear the queue. This is essentially equivalent to destroying
 // and recreating the queue, but preserves any internal memory allocations.
 //
@@ -147,6 +147,25 @@ static bool pl_download_avframe(pl_gpu gpu,
                                 const struct pl_frame *frame,
                                 AVFrame *out_frame);
 
+// Asynchronous variant of `pl_download_avframe`. Returns as soon as all
+// downloads have been issued, and calls `done` once `out_frame` contains the
+// complete result. This is subject to the same rules as
+// `pl_tex_transfer_params.callback`. If this function returns false, `done`
+// is never called. Any number of frames may be in flight at the same time.
+//
+// If `out_frame` has no buffers yet (only `format`, `width` and `height`
+// set), they are allocated from persistently mapped buffers taken from the
+// GPU's buffer pool (see `pl_buf_pool_get`), so the GPU can write the result
+// directly into memory which can then be passed on (e.g. to an encoder)
+// without any further copies. Once the last reference to such a frame is
+// dropped, the buffers are returned to the pool for re-use.
+//
+// Note: `out_frame` must not be accessed or freed until `done` is called.
+static bool pl_download_avframe_async(pl_gpu gpu,
+                                      const struct pl_frame *frame,
+                                      AVFrame *out_frame,
+                                      void (*done)(void *priv), void *priv);
+
 // Helper functions to update the colorimetry data in an AVFrame based on
 // the values specified in the given color space / color repr / profile.
 //
@@ -180,6 +199,11 @@ static int pl_plane_data_from_pixfmt(struct pl_plane_data data[4],
 // system memory, especially on platforms that don't support importing
 // PL_HANDLE_HOST_PTR as buffers.
 //
+// Buffers are taken from the GPU's buffer pool (see `pl_buf_pool_get`), and
+// returned to it once the last reference to the frame is dropped. They are
+// only handed out again after any uploads from them have completed, so
+// steady-state decoding does not need to create or map any new buffers.
+//
 // Note: `avctx->opaque` must be a pointer that *points* to the GPU instance.
 // That is, it should have type `pl_gpu *`.
 static int pl_get_buffer2(AVCodecContext *avctx, AVFrame *pic, int flags);
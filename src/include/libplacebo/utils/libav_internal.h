@@ -20,6 +20,7 @@
 #else
 
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <libavutil/hwcontext.h>
 #include <libavutil/hwcontext_drm.h>
@@ -1189,10 +1190,172 @@ static inline void pl_avalloc_free(void *opaque, uint8_t *data)
     assert(alloc->magic[0] == PL_MAGIC0);
     assert(alloc->magic[1] == PL_MAGIC1);
     assert(alloc->buf->data == data);
-    pl_buf_destroy(alloc->gpu, &alloc->buf);
+
+    // The buffer may still be in use by an upload, but the pool only hands
+    // it out again once the GPU is done with it
+    pl_buf_pool_put(alloc->gpu, &alloc->buf);
     free(alloc);
 }
 
+static inline pl_buf pl_avalloc_get_buf(const AVBufferRef *ref)
+{
+    struct pl_avalloc *alloc = ref ? av_buffer_get_opaque(ref) : NULL;
+    if (alloc && alloc->magic[0] == PL_MAGIC0 && alloc->magic[1] == PL_MAGIC1)
+        return alloc->buf;
+    return NULL;
+}
+
+// Allocate the planes of `frame` from mapped buffers in the GPU's buffer pool
+static inline bool pl_avframe_alloc_mapped(pl_gpu gpu, AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    const size_t align = PL_MAX(64, PL_MAX(gpu->limits.align_tex_xfer_pitch,
+                                           gpu->limits.align_tex_xfer_offset));
+    struct pl_avalloc *alloc;
+    int planes;
+
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+        return false;
+    if (!gpu->limits.max_mapped_size || !gpu->limits.buf_transfer)
+        return false;
+    if (av_image_fill_linesizes(frame->linesize, frame->format, frame->width) < 0)
+        return false;
+
+    planes = av_pix_fmt_count_planes(frame->format);
+    for (int p = 0; p < planes; p++) {
+        bool is_chroma = p == 1 || p == 2; // matches lavu logic
+        int height = AV_CEIL_RSHIFT(frame->height, is_chroma ? desc->log2_chroma_h : 0);
+        frame->linesize[p] = PL_ALIGN2(frame->linesize[p], align);
+        const size_t buf_size = (size_t) frame->linesize[p] * height + align;
+        if (buf_size > gpu->limits.max_mapped_size)
+            goto error;
+
+        alloc = malloc(sizeof(*alloc));
+        if (!alloc)
+            goto error;
+
+        *alloc = (struct pl_avalloc) {
+            .magic = { PL_MAGIC0, PL_MAGIC1 },
+            .gpu = gpu,
+            .buf = pl_buf_pool_get(gpu, pl_buf_params(
+                .size = buf_size,
+                .memory_type = PL_BUF_MEM_HOST,
+                .host_mapped = true,
+            )),
+        };
+
+        if (!alloc->buf) {
+            free(alloc);
+            goto error;
+        }
+
+        frame->data[p] = (uint8_t *) PL_ALIGN2((uintptr_t) alloc->buf->data, align);
+        frame->buf[p] = av_buffer_create(alloc->buf->data, buf_size,
+                                         pl_avalloc_free, alloc, 0);
+        if (!frame->buf[p]) {
+            pl_buf_pool_put(gpu, &alloc->buf);
+            free(alloc);
+            goto error;
+        }
+    }
+
+    frame->extended_data = frame->data;
+    return true;
+
+error:
+    for (int p = 0; p < AV_NUM_DATA_POINTERS; p++)
+        av_buffer_unref(&frame->buf[p]);
+    memset(frame->data, 0, sizeof(frame->data));
+    memset(frame->linesize, 0, sizeof(frame->linesize));
+    return false;
+}
+
+struct pl_avdownload {
+    void (*done)(void *priv);
+    void *priv;
+    atomic_int pending; // number of planes still in flight
+};
+
+static void pl_avdownload_cb(void *priv)
+{
+    // Callbacks for different planes may be dispatched from different threads
+    struct pl_avdownload *dl = priv;
+    if (atomic_fetch_sub(&dl->pending, 1) > 1)
+        return;
+
+    if (dl->done)
+        dl->done(dl->priv);
+    free(dl);
+}
+
+static inline bool pl_download_avframe_async(pl_gpu gpu,
+                                             const struct pl_frame *frame,
+                                             AVFrame *out_frame,
+                                             void (*done)(void *priv), void *priv)
+{
+    const bool async = gpu->limits.callbacks;
+    struct pl_tex_transfer_params params[4];
+    struct pl_avdownload *dl;
+
+    if (frame->num_planes != av_pix_fmt_count_planes(out_frame->format))
+        return false;
+
+    if (!out_frame->buf[0] && !pl_avframe_alloc_mapped(gpu, out_frame)) {
+        if (av_frame_get_buffer(out_frame, 0) < 0)
+            return false;
+    }
+
+    dl = malloc(sizeof(*dl));
+    if (!dl)
+        return false;
+
+    dl->done = done;
+    dl->priv = priv;
+    atomic_init(&dl->pending, frame->num_planes);
+
+    for (int p = 0; p < frame->num_planes; p++) {
+        params[p] = (struct pl_tex_transfer_params) {
+            .tex = frame->planes[p].texture,
+            .row_pitch = out_frame->linesize[p],
+            .ptr = out_frame->data[p],
+            .callback = async ? pl_avdownload_cb : NULL,
+            .priv = dl,
+        };
+
+        // Download straight into the mapped buffer, if possible
+        params[p].buf = pl_avalloc_get_buf(out_frame->buf[p]);
+        if (params[p].buf) {
+            params[p].buf_offset = (uintptr_t) params[p].ptr -
+                                   (uintptr_t) params[p].buf->data;
+            params[p].ptr = NULL;
+        }
+    }
+
+    for (int p = 0; p < frame->num_planes; p++) {
+        if (!pl_tex_download(gpu, &params[p])) {
+            // Make sure callbacks of any previously issued downloads have
+            // been dispatched before freeing their state
+            if (async)
+                pl_gpu_finish(gpu);
+            free(dl);
+            return false;
+        }
+    }
+
+    if (!async) {
+        // No way to get notified about completion, so block instead
+        for (int p = 0; p < frame->num_planes; p++) {
+            while (params[p].buf && pl_buf_poll(gpu, params[p].buf, UINT64_MAX))
+                ; // do nothing
+        }
+
+        atomic_store(&dl->pending, 1);
+        pl_avdownload_cb(dl);
+    }
+
+    return true;
+}
+
 static inline int pl_get_buffer2(AVCodecContext *avctx, AVFrame *pic, int flags)
 {
     int alignment[AV_NUM_DATA_POINTERS];
@@ -1260,7 +1423,7 @@ static inline int pl_get_buffer2(AVCodecContext *avctx, AVFrame *pic, int flags)
         *alloc = (struct pl_avalloc) {
             .magic = { PL_MAGIC0, PL_MAGIC1 },
             .gpu = gpu,
-            .buf = pl_buf_create(gpu, pl_buf_params(
+            .buf = pl_buf_pool_get(gpu, pl_buf_params(
                 .size = buf_size,
                 .memory_type = PL_BUF_MEM_HOST,
                 .host_mapped = true,
@@ -1276,7 +1439,7 @@ static inline int pl_get_buffer2(AVCodecContext *avctx, AVFrame *pic, int flags)
         pic->data[p] = (uint8_t *) PL_ALIGN2((uintptr_t) alloc->buf->data, alignment[p]);
         pic->buf[p] = av_buffer_create(alloc->buf->data, buf_size, pl_avalloc_free, alloc, 0);
         if (!pic->buf[p]) {
-            pl_buf_destroy(gpu, &alloc->buf);
+            pl_buf_pool_put(gpu, &alloc->buf);
             free(alloc);
             av_frame_unref(pic);
             return AVERROR(ENOMEM);
@@ -0,0 +1,110 @@
+/*
+ * This file is part of libplacebo.
+ *
+ * libplacebo is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplacebo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplacebo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBPLACEBO_THROUGHPUT_H
+#define LIBPLACEBO_THROUGHPUT_H
+
+#include <libplacebo/renderer.h>
+#include <libplacebo/utils/frame_queue.h>
+
+PL_API_BEGIN
+
+// An abstraction for offline (batch) rendering, e.g. transcoding, where the
+// goal is to maximize the number of frames processed per second rather than
+// to minimize latency. Every submitted frame is mapped, rendered and
+// downloaded back to host memory, while up to `frames_in_flight` frames are
+// kept in flight at the same time, so that mapping/uploading the next frame
+// overlaps with rendering and downloading the previous ones.
+//
+// Thread-safety: Unsafe
+typedef PL_STRUCT(pl_throughput) *pl_throughput;
+
+#define PL_THROUGHPUT_MAX_FRAMES 16
+
+struct pl_throughput_params {
+    // Renderer to use for all frames. (Required)
+    pl_renderer renderer;
+
+    // Render parameters to use for all frames. (Optional)
+    const struct pl_render_params *render_params;
+
+    // Number of frames to keep in flight at the same time. Higher values
+    // increase throughput at the cost of memory usage. Clamped to the range
+    // [1, PL_THROUGHPUT_MAX_FRAMES]. Defaults to 3 if left as 0.
+    int frames_in_flight;
+
+    // Output image format, size and colorimetry. The output is always a single
+    // packed plane, with components in the order given by `format`. The format
+    // must be renderable and host-readable. (Required)
+    pl_fmt format;
+    int width, height;
+    struct pl_color_space color;
+    struct pl_color_repr repr;
+};
+
+#define pl_throughput_params(...) (&(struct pl_throughput_params) { __VA_ARGS__ })
+
+// Returns NULL on failure, e.g. if `format` is not usable for this purpose.
+pl_throughput pl_throughput_create(pl_gpu gpu, const struct pl_throughput_params *params);
+
+// Drains all frames still in flight (see `pl_throughput_drain`) before
+// destroying the object.
+void pl_throughput_destroy(pl_throughput *tp);
+
+struct pl_throughput_frame {
+    // Source frame to render. This uses the same lazy representation as
+    // `pl_queue`: `src.map` is called with a per-slot array of textures which
+    // are recycled for every `frames_in_flight`-th frame, and `src.unmap` (if
+    // present) is called once the frame is no longer in use by the GPU.
+    // `src.pts` and `src.discard` are ignored.
+    struct pl_source_frame src;
+
+    // Destination for the rendered pixels. Must remain valid until `done` is
+    // called. `row_pitch` defaults to the tightly packed row size if left as
+    // 0.
+    void *out_ptr;
+    size_t row_pitch;
+
+    // Called once `out_ptr` has been fully written (`ok == true`), or if
+    // rendering or downloading this frame failed (`ok == false`). This is
+    // subject to the same rules as `pl_tex_transfer_params.callback`, and
+    // will in practice usually be called from within a later
+    // `pl_throughput_submit` or `pl_throughput_drain`. (Optional)
+    void (*done)(void *priv, bool ok);
+    void *priv;
+};
+
+// Submit a frame for rendering. This blocks only if all `frames_in_flight`
+// slots are still in use, in which case it waits for the oldest frame to
+// complete. Returns false if the frame could not be mapped or rendered, in
+// which case `done` is also called with `ok == false`.
+bool pl_throughput_submit(pl_throughput tp, const struct pl_throughput_frame *frame);
+
+// Block until all previously submitted frames have completed.
+void pl_throughput_drain(pl_throughput tp);
+
+struct pl_throughput_stats {
+    uint64_t submitted; // frames successfully submitted
+    uint64_t completed; // frames fully downloaded to `out_ptr`
+    uint64_t failed;    // frames that failed at any stage
+};
+
+void pl_throughput_stats(pl_throughput tp, struct pl_throughput_stats *out_stats);
+
+PL_API_END
+
+#endif // LIBPLACEBO_THROUGHPUT_H
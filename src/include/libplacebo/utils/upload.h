@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 
+#include <libplacebo/dispatch.h>
 #include <libplacebo/gpu.h>
 #include <libplacebo/renderer.h>
 
@@ -124,11 +125,84 @@ pl_fmt pl_plane_find_fmt(pl_gpu gpu, int out_map[4], const struct pl_plane_data
 // and maximize compatibility with the other `pl_renderer` requirements
 // (blittable, linear filterable, etc.).
 //
+// If `pl_plane_find_fmt` finds no matching format, UNORM data provided via
+// `pixels` is instead unpacked on the CPU into the nearest supported format
+// with uniform 8 or 16 bit components (e.g. rgb24 -> rgba8, or packed 10-bit
+// formats -> rgba16), with values rescaled to the new bit depth. This is
+// slower than a direct upload, but allows formats with no GPU equivalent.
+//
 // Note: `out_plane->shift_x/y` and `out_plane->flipped` are left
 // uninitialized, and should be set explicitly by the user.
 bool pl_upload_plane(pl_gpu gpu, struct pl_plane *out_plane,
                      pl_tex *tex, const struct pl_plane_data *data);
 
+// Like `pl_upload_plane`, but for plane data with no matching texture format,
+// the packed data is uploaded as-is and unpacked on the GPU by a compute
+// shader dispatched on `dp`, rather than being repacked on the CPU. The
+// resulting texture is additionally `storable`. This avoids CPU conversion
+// costs for e.g. P010 with arbitrary shifts, or other packed 10-bit formats.
+//
+// If `data->buf` is used, it must be `storable`, and `data->buf_offset` must
+// be a multiple of 4. In this case, `data->callback` fires once the unpacking
+// shader has been dispatched.
+//
+// Falls back to `pl_upload_plane` if no unpacking is required, or if the GPU
+// lacks support for compute shaders, a suitable storable texture format, or
+// large enough storage buffers.
+bool pl_upload_plane_unpack(pl_gpu gpu, pl_dispatch dp, struct pl_plane *out_plane,
+                            pl_tex *tex, const struct pl_plane_data *data);
+
+// Packed layouts which can't be described by `pl_plane_data`, because several
+// pixels (or planes) share the same group of bits.
+enum pl_packed_fmt {
+    PL_PACKED_V210,     // 10-bit 4:2:2, 6 pixels per four 32-bit LE words
+    PL_PACKED_Y210,     // 10-bit 4:2:2, Y0 Cb Y1 Cr as MSB-aligned 16-bit LE words
+    PL_PACKED_BAYER12,  // 12-bit raw mosaic, 2 pixels per 3 bytes (MIPI RAW12)
+    PL_PACKED_FMT_COUNT,
+};
+
+// Description of a packed image in host memory or a buffer
+struct pl_packed_data {
+    enum pl_packed_fmt format;
+    int width, height;      // dimensions of the image (in luma pixels)
+    size_t row_stride;      // offset in bytes between rows (optional)
+
+    // Mutually exclusive, as with `pl_plane_data`. If using `buf`, it must be
+    // `storable`, and `buf_offset` must be a multiple of 4.
+    const void *pixels;
+    pl_buf buf;
+    size_t buf_offset;
+
+    // Fires once the data is no longer needed, as with `pl_plane_data`.
+    void (*callback)(void *priv);
+    void *priv;
+};
+
+// Returns the default `row_stride` for a given packed format and width. Rows
+// of v210 are padded to multiples of 128 bytes, other formats have no padding.
+size_t pl_packed_row_stride(enum pl_packed_fmt format, int width);
+
+// Unpack a packed image into separate 16-bit planes, and output the resulting
+// planes to `out_planes` (optional). `tex` must point to an array of textures
+// (or NULLs), which are recreated as needed, like for `pl_upload_plane`. Both
+// arrays must have room for 3 planes. Returns the number of planes, or 0 on
+// failure.
+//
+// 4:2:2 formats result in a luma plane and two half-width chroma planes. Raw
+// Bayer data results in a single plane containing the mosaic as-is (mapped to
+// `PL_CHANNEL_Y`); demosaicing it is left to the user. Samples are stored
+// MSB-aligned, as described by `out_bits` (optional).
+//
+// Unpacking is done by a compute shader dispatched on `dp`. If `dp` is NULL,
+// or the GPU lacks support for the required compute shaders, the data is
+// unpacked on the CPU instead, which requires `pixels`.
+//
+// Note: `out_planes[i].shift_x/y` and `out_planes[i].flipped` are left
+// uninitialized, and should be set explicitly by the user.
+int pl_upload_packed(pl_gpu gpu, pl_dispatch dp, struct pl_plane out_planes[3],
+                     pl_tex tex[3], struct pl_bit_encoding *out_bits,
+                     const struct pl_packed_data *data);
+
 // Like `pl_upload_plane`, but only creates an uninitialized texture object
 // rather than actually performing an upload. This can be useful to, for
 // example, prepare textures to be used as the target of rendering.
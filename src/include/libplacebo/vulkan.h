@@ -234,6 +234,14 @@ struct pl_vulkan_params {
     // VkPhysicalDeviceVulkan11Features is not allowed.
     const VkPhysicalDeviceFeatures2 *features;
 
+    // Limits the amount of memory libplacebo allocates from each device-local
+    // memory heap, in bytes. If left as 0, the budget is taken from
+    // VK_EXT_memory_budget (when supported), or otherwise the heap size. When
+    // exceeding the budget, libplacebo releases cached resources (such as
+    // intermediate textures and shader passes) instead of failing outright.
+    // See `pl_vulkan_memory_stats`.
+    size_t memory_budget;
+
     // --- Misc/debugging options
 
     // Restrict specific features to e.g. work around driver bugs, or simply
@@ -279,6 +287,35 @@ void pl_vulkan_destroy(pl_vulkan *vk);
 // the underlying `pl_vulkan`. Returns NULL for any other type of `gpu`.
 pl_vulkan pl_vulkan_get(pl_gpu gpu);
 
+struct pl_vulkan_heap_stats {
+    VkMemoryHeapFlags flags;
+    size_t size;        // total size of the heap
+    size_t budget;      // current budget for allocations by libplacebo
+    size_t allocated;   // memory currently allocated by libplacebo
+    size_t used;        // part of `allocated` which is actually in use
+};
+
+struct pl_vulkan_memory_stats {
+    struct pl_vulkan_heap_stats heaps[VK_MAX_MEMORY_HEAPS];
+    int num_heaps;
+
+    // Number of times memory pressure triggered the eviction of cached
+    // resources, either due to exceeding the budget or a failed allocation.
+    uint64_t evictions;
+
+    // Number of allocations relocated out of fragmented memory, and their
+    // total size in bytes. Only textures which were never exported or
+    // wrapped are ever moved.
+    uint64_t defrag_moves;
+    uint64_t defrag_bytes;
+};
+
+// Query the current memory usage and budget of each memory heap. Memory
+// imported from external handles is not included.
+//
+// Thread-safety: Safe
+void pl_vulkan_memory_stats(pl_vulkan vk, struct pl_vulkan_memory_stats *out);
+
 struct pl_vulkan_device_params {
     // The instance to use. Required!
     //
@@ -408,6 +445,9 @@ struct pl_vulkan_import_params {
     void (*unlock_queue)(void *ctx, int qf, int qidx);
     void *queue_ctx;
 
+    // Per-heap memory budget. See `pl_vulkan_params`.
+    size_t memory_budget;
+
     // --- Misc/debugging options
 
     // Restrict specific features to e.g. work around driver bugs, or simply
@@ -22,6 +22,7 @@
 
 typedef pthread_mutex_t pl_mutex;
 typedef pthread_cond_t  pl_cond;
+typedef pthread_t       pl_thread;
 
 enum pl_mutex_type {
     PL_MUTEX_NORMAL = 0,
@@ -106,3 +107,9 @@ static inline int pl_cond_timedwait(pl_cond *cond, pl_mutex *mutex, uint64_t tim
 
     return pthread_cond_timedwait(cond, mutex, &ts);
 }
+
+#define PL_THREAD_VOID void *
+#define PL_THREAD_RETURN() return NULL
+
+#define pl_thread_create(t, f, a) pthread_create(t, NULL, f, a)
+#define pl_thread_join(t)         pthread_join(t, NULL)
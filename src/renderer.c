@@ -51,6 +51,27 @@ struct icc_state {
     bool error;
 };
 
+// Decisions made by `pass_init` for a given combination of frame metadata and
+// render params, which can be replayed as-is for subsequent frames that share
+// the same signature (the common case for video playback).
+struct render_plan {
+    uint64_t signature; // 0 = unused
+
+    // Corrected/inferred frame metadata
+    struct pl_color_repr image_repr, target_repr;
+    struct pl_color_space image_color, target_color;
+    struct pl_rect2df image_crop, target_crop;
+
+    // Derived pass state
+    struct pl_rect2df ref_rect;
+    struct pl_rect2d dst_rect;
+    pl_rotation rotation;
+    int src_ref, dst_ref;
+    pl_fmt fbofmt[5];
+};
+
+#define MAX_PLANS 4
+
 struct pl_renderer {
     pl_gpu gpu;
     pl_dispatch dp;
@@ -73,12 +94,17 @@ struct pl_renderer {
     pl_shader_obj grain_state[4];
     pl_shader_obj lut_state[3];
     PL_ARRAY(pl_tex) fbos;
+    pl_tex tile_fbos[PL_MAX_PLANES];
     struct sampler sampler_main;
     struct sampler samplers_src[4];
     struct sampler samplers_dst[4];
     bool peak_detect_active;
     struct icc_state icc[2];
 
+    // Cached render plans, replaced round-robin
+    struct render_plan plans[MAX_PLANS];
+    int plan_idx;
+
     // Temporary storage for vertex/index data
     PL_ARRAY(struct osd_vertex) osd_vertices;
     PL_ARRAY(uint16_t) osd_indices;
@@ -87,6 +113,9 @@ struct pl_renderer {
     // Frame cache (for frame mixing / interpolation)
     PL_ARRAY(struct cached_frame) frames;
     PL_ARRAY(pl_tex) frame_fbos;
+
+    // Set on memory pressure, see `pl_gpu_evict`
+    atomic_bool evict;
 };
 
 enum {
@@ -96,6 +125,12 @@ enum {
     LUT_PARAMS,
 };
 
+static void renderer_evict_cb(void *priv)
+{
+    pl_renderer rr = priv;
+    atomic_store(&rr->evict, true);
+}
+
 pl_renderer pl_renderer_create(pl_log log, pl_gpu gpu)
 {
     pl_renderer rr = pl_alloc_ptr(NULL, rr);
@@ -121,6 +156,8 @@ pl_renderer pl_renderer_create(pl_log log, pl_gpu gpu)
     };
 
     assert(rr->dp);
+    atomic_init(&rr->evict, false);
+    pl_gpu_evict_register(gpu, renderer_evict_cb, rr);
     return rr;
 }
 
@@ -136,6 +173,8 @@ void pl_renderer_destroy(pl_renderer *p_rr)
     if (!rr)
         return;
 
+    pl_gpu_evict_unregister(rr->gpu, renderer_evict_cb, rr);
+
     // Free all intermediate FBOs
     for (int i = 0; i < rr->fbos.num; i++)
         pl_tex_destroy(rr->gpu, &rr->fbos.elem[i]);
@@ -143,6 +182,8 @@ void pl_renderer_destroy(pl_renderer *p_rr)
         pl_tex_destroy(rr->gpu, &rr->frames.elem[i].tex);
     for (int i = 0; i < rr->frame_fbos.num; i++)
         pl_tex_destroy(rr->gpu, &rr->frame_fbos.elem[i]);
+    for (int i = 0; i < PL_ARRAY_SIZE(rr->tile_fbos); i++)
+        pl_tex_destroy(rr->gpu, &rr->tile_fbos[i]);
 
     // Free all shader resource objects
     pl_shader_obj_destroy(&rr->tone_map_state);
@@ -187,6 +228,40 @@ void pl_renderer_flush_cache(pl_renderer rr)
 
     pl_reset_detected_peak(rr->tone_map_state);
     rr->peak_detect_active = false;
+
+    memset(rr->plans, 0, sizeof(rr->plans));
+}
+
+// Releases all resources that are only kept around for caching purposes, i.e.
+// the FBO pool, the frame mixing cache and any LUTs. These are transparently
+// re-created as needed.
+static void evict_caches(pl_renderer rr)
+{
+    if (!atomic_exchange(&rr->evict, false))
+        return;
+
+    PL_DEBUG(rr, "Evicting cached resources due to memory pressure");
+    for (int i = 0; i < rr->fbos.num; i++)
+        pl_tex_destroy(rr->gpu, &rr->fbos.elem[i]);
+    rr->fbos.num = 0;
+    for (int i = 0; i < rr->frame_fbos.num; i++)
+        pl_tex_destroy(rr->gpu, &rr->frame_fbos.elem[i]);
+    rr->frame_fbos.num = 0;
+    for (int i = 0; i < PL_ARRAY_SIZE(rr->tile_fbos); i++)
+        pl_tex_destroy(rr->gpu, &rr->tile_fbos[i]);
+    for (int i = 0; i < rr->frames.num; i++)
+        pl_tex_destroy(rr->gpu, &rr->frames.elem[i].tex);
+    rr->frames.num = 0;
+
+    for (int i = 0; i < PL_ARRAY_SIZE(rr->lut_state); i++)
+        pl_shader_obj_destroy(&rr->lut_state[i]);
+    for (int i = 0; i < PL_ARRAY_SIZE(rr->icc); i++)
+        pl_shader_obj_destroy(&rr->icc[i].lut);
+}
+
+bool pl_renderer_get_peak_stats(pl_renderer rr, struct pl_peak_detect_stats *out)
+{
+    return pl_get_detected_stats(rr->tone_map_state, out);
 }
 
 const struct pl_render_params pl_render_fast_params = { PL_RENDER_DEFAULTS };
@@ -362,6 +437,10 @@ struct pass_state {
     pl_fmt fbofmt[5];
     bool *fbos_used;
 
+    // Set for individual tiles of a tiled render, in which case peak
+    // detection was already performed for the frame as a whole. Tiles also
+    // bypass the render plan cache, since every tile has different crops.
+    bool tile;
 };
 
 static void find_fbo_format(struct pass_state *pass)
@@ -477,7 +556,7 @@ static pl_tex get_fbo(struct pass_state *pass, int w, int h, pl_fmt fmt,
         pass->fbos_used[best_idx] = false;
     }
 
-    if (!pl_tex_recreate(rr->gpu, &rr->fbos.elem[best_idx], &params))
+    if (!pl_tex_recreate_internal(rr->gpu, &rr->fbos.elem[best_idx], &params))
         return NULL;
 
     pass->fbos_used[best_idx] = true;
@@ -1186,24 +1265,38 @@ static int deband_src(struct pass_state *pass, pl_shader psh,
     return DEBAND_NORMAL;
 }
 
-static void hdr_update_peak(struct pass_state *pass)
+// Whether peak detection is needed for a source image of color space `csp`
+static bool want_peak_detect(const struct pass_state *pass,
+                             const struct pl_color_space *csp)
 {
     const struct pl_render_params *params = pass->params;
-    pl_renderer rr = pass->rr;
-    if (!params->peak_detect_params || !pl_color_space_is_hdr(&pass->img.color))
-        goto cleanup;
+    if (!params->peak_detect_params || !pl_color_space_is_hdr(csp))
+        return false;
 
-    if (rr->disable_peak_detect)
-        goto cleanup;
+    if (pass->rr->disable_peak_detect)
+        return false;
 
     if (pass->fbofmt[4] && !(pass->fbofmt[4]->caps & PL_FMT_CAP_STORABLE))
-        goto cleanup;
+        return false;
 
-    if (pass->img.color.hdr.max_luma <= pass->target.color.hdr.max_luma + 1e-6)
-        goto cleanup; // no adaptation needed
+    if (csp->hdr.max_luma <= pass->target.color.hdr.max_luma + 1e-6)
+        return false; // no adaptation needed
 
     if (params->lut && params->lut_type == PL_LUT_CONVERSION)
-        goto cleanup; // LUT handles tone mapping
+        return false; // LUT handles tone mapping
+
+    return true;
+}
+
+static void hdr_update_peak(struct pass_state *pass)
+{
+    const struct pl_render_params *params = pass->params;
+    pl_renderer rr = pass->rr;
+    if (pass->tile)
+        return; // re-use the result from the whole-frame pass
+
+    if (!want_peak_detect(pass, &pass->img.color))
+        goto cleanup;
 
     if (!pass->fbofmt[4] && !params->allow_delayed_peak_detect) {
         PL_WARN(rr, "Disabling peak detection because "
@@ -2482,6 +2575,98 @@ done:
     return state;
 }
 
+static void hash_frame_meta(uint64_t *hash, const struct pl_frame *frame)
+{
+    pl_hash_merge(hash, frame->num_planes);
+    for (int i = 0; i < frame->num_planes; i++) {
+        const struct pl_plane *plane = &frame->planes[i];
+        const struct pl_tex_params *tpars = &plane->texture->params;
+        pl_hash_merge(hash, (uintptr_t) tpars->format);
+        pl_hash_merge(hash, ((uint64_t) tpars->w << 32) | tpars->h);
+        pl_hash_merge(hash, plane->components);
+        pl_hash_merge(hash, pl_mem_hash(plane->component_mapping,
+                                        sizeof(plane->component_mapping)));
+    }
+
+    pl_hash_merge(hash, pl_mem_hash(&frame->repr, sizeof(frame->repr)));
+    pl_hash_merge(hash, pl_mem_hash(&frame->color, sizeof(frame->color)));
+    pl_hash_merge(hash, pl_mem_hash(&frame->crop, sizeof(frame->crop)));
+    pl_hash_merge(hash, frame->rotation);
+    pl_hash_merge(hash, frame->profile.signature);
+}
+
+// Computes the signature of everything that `pass_init` bases its decisions
+// on. Must be called after acquiring (and validating) the frames.
+static uint64_t plan_signature(const struct pass_state *pass, bool acquire_image)
+{
+    const struct pl_render_params *params = pass->params;
+    uint64_t hash = 0x1234;
+
+    pl_hash_merge(&hash, acquire_image);
+    pl_hash_merge(&hash, pass->src_ref < 0);
+    if (pass->src_ref >= 0)
+        hash_frame_meta(&hash, &pass->image);
+    hash_frame_meta(&hash, &pass->target);
+
+    pl_hash_merge(&hash, params->disable_fbos);
+    pl_hash_merge(&hash, params->force_low_bit_depth_fbos);
+    pl_hash_merge(&hash, pass->rr->disable_fbos);
+    if (params->icc_params)
+        pl_hash_merge(&hash, pl_mem_hash(params->icc_params, sizeof(*params->icc_params)));
+
+    return PL_DEF(hash, 1); // 0 is reserved for unused plans
+}
+
+static const struct render_plan *find_plan(pl_renderer rr, uint64_t signature)
+{
+    for (int i = 0; i < MAX_PLANS; i++) {
+        if (rr->plans[i].signature == signature)
+            return &rr->plans[i];
+    }
+
+    return NULL;
+}
+
+static void replay_plan(struct pass_state *pass, const struct render_plan *plan)
+{
+    pass->image.repr = plan->image_repr;
+    pass->image.color = plan->image_color;
+    pass->image.crop = plan->image_crop;
+    pass->target.repr = plan->target_repr;
+    pass->target.color = plan->target_color;
+    pass->target.crop = plan->target_crop;
+    pass->ref_rect = plan->ref_rect;
+    pass->dst_rect = plan->dst_rect;
+    pass->rotation = plan->rotation;
+    pass->src_ref = plan->src_ref;
+    pass->dst_ref = plan->dst_ref;
+    memcpy(pass->fbofmt, plan->fbofmt, sizeof(pass->fbofmt));
+}
+
+static void save_plan(struct pass_state *pass, uint64_t signature)
+{
+    pl_renderer rr = pass->rr;
+    struct render_plan *plan = &rr->plans[rr->plan_idx];
+    rr->plan_idx = (rr->plan_idx + 1) % MAX_PLANS;
+
+    *plan = (struct render_plan) {
+        .signature = signature,
+        .image_repr = pass->image.repr,
+        .image_color = pass->image.color,
+        .image_crop = pass->image.crop,
+        .target_repr = pass->target.repr,
+        .target_color = pass->target.color,
+        .target_crop = pass->target.crop,
+        .ref_rect = pass->ref_rect,
+        .dst_rect = pass->dst_rect,
+        .rotation = pass->rotation,
+        .src_ref = pass->src_ref,
+        .dst_ref = pass->dst_ref,
+    };
+
+    memcpy(plan->fbofmt, pass->fbofmt, sizeof(plan->fbofmt));
+}
+
 static bool pass_init(struct pass_state *pass, bool acquire_image)
 {
     pl_renderer rr = pass->rr;
@@ -2495,6 +2680,14 @@ static bool pass_init(struct pass_state *pass, bool acquire_image)
     if (!validate_structs(pass->rr, acquire_image ? image : NULL, target))
         goto error;
 
+    // Skip re-deriving all of the below if nothing relevant changed
+    uint64_t signature = plan_signature(pass, acquire_image);
+    const struct render_plan *plan = pass->tile ? NULL : find_plan(rr, signature);
+    if (plan) {
+        replay_plan(pass, plan);
+        goto update_icc;
+    }
+
     fix_refs_and_rects(pass);
     find_fbo_format(pass);
 
@@ -2533,7 +2726,12 @@ static bool pass_init(struct pass_state *pass, bool acquire_image)
         }
     }
 
-    // Update ICC profiles
+    if (!pass->tile)
+        save_plan(pass, signature);
+
+    // Update ICC profiles. This is not part of the plan, because the ICC
+    // state is shared between all plans (and cheap to re-check).
+update_icc:
     pass->src_icc = acquire_image ? update_icc(pass, &rr->icc[0], image) : NULL;
     pass->dst_icc = update_icc(pass, &rr->icc[1], target);
 
@@ -2612,12 +2810,258 @@ static bool draw_empty_overlays(pl_renderer rr,
     return true;
 }
 
+static bool can_render_tiled(const struct pass_state *pass)
+{
+    const struct pl_render_params *params = pass->params;
+    const struct pl_frame *image = &pass->image;
+    const struct pl_frame *target = &pass->target;
+    pl_renderer rr = pass->rr;
+
+    const struct pl_rect2d *dst = &pass->dst_rect;
+    if (pl_rect_w(*dst) <= params->render_tile_size &&
+        pl_rect_h(*dst) <= params->render_tile_size)
+        return false; // fits into a single tile
+
+    if (pass->rotation || dst->x0 > dst->x1 || dst->y0 > dst->y1) {
+        PL_DEBUG(rr, "Tiled rendering does not support rotated or flipped "
+                 "frames, rendering in one pass");
+        return false;
+    }
+
+    if (image->num_overlays || target->num_overlays) {
+        PL_DEBUG(rr, "Tiled rendering does not support overlays, rendering "
+                 "in one pass");
+        return false;
+    }
+
+    for (int i = 0; i < target->num_planes; i++) {
+        pl_tex tex = target->planes[i].texture;
+        if (!tex->params.blit_dst || !(tex->params.format->caps & PL_FMT_CAP_BLITTABLE)) {
+            PL_DEBUG(rr, "Tiled rendering requires blittable target planes, "
+                     "rendering in one pass");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static float filter_radius(const struct pl_filter_config *cfg)
+{
+    if (!cfg || !cfg->kernel)
+        return 1.0; // built-in sampling
+    return cfg->kernel->radius * PL_DEF(cfg->blur, 1.0);
+}
+
+// Returns the number of extra pixels (in target coordinates) that need to be
+// rendered around each tile for the result to be independent of the tile
+// boundaries. User hooks can sample arbitrarily far, and are not accounted for.
+static int tile_border(const struct pass_state *pass)
+{
+    const struct pl_render_params *params = pass->params;
+    const struct pl_rect2df *src = &pass->image.crop;
+    const struct pl_rect2d *dst = &pass->dst_rect;
+    float scale = PL_MAX(pl_rect_w(*dst) / pl_rect_w(*src),
+                         pl_rect_h(*dst) / pl_rect_h(*src));
+
+    // Radius of operations performed in source space. The upscaler is counted
+    // twice to account for the upscaling of subsampled chroma planes, plus
+    // some slack for bilinear sampling and plane merging.
+    float src_radius = 2.0 + 2 * filter_radius(params->upscaler);
+    if (params->deband_params) {
+        const struct pl_deband_params *deband = params->deband_params;
+        src_radius += PL_DEF(deband->radius, 16.0) * PL_MAX(deband->iterations, 1);
+    }
+
+    // Anti-aliased downscaling operates in target space instead
+    float dst_radius = 2.0 + filter_radius(params->downscaler);
+    return ceilf(src_radius * scale + dst_radius);
+}
+
+// Renders the frame as a sequence of independent tiles, each with an extra
+// border of `tile_border` pixels, which is cut off again when copying the
+// result into the target. Consumes `pass`.
+static bool pass_render_tiled(struct pass_state *pass)
+{
+    const struct pl_render_params *params = pass->params;
+    const struct pl_frame *image = &pass->image;
+    const struct pl_frame *target = &pass->target;
+    pl_renderer rr = pass->rr;
+    pl_gpu gpu = rr->gpu;
+
+    const struct pl_rect2df *src = &image->crop;
+    const struct pl_rect2d *dst = &pass->dst_rect;
+    pl_tex ref = target->planes[pass->dst_ref].texture;
+
+    int border = tile_border(pass);
+    int tile_size = params->render_tile_size;
+    tile_size = PL_MIN(tile_size, gpu->limits.max_tex_2d_dim - 2 * border);
+    if (tile_size <= 0) {
+        PL_ERR(rr, "Tile border (%d) exceeds texture size limits!", border);
+        goto error;
+    }
+
+    int fbo_w = PL_MIN(tile_size + 2 * border, pl_rect_w(*dst)),
+        fbo_h = PL_MIN(tile_size + 2 * border, pl_rect_h(*dst));
+    PL_TRACE(rr, "Rendering %dx%d target in tiles of %dx%d (border %d)",
+             pl_rect_w(*dst), pl_rect_h(*dst), tile_size, tile_size, border);
+
+    for (int p = 0; p < target->num_planes; p++) {
+        pl_tex tex = target->planes[p].texture;
+        float rx = (float) tex->params.w / ref->params.w,
+              ry = (float) tex->params.h / ref->params.h;
+
+        bool ok = pl_tex_recreate_internal(gpu, &rr->tile_fbos[p], pl_tex_params(
+            .w = ceilf(fbo_w * rx),
+            .h = ceilf(fbo_h * ry),
+            .format = tex->params.format,
+            .sampleable = tex->params.sampleable,
+            .renderable = tex->params.renderable,
+            .storable = tex->params.storable,
+            .blit_src = true,
+            .debug_tag = PL_DEBUG_TAG,
+        ));
+
+        if (!ok) {
+            PL_ERR(rr, "Failed creating tile FBO for plane %d", p);
+            goto error;
+        }
+    }
+
+    // Global state needs to be computed over the frame as a whole, so
+    // perform peak detection up-front on the (source-sized) decoded image.
+    // Skip this entirely for images that don't need it, since reading the
+    // full image defeats the point of tiling.
+    pass_begin_frame(pass);
+    if (gpu->glsl.compute && want_peak_detect(pass, &image->color)) {
+        if (!pass_read_image(pass))
+            goto error;
+
+        if (rr->peak_detect_active) {
+            img_sh(pass, &pass->img);
+            bool ok = pl_dispatch_compute(rr->dp, pl_dispatch_compute_params(
+                .shader = &pass->img.sh,
+                .width  = pass->img.w,
+                .height = pass->img.h,
+            ));
+
+            if (!ok) {
+                PL_ERR(rr, "Failed dispatching peak detection shader!");
+                goto error;
+            }
+        }
+    } else {
+        pl_reset_detected_peak(rr->tone_map_state);
+        rr->peak_detect_active = false;
+    }
+
+    if (!params->skip_target_clearing && pl_frame_is_cropped(target))
+        pl_frame_clear_rgba(gpu, target, CLEAR_COL(params));
+
+    struct pl_render_params tile_params = *params;
+    tile_params.skip_target_clearing = true;
+
+    float scale_x = pl_rect_w(*src) / pl_rect_w(*dst),
+          scale_y = pl_rect_h(*src) / pl_rect_h(*dst);
+
+    for (int y = dst->y0; y < dst->y1; y += tile_size) {
+        for (int x = dst->x0; x < dst->x1; x += tile_size) {
+            const struct pl_rect2d tile = {
+                .x0 = x,
+                .y0 = y,
+                .x1 = PL_MIN(x + tile_size, dst->x1),
+                .y1 = PL_MIN(y + tile_size, dst->y1),
+            };
+
+            // Only extend the tile towards other tiles, so the frame edges
+            // are handled exactly like when rendering in one pass
+            const struct pl_rect2d ext = {
+                .x0 = PL_MAX(tile.x0 - border, dst->x0),
+                .y0 = PL_MAX(tile.y0 - border, dst->y0),
+                .x1 = PL_MIN(tile.x1 + border, dst->x1),
+                .y1 = PL_MIN(tile.y1 + border, dst->y1),
+            };
+
+            struct pass_state tpass = {
+                .rr = rr,
+                .params = &tile_params,
+                .image = *image,
+                .target = *target,
+                .info.stage = PL_RENDER_STAGE_FRAME,
+                .tile = true,
+            };
+
+            // Both frames remain acquired by `pass` for the whole duration
+            tpass.image.acquire = tpass.target.acquire = NULL;
+            tpass.image.release = tpass.target.release = NULL;
+            tpass.image.crop = (struct pl_rect2df) {
+                .x0 = src->x0 + (ext.x0 - dst->x0) * scale_x,
+                .y0 = src->y0 + (ext.y0 - dst->y0) * scale_y,
+                .x1 = src->x0 + (ext.x1 - dst->x0) * scale_x,
+                .y1 = src->y0 + (ext.y1 - dst->y0) * scale_y,
+            };
+
+            tpass.target.crop = (struct pl_rect2df) {
+                0, 0, pl_rect_w(ext), pl_rect_h(ext),
+            };
+            for (int p = 0; p < target->num_planes; p++)
+                tpass.target.planes[p].texture = rr->tile_fbos[p];
+
+            if (!pass_init(&tpass, true))
+                goto error;
+
+            pass_begin_frame(&tpass);
+            bool ok = pass_read_image(&tpass) &&
+                      pass_scale_main(&tpass) &&
+                      pass_output_target(&tpass);
+            pass_uninit(&tpass);
+            if (!ok)
+                goto error;
+
+            // Copy the tile (minus its border) into place
+            for (int p = 0; p < target->num_planes; p++) {
+                pl_tex tex = target->planes[p].texture;
+                float rx = (float) tex->params.w / ref->params.w,
+                      ry = (float) tex->params.h / ref->params.h;
+
+                pl_tex_blit(gpu, pl_tex_blit_params(
+                    .src = rr->tile_fbos[p],
+                    .dst = tex,
+                    .src_rc = {
+                        .x0 = roundf((tile.x0 - ext.x0) * rx),
+                        .y0 = roundf((tile.y0 - ext.y0) * ry),
+                        .x1 = roundf((tile.x1 - ext.x0) * rx),
+                        .y1 = roundf((tile.y1 - ext.y0) * ry),
+                        .z1 = 1,
+                    },
+                    .dst_rc = {
+                        .x0 = roundf(tile.x0 * rx),
+                        .y0 = roundf(tile.y0 * ry),
+                        .x1 = roundf(tile.x1 * rx),
+                        .y1 = roundf(tile.y1 * ry),
+                        .z1 = 1,
+                    },
+                ));
+            }
+        }
+    }
+
+    pass_uninit(pass);
+    return true;
+
+error:
+    PL_ERR(rr, "Failed rendering image!");
+    pass_uninit(pass);
+    return false;
+}
+
 bool pl_render_image(pl_renderer rr, const struct pl_frame *pimage,
                      const struct pl_frame *ptarget,
                      const struct pl_render_params *params)
 {
     params = PL_DEF(params, &pl_render_default_params);
     pl_dispatch_mark_dynamic(rr->dp, params->dynamic_constants);
+    evict_caches(rr);
     if (!pimage)
         return draw_empty_overlays(rr, ptarget, params);
 
@@ -2632,6 +3076,9 @@ bool pl_render_image(pl_renderer rr, const struct pl_frame *pimage,
     if (!pass_init(&pass, true))
         return false;
 
+    if (params->render_tile_size > 0 && can_render_tiled(&pass))
+        return pass_render_tiled(&pass);
+
     pass_begin_frame(&pass);
     if (!pass_read_image(&pass))
         goto error;
@@ -2726,6 +3173,7 @@ static struct params_info render_params_info(const struct pl_render_params *para
     CLEAR(params.blend_against_tiles);
     memset(params.tile_colors, 0, sizeof(params.tile_colors));
     CLEAR(params.tile_size);
+    CLEAR(params.render_tile_size);
 
     // Clear out fields only relevant to pass_output_target
     CLEAR(params.blend_params);
@@ -2759,6 +3207,7 @@ bool pl_render_image_mix(pl_renderer rr, const struct pl_frame_mix *images,
     params = PL_DEF(params, &pl_render_default_params);
     struct params_info par_info = render_params_info(params);
     pl_dispatch_mark_dynamic(rr->dp, params->dynamic_constants);
+    evict_caches(rr);
 
     require(images->num_frames >= 1);
     for (int i = 0; i < images->num_frames - 1; i++)
@@ -2932,7 +3381,7 @@ bool pl_render_image_mix(pl_renderer rr, const struct pl_frame_mix *images,
                     pl_tex_invalidate(rr->gpu, f->tex);
             }
 
-            bool ok = pl_tex_recreate(rr->gpu, &f->tex, pl_tex_params(
+            bool ok = pl_tex_recreate_internal(rr->gpu, &f->tex, pl_tex_params(
                 .w = out_w,
                 .h = out_h,
                 .format = pass.fbofmt[4],
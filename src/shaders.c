@@ -1010,7 +1010,7 @@ next_dim: ; // `continue` out of the inner loop
 
             bool ok;
             if (params->dynamic) {
-                ok = pl_tex_recreate(gpu, &lut->tex, &tex_params);
+                ok = pl_tex_recreate_internal(gpu, &lut->tex, &tex_params);
                 if (ok) {
                     ok = pl_tex_upload(gpu, pl_tex_transfer_params(
                         .tex = lut->tex,
@@ -1020,7 +1020,7 @@ next_dim: ; // `continue` out of the inner loop
             } else {
                 // Can't use pl_tex_recreate because of `initial_data`
                 pl_tex_destroy(gpu, &lut->tex);
-                lut->tex = pl_tex_create(gpu, &tex_params);
+                lut->tex = pl_tex_create_internal(gpu, &tex_params);
                 ok = lut->tex;
             }
 
@@ -914,6 +914,12 @@ void pl_shader_unsigmoidize(pl_shader sh, const struct pl_sigmoid_params *params
 
 const struct pl_peak_detect_params pl_peak_detect_default_params = { PL_PEAK_DETECT_DEFAULTS };
 
+struct peak_readback {
+    pl_buf buf;
+    uint64_t seq;   // order in which the copies into `buf` were recorded
+    bool pending;   // contains results not yet returned to the user
+};
+
 struct sh_tone_map_obj {
     struct pl_tone_map_params params;
     pl_shader_obj lut;
@@ -921,17 +927,74 @@ struct sh_tone_map_obj {
     // Peak detection state
     pl_buf peak_buf;
     struct pl_shader_desc desc;
+    struct pl_var_layout current, current_frame, histogram;
     float margin;
+    bool has_histogram;
+
+    // Asynchronous readback state
+    struct peak_readback readback[PL_PEAK_DETECT_MAX_READBACK];
+    uint64_t frames;     // number of peak detection shaders generated
+    uint64_t copies;     // number of readback copies recorded
+    uint32_t last_frame; // frame number of the last returned result
 };
 
+static void peak_detect_reset(pl_gpu gpu, struct sh_tone_map_obj *obj)
+{
+    pl_buf_destroy(gpu, &obj->peak_buf);
+    for (int i = 0; i < PL_ARRAY_SIZE(obj->readback); i++)
+        pl_buf_destroy(gpu, &obj->readback[i].buf);
+    memset(obj->readback, 0, sizeof(obj->readback));
+    obj->frames = obj->copies = 0;
+    obj->last_frame = 0;
+}
+
 static void sh_tone_map_uninit(pl_gpu gpu, void *ptr)
 {
     struct sh_tone_map_obj *obj = ptr;
     pl_shader_obj_destroy(&obj->lut);
-    pl_buf_destroy(gpu, &obj->peak_buf);
+    peak_detect_reset(gpu, obj);
     memset(obj, 0, sizeof(*obj));
 }
 
+// Copies the results of the previously dispatched peak detection shader into
+// the next readback buffer in the ring. Since this is ordered before the
+// dispatch of the shader currently being generated, no further
+// synchronization is required. The results are tagged with their frame number
+// by the GPU, so a copy of stale data (e.g. if the previous shader was never
+// dispatched) can be detected when reading it back.
+static void peak_detect_readback(pl_gpu gpu, struct sh_tone_map_obj *obj,
+                                 int num_bufs)
+{
+    if (!obj->frames)
+        return; // nothing dispatched yet
+
+    num_bufs = PL_CLAMP(num_bufs, 1, PL_PEAK_DETECT_MAX_READBACK);
+    struct peak_readback *rb = &obj->readback[obj->copies % num_bufs];
+    if (rb->buf && pl_buf_poll(gpu, rb->buf, 0)) {
+        // The GPU is lagging behind the ring, skip this frame's results
+        // rather than stalling on the readback buffer
+        PL_TRACE(gpu, "Peak detection readback buffer still in use, skipping");
+        return;
+    }
+
+    size_t size = obj->peak_buf->params.size;
+    bool ok = pl_buf_recreate(gpu, &rb->buf, pl_buf_params(
+        .size = size,
+        .host_readable = true,
+        .debug_tag = PL_DEBUG_TAG,
+    ));
+
+    if (!ok) {
+        PL_ERR(gpu, "Failed creating peak detection readback buffer");
+        rb->pending = false;
+        return;
+    }
+
+    pl_buf_copy(gpu, rb->buf, 0, obj->peak_buf, 0, size);
+    rb->seq = obj->copies++;
+    rb->pending = true;
+}
+
 static inline float iir_coeff(float rate)
 {
     float a = 1.0 - cos(1.0 / rate);
@@ -946,7 +1009,12 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
     if (!sh_require(sh, PL_SHADER_SIG_COLOR, 0, 0))
         return false;
 
-    if (!sh_try_compute(sh, 8, 8, true, 2 * sizeof(int32_t))) {
+    const bool use_hist = params->readback_frames > 0;
+    size_t shmem_req = 2 * sizeof(int32_t);
+    if (use_hist)
+        shmem_req += PL_PEAK_HISTOGRAM_BINS * sizeof(uint32_t);
+
+    if (!sh_try_compute(sh, 8, 8, true, shmem_req)) {
         PL_ERR(sh, "HDR peak detection requires compute shaders!");
         return false;
     }
@@ -966,6 +1034,10 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
     pl_gpu gpu = SH_GPU(sh);
     obj->margin = params->overshoot_margin;
 
+    // The buffer layout depends on whether or not the histogram is enabled
+    if (obj->peak_buf && obj->has_histogram != use_hist)
+        peak_detect_reset(gpu, obj);
+
     if (!obj->peak_buf) {
         obj->desc = (struct pl_shader_desc) {
             .desc = {
@@ -982,6 +1054,18 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
         ok &= sh_buf_desc_append(obj, gpu, &obj->desc, NULL, pl_var_int("frame_max"));
         ok &= sh_buf_desc_append(obj, gpu, &obj->desc, NULL, pl_var_uint("counter"));
 
+        if (use_hist) {
+            struct pl_var hist = pl_var_uint("frame_hist");
+            hist.dim_a = PL_PEAK_HISTOGRAM_BINS;
+            ok &= sh_buf_desc_append(obj, gpu, &obj->desc, NULL, hist);
+            ok &= sh_buf_desc_append(obj, gpu, &obj->desc, &obj->current,
+                                     pl_var_vec2("current"));
+            ok &= sh_buf_desc_append(obj, gpu, &obj->desc, &obj->current_frame,
+                                     pl_var_uint("current_frame"));
+            hist.name = "histogram";
+            ok &= sh_buf_desc_append(obj, gpu, &obj->desc, &obj->histogram, hist);
+        }
+
         if (!ok) {
             PL_ERR(sh, "HDR peak detection exhausts device limits!");
             return false;
@@ -989,8 +1073,7 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
 
         // Create the SSBO
         size_t size = sh_buf_desc_size(&obj->desc);
-        static const uint8_t zero[32] = {0};
-        pl_assert(sizeof(zero) >= size);
+        void *zero = pl_zalloc(NULL, size);
         struct pl_buf_params buf_params = {
             .size = size,
             .host_readable = true,
@@ -1011,7 +1094,9 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
             obj->peak_buf = pl_buf_create(gpu, &buf_params);
         }
 
+        pl_free(zero);
         obj->desc.binding.object = obj->peak_buf;
+        obj->has_histogram = use_hist;
     }
 
     if (!obj->peak_buf) {
@@ -1019,6 +1104,10 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
         return false;
     }
 
+    if (use_hist)
+        peak_detect_readback(gpu, obj, params->readback_frames);
+    obj->frames++;
+
     // Attach the SSBO and perform the peak detection logic
     obj->desc.desc.access = PL_DESC_ACCESS_READWRITE;
     obj->desc.memory = PL_MEMORY_COHERENT;
@@ -1036,14 +1125,22 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
     // For performance, we want to do as few atomic operations on global
     // memory as possible, so use an atomic in shmem for the work group.
     ident_t wg_sum = sh_fresh(sh, "wg_sum"), wg_max = sh_fresh(sh, "wg_max");
+    ident_t wg_hist = NULL;
     GLSLH("shared int %s;   \n", wg_sum);
     GLSLH("shared int %s;   \n", wg_max);
-    GLSL("%s = 0; %s = 0;   \n"
-         "barrier();        \n",
-         wg_sum, wg_max);
+    GLSL("%s = 0; %s = 0;   \n", wg_sum, wg_max);
+    if (use_hist) {
+        wg_hist = sh_fresh(sh, "wg_hist");
+        GLSLH("shared uint %s[%d]; \n", wg_hist, PL_PEAK_HISTOGRAM_BINS);
+        GLSL("for (uint i = gl_LocalInvocationIndex; i < %du;               \n"
+             "     i += gl_WorkGroupSize.x * gl_WorkGroupSize.y)             \n"
+             "    %s[i] = 0u;                                                \n",
+             PL_PEAK_HISTOGRAM_BINS, wg_hist);
+    }
+    GLSL("barrier(); \n");
 
     // Chosen to avoid overflowing on an 8K buffer
-    const float log_min = 1e-3, log_scale = 400.0, sig_scale = 10000.0;
+    const float log_min = PL_PEAK_HISTOGRAM_MIN, log_scale = 400.0, sig_scale = 10000.0;
 
     GLSL("float sig_max = max(max(color.r, color.g), color.b);  \n"
          "float sig_log = log(max(sig_max, %f));                \n"
@@ -1051,6 +1148,15 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
          "int isig_log = int(sig_log * %f);                     \n",
          log_min, sig_scale, log_scale);
 
+    if (use_hist) {
+        const float hist_scale = PL_PEAK_HISTOGRAM_BINS /
+                    logf(PL_PEAK_HISTOGRAM_MAX / PL_PEAK_HISTOGRAM_MIN);
+        GLSL("int hist_bin = int((sig_log - %s) * %s);      \n"
+             "atomicAdd(%s[clamp(hist_bin, 0, %d)], 1u);    \n",
+             SH_FLOAT(logf(log_min)), SH_FLOAT(hist_scale),
+             wg_hist, PL_PEAK_HISTOGRAM_BINS - 1);
+    }
+
     // Update the work group's shared atomics
     if (sh_glsl(sh).subgroup_size) {
         GLSL("int group_max = subgroupMax(isig_max);    \n"
@@ -1074,6 +1180,18 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
     // Have one thread per work group update the global atomics. Do this
     // at the end of the shader to avoid clobbering `average`, in case the
     // state object will be used by the same pass.
+    if (use_hist) {
+        GLSLF("// pl_shader_detect_peak                                     \n"
+              "for (uint i = gl_LocalInvocationIndex; i < %du;             \n"
+              "     i += gl_WorkGroupSize.x * gl_WorkGroupSize.y)           \n"
+              "{                                                            \n"
+              "    if (%s[i] > 0u)                                          \n"
+              "        atomicAdd(frame_hist[i], %s[i]);                     \n"
+              "}                                                            \n"
+              "memoryBarrierBuffer();                                       \n",
+              PL_PEAK_HISTOGRAM_BINS, wg_hist, wg_hist);
+    }
+
     GLSLF("// pl_shader_detect_peak                                             \n"
           "if (gl_LocalInvocationIndex == 0u) {                                 \n"
           "    int wg_avg = %s / int(gl_WorkGroupSize.x * gl_WorkGroupSize.y);  \n"
@@ -1111,6 +1229,21 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
               SH_FLOAT(params->scene_threshold_high / log_db));
     }
 
+    // Publish the raw values and histogram for asynchronous readback
+    if (use_hist) {
+        ident_t frame_num = sh_var(sh, (struct pl_shader_var) {
+            .var = pl_var_uint("frame_num"),
+            .data = &(unsigned) { (uint32_t) obj->frames },
+            .dynamic = true,
+        });
+
+        GLSLF("        current = cur;                                       \n"
+              "        current_frame = %s;                                  \n"
+              "        for (uint i = 0u; i < %du; i++)                      \n"
+              "            histogram[i] = atomicExchange(frame_hist[i], 0u);\n",
+              frame_num, PL_PEAK_HISTOGRAM_BINS);
+    }
+
     // Reset SSBO state for the next frame
     GLSLF("        frame_sum = 0;            \n"
           "        frame_max = 0;            \n"
@@ -1179,13 +1312,78 @@ bool pl_get_detected_peak(const pl_shader_obj state,
     return true;
 }
 
+bool pl_get_detected_stats(const pl_shader_obj state,
+                           struct pl_peak_detect_stats *out)
+{
+    if (!state || state->type != PL_SHADER_OBJ_TONE_MAP)
+        return false;
+
+    struct sh_tone_map_obj *obj = state->priv;
+    pl_gpu gpu = state->gpu;
+    if (!obj->peak_buf || !obj->has_histogram)
+        return false;
+
+    // Find the most recent result that the GPU is done writing to
+    struct peak_readback *best = NULL;
+    for (int i = 0; i < PL_ARRAY_SIZE(obj->readback); i++) {
+        struct peak_readback *rb = &obj->readback[i];
+        if (!rb->pending || pl_buf_poll(gpu, rb->buf, 0))
+            continue;
+        if (!best || rb->seq > best->seq)
+            best = rb;
+    }
+
+    if (!best)
+        return false;
+
+    size_t size = best->buf->params.size;
+    uint8_t *data = pl_alloc(NULL, size);
+    if (!pl_buf_read(gpu, best->buf, 0, data, size)) {
+        PL_ERR(gpu, "Failed reading from peak detection readback buffer");
+        pl_free(data);
+        return false;
+    }
+
+    // Discard this and all older copies
+    for (int i = 0; i < PL_ARRAY_SIZE(obj->readback); i++) {
+        if (obj->readback[i].seq <= best->seq)
+            obj->readback[i].pending = false;
+    }
+
+    float average[2], current[2];
+    uint32_t frame;
+    memcpy(average, data, sizeof(average));
+    memcpy(current, data + obj->current.offset, sizeof(current));
+    memcpy(&frame, data + obj->current_frame.offset, sizeof(frame));
+    memcpy(out->histogram, data + obj->histogram.offset, sizeof(out->histogram));
+    pl_free(data);
+
+    // Frame number 0 means no shader was dispatched before this copy, and a
+    // repeated frame number means the shader in between was never dispatched
+    if (!frame || frame == obj->last_frame)
+        return false;
+    obj->last_frame = frame;
+
+    out->avg = average[0];
+    out->peak = average[1];
+    out->frame_avg = current[0];
+    out->frame_peak = current[1];
+    out->latency = (uint32_t) obj->frames - frame;
+    if (obj->margin > 0.0) {
+        out->peak *= 1.0 + obj->margin;
+        out->peak = PL_MIN(out->peak, 10000 / PL_COLOR_SDR_WHITE);
+    }
+
+    return true;
+}
+
 void pl_reset_detected_peak(pl_shader_obj state)
 {
     if (!state || state->type != PL_SHADER_OBJ_TONE_MAP)
         return;
 
     struct sh_tone_map_obj *obj = state->priv;
-    pl_buf_destroy(state->gpu, &obj->peak_buf);
+    peak_detect_reset(state->gpu, obj);
 }
 
 const struct pl_color_map_params pl_color_map_default_params = { PL_COLOR_MAP_DEFAULTS };
@@ -1,10 +1,14 @@
 #include "tests.h"
+#include "pl_thread.h"
+#include "vulkan/common.h"
+#include <stdatomic.h>
 #include <sys/time.h>
 
 #define TEX_SIZE 2048
 #define CUBE_SIZE 64
 #define NUM_FBOS 16
 #define BENCH_DUR 3
+#define MAX_THREADS 8
 
 static pl_tex create_test_img(pl_gpu gpu)
 {
@@ -156,6 +160,248 @@ static void benchmark(pl_gpu gpu, const char *name,
         pl_tex_destroy(gpu, &fbos[i]);
 }
 
+// Multi-threaded rendering: every thread gets its own `pl_renderer` and
+// target, but all of them share the same `pl_gpu` and source texture
+struct render_thread {
+    pl_gpu gpu;
+    pl_renderer rr;
+    pl_tex src;
+    pl_tex fbo;
+    unsigned long frames;
+    bool failed;
+};
+
+static bool render_frame(pl_renderer rr, pl_tex src, pl_tex fbo,
+                         const struct pl_render_params *params)
+{
+    struct pl_frame image = {
+        .num_planes     = 1,
+        .planes         = {{
+            .texture            = src,
+            .components         = 3,
+            .component_mapping  = {0, 1, 2},
+        }},
+        .repr           = pl_color_repr_rgb,
+        .color          = pl_color_space_srgb,
+    };
+
+    struct pl_frame target = {
+        .num_planes     = 1,
+        .planes         = {{
+            .texture            = fbo,
+            .components         = 3,
+            .component_mapping  = {0, 1, 2},
+        }},
+        .repr           = pl_color_repr_rgb,
+        .color          = pl_color_space_srgb,
+    };
+
+    return pl_render_image(rr, &image, &target, params);
+}
+
+static bool render_thread_frame(struct render_thread *t)
+{
+    return render_frame(t->rr, t->src, t->fbo, &pl_render_high_quality_params);
+}
+
+static PL_THREAD_VOID render_thread_run(void *priv)
+{
+    struct render_thread *t = priv;
+    struct timeval start = {0}, now = {0};
+
+    gettimeofday(&start, NULL);
+    do {
+        if (!render_thread_frame(t)) {
+            t->failed = true;
+            break;
+        }
+
+        if (++t->frames % NUM_FBOS == 0)
+            pl_gpu_flush(t->gpu);
+        gettimeofday(&now, NULL);
+    } while (now.tv_sec - start.tv_sec < BENCH_DUR);
+
+    PL_THREAD_RETURN();
+}
+
+static void benchmark_threads(pl_gpu gpu, int num_threads)
+{
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    pl_tex src = create_test_img(gpu);
+    struct render_thread threads[MAX_THREADS] = {0};
+    pl_thread handles[MAX_THREADS];
+    pl_assert(num_threads <= MAX_THREADS);
+
+    for (int i = 0; i < num_threads; i++) {
+        struct render_thread *t = &threads[i];
+        t->gpu = gpu;
+        t->src = src;
+        t->rr = pl_renderer_create(gpu->log, gpu);
+        t->fbo = pl_tex_create(gpu, pl_tex_params(
+            .format     = fmt,
+            .w          = TEX_SIZE / 2,
+            .h          = TEX_SIZE / 2,
+            .renderable = true,
+        ));
+        REQUIRE(t->rr && t->fbo);
+
+        // Render once and block to force shader compilation etc.
+        REQUIRE(render_thread_frame(t));
+    }
+    pl_gpu_finish(gpu);
+
+    struct timeval start = {0}, stop = {0};
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < num_threads; i++)
+        REQUIRE(pl_thread_create(&handles[i], render_thread_run, &threads[i]) == 0);
+    for (int i = 0; i < num_threads; i++)
+        pl_thread_join(handles[i]);
+    pl_gpu_finish(gpu);
+    gettimeofday(&stop, NULL);
+
+    unsigned long frames = 0;
+    for (int i = 0; i < num_threads; i++) {
+        REQUIRE(!threads[i].failed);
+        frames += threads[i].frames;
+    }
+
+    float secs = (float) (stop.tv_sec - start.tv_sec) +
+                 1e-6 * (stop.tv_usec - start.tv_usec);
+    printf("'renderer x%d':\t%4lu frames in %1.6f seconds => %2.6f ms/frame "
+           "(%5.2f FPS, %5.2f FPS/thread)\n", num_threads, frames, secs,
+           1000 * secs / frames, frames / secs, frames / secs / num_threads);
+
+    for (int i = 0; i < num_threads; i++) {
+        pl_renderer_destroy(&threads[i].rr);
+        pl_tex_destroy(gpu, &threads[i].fbo);
+    }
+    pl_tex_destroy(gpu, &src);
+}
+
+// Frame queue contention between a decoder thread pushing frames at 240 fps
+// and a render thread updating the queue at 144 Hz, both running unthrottled
+struct queue_producer {
+    pl_queue queue;
+    atomic_bool stop;
+    unsigned long frames;
+    double max_push;
+};
+
+static inline double time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static bool queue_map(pl_gpu gpu, pl_tex *tex, const struct pl_source_frame *src,
+                      struct pl_frame *out_frame)
+{
+    *out_frame = (struct pl_frame) {0};
+    return true;
+}
+
+static PL_THREAD_VOID queue_producer_run(void *priv)
+{
+    struct queue_producer *prod = priv;
+    while (!atomic_load(&prod->stop)) {
+        struct pl_source_frame src = {
+            .pts = prod->frames / 240.0,
+            .map = queue_map,
+        };
+
+        double start = time_us();
+        if (pl_queue_push_block(prod->queue, 1000000, &src)) // 1 ms
+            prod->frames++;
+        prod->max_push = PL_MAX(prod->max_push, time_us() - start);
+    }
+
+    pl_queue_push(prod->queue, NULL);
+    PL_THREAD_RETURN();
+}
+
+static void benchmark_queue_contention(pl_gpu gpu)
+{
+    struct queue_producer prod = { .queue = pl_queue_create(gpu) };
+    atomic_init(&prod.stop, false);
+
+    struct pl_queue_params qparams = {
+        .vsync_duration = 1.0 / 144.0,
+        .frame_duration = 1.0 / 240.0,
+        .timeout = 1000000, // 1 ms
+    };
+
+    pl_thread thread;
+    REQUIRE(pl_thread_create(&thread, queue_producer_run, &prod) == 0);
+
+    unsigned long updates = 0;
+    double max_update = 0.0, total_update = 0.0;
+    double start = time_us();
+    while (time_us() - start < BENCH_DUR * 1e6) {
+        struct pl_frame_mix mix;
+        double before = time_us();
+        enum pl_queue_status ret = pl_queue_update(prod.queue, &mix, &qparams);
+        double elapsed = time_us() - before;
+        REQUIRE(ret != PL_QUEUE_ERR && ret != PL_QUEUE_EOF);
+        if (ret != PL_QUEUE_OK)
+            continue;
+
+        max_update = PL_MAX(max_update, elapsed);
+        total_update += elapsed;
+        qparams.pts += qparams.vsync_duration;
+        updates++;
+    }
+
+    atomic_store(&prod.stop, true);
+    pl_thread_join(thread);
+
+    printf("'queue contention':\t%4lu updates, %4lu frames pushed => "
+           "update %2.3f us avg, %2.3f us max, push %2.3f us max\n",
+           updates, prod.frames, total_update / PL_MAX(updates, 1),
+           max_update, prod.max_push);
+
+    pl_queue_destroy(&prod.queue);
+}
+
+#define QUEUE_FPS     1000.0
+#define QUEUE_UPDATES 20000
+
+// Measures `pl_queue_update` for a high frame rate source at various queue
+// depths, e.g. due to frames being queued far in advance
+static void benchmark_queue_depth(pl_gpu gpu, int depth)
+{
+    pl_queue queue = pl_queue_create(gpu);
+    struct pl_queue_params qparams = {
+        .radius = 2.0,
+        .vsync_duration = 1.0 / 144.0,
+        .frame_duration = 1.0 / QUEUE_FPS,
+    };
+
+    unsigned long pushed = 0;
+    double total = 0.0;
+    for (int n = 0; n < QUEUE_UPDATES; n++) {
+        // Keep `depth` frames ahead of the current PTS
+        while (pushed < qparams.pts * QUEUE_FPS + depth) {
+            pl_queue_push(queue, &(struct pl_source_frame) {
+                .pts = pushed++ / QUEUE_FPS,
+                .map = queue_map,
+            });
+        }
+
+        struct pl_frame_mix mix;
+        double before = time_us();
+        REQUIRE(pl_queue_update(queue, &mix, &qparams) == PL_QUEUE_OK);
+        total += time_us() - before;
+        qparams.pts += qparams.vsync_duration;
+    }
+
+    printf("'queue depth %d':\t%d updates => %2.3f us/update\n",
+           depth, QUEUE_UPDATES, total / QUEUE_UPDATES);
+    pl_queue_destroy(&queue);
+}
+
 // List of benchmarks
 static void bench_deband(pl_shader sh, pl_shader_obj *state, pl_tex src)
 {
@@ -388,6 +634,480 @@ static void bench_upload_async(pl_gpu gpu, pl_tex tex)
     ));
 }
 
+// End-to-end offline rendering: upload -> render -> download
+#define E2E_SRC_W 1920
+#define E2E_SRC_H 1080
+#define E2E_DST_W 1280
+#define E2E_DST_H 720
+
+static bool e2e_map(pl_gpu gpu, pl_tex *tex, const struct pl_source_frame *src,
+                    struct pl_frame *out_frame)
+{
+    struct pl_plane_data data = {
+        .type           = PL_FMT_UNORM,
+        .width          = E2E_SRC_W,
+        .height         = E2E_SRC_H,
+        .component_size = {8, 8, 8, 8},
+        .component_map  = {0, 1, 2, 3},
+        .pixel_stride   = 4,
+        .pixels         = src->frame_data,
+    };
+
+    *out_frame = (struct pl_frame) {
+        .num_planes = 1,
+        .repr       = pl_color_repr_rgb,
+        .color      = pl_color_space_bt709,
+    };
+
+    return pl_upload_plane(gpu, &out_frame->planes[0], &tex[0], &data);
+}
+
+static void benchmark_throughput(pl_gpu gpu, int frames_in_flight)
+{
+    pl_fmt fmt = pl_find_named_fmt(gpu, "rgba8");
+    if (!fmt || !(fmt->caps & PL_FMT_CAP_HOST_READABLE))
+        return;
+
+    const size_t out_size = E2E_DST_W * E2E_DST_H * 4;
+    uint8_t *src = malloc(E2E_SRC_W * E2E_SRC_H * 4);
+    uint8_t *dst = malloc(frames_in_flight * out_size);
+    REQUIRE(src && dst);
+    for (int i = 0; i < E2E_SRC_W * E2E_SRC_H * 4; i++)
+        src[i] = i * 7;
+
+    pl_renderer rr = pl_renderer_create(gpu->log, gpu);
+    pl_throughput tp = pl_throughput_create(gpu, pl_throughput_params(
+        .renderer           = rr,
+        .render_params      = &pl_render_default_params,
+        .frames_in_flight   = frames_in_flight,
+        .format             = fmt,
+        .width              = E2E_DST_W,
+        .height             = E2E_DST_H,
+        .color              = pl_color_space_bt709,
+        .repr               = pl_color_repr_rgb,
+    ));
+    REQUIRE(rr && tp);
+
+    struct pl_throughput_frame frame = {
+        .src = {
+            .frame_data = src,
+            .map        = e2e_map,
+        },
+    };
+
+    // Warm up once to force shader compilation etc.
+    frame.out_ptr = dst;
+    REQUIRE(pl_throughput_submit(tp, &frame));
+    pl_throughput_drain(tp);
+
+    struct timeval start = {0}, stop = {0};
+    unsigned long frames = 0;
+    gettimeofday(&start, NULL);
+    do {
+        frame.out_ptr = dst + (frames % frames_in_flight) * out_size;
+        REQUIRE(pl_throughput_submit(tp, &frame));
+        frames++;
+        gettimeofday(&stop, NULL);
+    } while (stop.tv_sec - start.tv_sec < BENCH_DUR);
+
+    pl_throughput_drain(tp);
+    gettimeofday(&stop, NULL);
+
+    struct pl_throughput_stats stats;
+    pl_throughput_stats(tp, &stats);
+    REQUIRE(stats.completed == frames + 1 && !stats.failed);
+
+    float secs = (float) (stop.tv_sec - start.tv_sec) +
+                 1e-6 * (stop.tv_usec - start.tv_usec);
+    printf("'throughput x%d':\t%4lu frames in %1.6f seconds => %2.6f ms/frame "
+           "(%5.2f FPS)\n", frames_in_flight, frames, secs,
+           1000 * secs / frames, frames / secs);
+
+    pl_throughput_destroy(&tp);
+    pl_renderer_destroy(&rr);
+    free(src);
+    free(dst);
+}
+
+// Streaming uploads of 4K 10-bit 4:2:0 (P010) frames, to exercise the upload
+// ring under sustained load
+#define STREAM_W 3840
+#define STREAM_H 2160
+
+static void benchmark_upload_stream(pl_gpu gpu, bool async)
+{
+    const size_t luma_size = STREAM_W * STREAM_H * sizeof(uint16_t);
+    uint16_t *src = malloc(luma_size + luma_size / 2);
+    REQUIRE(src);
+    for (size_t i = 0; i < (luma_size + luma_size / 2) / sizeof(uint16_t); i++)
+        src[i] = (i * 7) << 6;
+
+    struct pl_plane_data planes[2] = {
+        {
+            .type           = PL_FMT_UNORM,
+            .width          = STREAM_W,
+            .height         = STREAM_H,
+            .component_size = {16},
+            .component_map  = {0},
+            .pixel_stride   = sizeof(uint16_t),
+            .pixels         = src,
+        }, {
+            .type           = PL_FMT_UNORM,
+            .width          = STREAM_W / 2,
+            .height         = STREAM_H / 2,
+            .component_size = {16, 16},
+            .component_map  = {1, 2},
+            .pixel_stride   = 2 * sizeof(uint16_t),
+            .pixels         = (uint8_t *) src + luma_size,
+        },
+    };
+
+    if (async) {
+        for (int i = 0; i < PL_ARRAY_SIZE(planes); i++) {
+            planes[i].callback = dummy_cb;
+            planes[i].priv = NULL;
+        }
+    }
+
+    pl_tex tex[2] = {0};
+    struct pl_gpu_upload_stats before, after;
+    pl_gpu_upload_stats(gpu, &before);
+
+    struct timeval start = {0}, stop = {0};
+    unsigned long frames = 0;
+    gettimeofday(&start, NULL);
+    do {
+        for (int i = 0; i < PL_ARRAY_SIZE(planes); i++)
+            REQUIRE(pl_upload_plane(gpu, NULL, &tex[i], &planes[i]));
+        frames++;
+        gettimeofday(&stop, NULL);
+    } while (stop.tv_sec - start.tv_sec < BENCH_DUR);
+
+    pl_gpu_finish(gpu);
+    gettimeofday(&stop, NULL);
+    pl_gpu_upload_stats(gpu, &after);
+
+    float secs = (float) (stop.tv_sec - start.tv_sec) +
+                 1e-6 * (stop.tv_usec - start.tv_usec);
+    double bytes = (double) frames * (luma_size + luma_size / 2);
+    printf("'upload_stream 4K p010%s':\t%4lu frames in %1.6f seconds => "
+           "%2.6f ms/frame (%5.2f FPS, %5.2f GB/s)\n", async ? " async" : "",
+           frames, secs, 1000 * secs / frames, frames / secs, bytes / secs / 1e9);
+    printf("    ring: %zu/%zu KiB peak, %"PRIu64" uploads, %"PRIu64" stalls, "
+           "%"PRIu64" fallbacks\n", after.ring_peak >> 10, after.ring_size >> 10,
+           after.uploads - before.uploads, after.stalls - before.stalls,
+           after.fallbacks - before.fallbacks);
+
+    for (int i = 0; i < PL_ARRAY_SIZE(tex); i++)
+        pl_tex_destroy(gpu, &tex[i]);
+    free(src);
+}
+
+// Replays a synthetic trace of texture allocations, modelled after the
+// intermediate textures of a renderer juggling a mix of 4K, 1080p and
+// smaller streams, to exercise the memory allocator
+#define TRACE_LIVE 64
+#define TRACE_OPS  20000
+
+static void benchmark_alloc_trace(pl_gpu gpu)
+{
+    static const struct { int w, h, comps, depth; } sizes[] = {
+        { 3840, 2160, 4, 16 }, { 3840, 2160, 1, 16 }, { 1920, 1080, 2, 16 },
+        { 1920, 1080, 4, 16 }, { 1920, 1080, 1,  8 }, { 1280,  720, 4,  8 },
+        {  960,  540, 2,  8 }, {  640,  360, 4, 16 }, {  256,  256, 4, 16 },
+        {  128,   64, 1, 32 },
+    };
+
+    pl_tex live[TRACE_LIVE] = {0};
+    uint32_t state = 0x12345678;
+    unsigned long creates = 0, destroys = 0;
+    double total = 0.0;
+
+    for (int n = 0; n < TRACE_OPS; n++) {
+        state = state * 1664525 + 1013904223; // LCG, for reproducibility
+        pl_tex *tex = &live[(state >> 8) % TRACE_LIVE];
+        double before = time_us();
+        if (*tex) {
+            pl_tex_destroy(gpu, tex);
+            destroys++;
+        } else {
+            int idx = (state >> 20) % PL_ARRAY_SIZE(sizes);
+            pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, sizes[idx].comps,
+                                     sizes[idx].depth, sizes[idx].depth,
+                                     PL_FMT_CAP_SAMPLEABLE | PL_FMT_CAP_RENDERABLE);
+            if (!fmt)
+                fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, sizes[idx].comps, 16, 16,
+                                  PL_FMT_CAP_SAMPLEABLE | PL_FMT_CAP_RENDERABLE);
+            REQUIRE(fmt);
+            *tex = pl_tex_create(gpu, pl_tex_params(
+                .format     = fmt,
+                .w          = sizes[idx].w,
+                .h          = sizes[idx].h,
+                .sampleable = true,
+                .renderable = true,
+            ));
+            REQUIRE(*tex);
+            creates++;
+        }
+        total += time_us() - before;
+
+        // Simulate frame boundaries, which also garbage collects slabs
+        if (n % TRACE_LIVE == TRACE_LIVE - 1)
+            pl_gpu_flush(gpu);
+    }
+
+    printf("'alloc trace':\t%4lu creates, %4lu destroys => %2.3f us/op\n",
+           creates, destroys, total / TRACE_OPS);
+
+    for (int i = 0; i < TRACE_LIVE; i++)
+        pl_tex_destroy(gpu, &live[i]);
+    pl_gpu_finish(gpu);
+}
+
+// Many small passes per frame, as is typical for e.g. a renderer with many
+// intermediate stages, to measure command submission overhead
+#define SUBMIT_PASSES 32
+#define SUBMIT_SIZE   64
+
+static void benchmark_submit(pl_vulkan pl_vk)
+{
+    pl_gpu gpu = pl_vk->gpu;
+    struct vk_ctx *vk = PL_PRIV(pl_vk);
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    pl_tex fbo = pl_tex_create(gpu, pl_tex_params(
+        .format     = fmt,
+        .w          = SUBMIT_SIZE,
+        .h          = SUBMIT_SIZE,
+        .renderable = true,
+        .storable   = !!(fmt->caps & PL_FMT_CAP_STORABLE),
+    ));
+    REQUIRE(fbo);
+
+    pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+    unsigned long frames = 0;
+    uint64_t submits = vk->num_submits, cmds = vk->num_cmds_submitted;
+    double total = 0.0, start = time_us();
+    while (time_us() - start < BENCH_DUR * 1e6) {
+        double before = time_us();
+        for (int i = 0; i < SUBMIT_PASSES; i++) {
+            pl_shader sh = pl_dispatch_begin(dp);
+            REQUIRE(pl_shader_custom(sh, &(struct pl_custom_shader) {
+                .body   = "color = vec4(0.5);",
+                .output = PL_SHADER_SIG_COLOR,
+            }));
+            REQUIRE(pl_dispatch_finish(dp, pl_dispatch_params(
+                .shader = &sh,
+                .target = fbo,
+            )));
+        }
+        pl_gpu_flush(gpu);
+        total += time_us() - before;
+        frames++;
+
+        // Throttle to avoid measuring the GPU instead
+        if (frames % 4 == 0)
+            pl_gpu_finish(gpu);
+    }
+
+    pl_gpu_finish(gpu);
+    submits = vk->num_submits - submits;
+    cmds = vk->num_cmds_submitted - cmds;
+    printf("'submit x%d':\t%4lu frames => %2.3f us/frame, "
+           "%2.2f cmds/frame in %2.2f submits/frame\n", SUBMIT_PASSES, frames,
+           total / PL_MAX(frames, 1), (double) cmds / PL_MAX(frames, 1),
+           (double) submits / PL_MAX(frames, 1));
+
+    pl_dispatch_destroy(&dp);
+    pl_tex_destroy(gpu, &fbo);
+}
+
+// Independent compute work (peak detection) interleaved with rendering, to
+// compare frame times with and without a separate async compute queue
+static void benchmark_async_compute(pl_log log, bool async)
+{
+    pl_vulkan vk = pl_vulkan_create(log, pl_vulkan_params(
+        .allow_software = true,
+        .async_transfer = false,
+        .async_compute  = async,
+    ));
+    if (!vk)
+        return;
+
+    pl_gpu gpu = vk->gpu;
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, 4, 16, 32,
+                             PL_FMT_CAP_RENDERABLE | PL_FMT_CAP_STORABLE);
+    if (!gpu->glsl.compute || !fmt) {
+        pl_vulkan_destroy(&vk);
+        return;
+    }
+
+    pl_tex src = create_test_img(gpu);
+    pl_tex fbos[2] = {0};
+    for (int i = 0; i < PL_ARRAY_SIZE(fbos); i++) {
+        fbos[i] = pl_tex_create(gpu, pl_tex_params(
+            .format     = fmt,
+            .w          = TEX_SIZE,
+            .h          = TEX_SIZE,
+            .renderable = true,
+            .storable   = true,
+        ));
+        REQUIRE(fbos[i]);
+    }
+
+    pl_dispatch dp = pl_dispatch_create(log, gpu);
+    pl_shader_obj state = NULL;
+    unsigned long frames = 0;
+    double start = 0.0;
+    for (;;) {
+        pl_shader sh = pl_dispatch_begin(dp);
+        bench_deband_heavy(sh, NULL, src);
+        REQUIRE(pl_dispatch_finish(dp, pl_dispatch_params(
+            .shader = &sh,
+            .target = fbos[0],
+        )));
+
+        sh = pl_dispatch_begin(dp);
+        bench_hdr_peak(sh, &state, src);
+        REQUIRE(pl_dispatch_finish(dp, pl_dispatch_params(
+            .shader = &sh,
+            .target = fbos[1],
+        )));
+
+        pl_gpu_flush(gpu);
+        if (!start) {
+            // Flush+block once to force shader compilation etc.
+            pl_gpu_finish(gpu);
+            start = time_us();
+            continue;
+        }
+
+        // Keep a few frames in flight, like a real renderer would
+        if (++frames % 4 == 0) {
+            pl_gpu_finish(gpu);
+            if (time_us() - start >= BENCH_DUR * 1e6)
+                break;
+        }
+    }
+
+    double elapsed = time_us() - start;
+    printf("'async compute %s':\t%4lu frames => %2.3f ms/frame "
+           "(%d compute queue(s))\n", async ? "on" : "off", frames,
+           elapsed / (1000 * frames), (int) gpu->limits.compute_queues);
+
+    pl_shader_obj_destroy(&state);
+    pl_dispatch_destroy(&dp);
+    for (int i = 0; i < PL_ARRAY_SIZE(fbos); i++)
+        pl_tex_destroy(gpu, &fbos[i]);
+    pl_tex_destroy(gpu, &src);
+    pl_vulkan_destroy(&vk);
+}
+
+// Time-to-first-frame for a fresh device, which is dominated by shader and
+// pipeline compilation, compared against the steady state frame time.
+// Note: Driver-side shader caches may hide some of the cost for all but the
+// first run.
+static void benchmark_startup(pl_log log, const char *name,
+                              const struct pl_render_params *params)
+{
+    pl_vulkan vk = pl_vulkan_create(log, pl_vulkan_params(
+        .allow_software = true,
+        .async_transfer = false,
+    ));
+    if (!vk)
+        return;
+
+    bool gpl = false;
+    for (int i = 0; i < vk->num_extensions; i++)
+        gpl |= strcmp(vk->extensions[i], "VK_EXT_graphics_pipeline_library") == 0;
+
+    pl_gpu gpu = vk->gpu;
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    pl_tex src = create_test_img(gpu);
+    pl_tex fbo = pl_tex_create(gpu, pl_tex_params(
+        .format     = fmt,
+        .w          = TEX_SIZE / 2,
+        .h          = TEX_SIZE / 2,
+        .renderable = true,
+    ));
+    pl_renderer rr = pl_renderer_create(log, gpu);
+    REQUIRE(fbo && rr);
+    pl_gpu_finish(gpu);
+
+    double start = time_us();
+    REQUIRE(render_frame(rr, src, fbo, params));
+    pl_gpu_finish(gpu);
+    double first = time_us() - start;
+
+    const int frames = NUM_FBOS;
+    start = time_us();
+    for (int i = 0; i < frames; i++)
+        REQUIRE(render_frame(rr, src, fbo, params));
+    pl_gpu_finish(gpu);
+    double steady = (time_us() - start) / frames;
+
+    printf("'startup %s':\tfirst frame %8.3f ms, steady %2.3f ms/frame "
+           "=> ~%8.3f ms creating pipelines (GPL %s)\n", name, first / 1000,
+           steady / 1000, PL_MAX(first - steady, 0.0) / 1000,
+           gpl ? "on" : "off");
+
+    pl_renderer_destroy(&rr);
+    pl_tex_destroy(gpu, &fbo);
+    pl_tex_destroy(gpu, &src);
+    pl_vulkan_destroy(&vk);
+}
+
+// Pipeline barriers recorded per rendered frame
+static void benchmark_barriers(pl_vulkan pl_vk)
+{
+    pl_gpu gpu = pl_vk->gpu;
+    struct vk_ctx *vk = PL_PRIV(pl_vk);
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    pl_tex src = create_test_img(gpu);
+    pl_tex fbo = pl_tex_create(gpu, pl_tex_params(
+        .format     = fmt,
+        .w          = TEX_SIZE / 2,
+        .h          = TEX_SIZE / 2,
+        .renderable = true,
+    ));
+    pl_renderer rr = pl_renderer_create(gpu->log, gpu);
+    REQUIRE(fbo && rr);
+
+    // Render once and block to force shader compilation etc.
+    REQUIRE(render_frame(rr, src, fbo, &pl_render_high_quality_params));
+    pl_gpu_finish(gpu);
+
+    unsigned long frames = 0;
+    struct vk_barrier_stats before = vk->barrier_stats;
+    double start = time_us();
+    while (time_us() - start < BENCH_DUR * 1e6) {
+        REQUIRE(render_frame(rr, src, fbo, &pl_render_high_quality_params));
+        if (++frames % 4 == 0)
+            pl_gpu_finish(gpu);
+    }
+    pl_gpu_finish(gpu);
+
+    double elapsed = time_us() - start;
+    struct vk_barrier_stats after = vk->barrier_stats;
+    double n = PL_MAX(frames, 1);
+    printf("'barriers':\t%4lu frames => %2.3f ms/frame, per frame: "
+           "%2.2f requested, %2.2f elided, %2.2f emitted in %2.2f calls\n",
+           frames, elapsed / (1000 * n),
+           (after.requested - before.requested) / n,
+           (after.elided - before.elided) / n,
+           (after.emitted - before.emitted) / n,
+           (after.calls - before.calls) / n);
+
+    pl_renderer_destroy(&rr);
+    pl_tex_destroy(gpu, &fbo);
+    pl_tex_destroy(gpu, &src);
+}
+
 int main()
 {
     setbuf(stdout, NULL);
@@ -415,6 +1135,9 @@ int main()
     benchmark(vk->gpu, "tex_download ptr async", BENCH_TEX(bench_download_async));
     benchmark(vk->gpu, "tex_upload ptr", BENCH_TEX(bench_upload));
     benchmark(vk->gpu, "tex_upload ptr async", BENCH_TEX(bench_upload_async));
+    benchmark_upload_stream(vk->gpu, false);
+    benchmark_upload_stream(vk->gpu, true);
+    benchmark_alloc_trace(vk->gpu);
     benchmark(vk->gpu, "bilinear", BENCH_SH(bench_bilinear));
     benchmark(vk->gpu, "bicubic", BENCH_SH(bench_bicubic));
     benchmark(vk->gpu, "deband", BENCH_SH(bench_deband));
@@ -445,6 +1168,36 @@ int main()
     benchmark(vk->gpu, "reshape_poly", BENCH_SH(bench_reshape_poly));
     benchmark(vk->gpu, "reshape_mmr", BENCH_SH(bench_reshape_mmr));
 
+    // End-to-end offline rendering, with and without pipelining
+    benchmark_throughput(vk->gpu, 1);
+    benchmark_throughput(vk->gpu, 4);
+
+    // Command submission overhead for many small passes per frame
+    benchmark_submit(vk);
+
+    // Pipeline barrier batching during rendering
+    benchmark_barriers(vk);
+
+    // Scheduling of independent compute work, without and with async compute
+    benchmark_async_compute(log, false);
+    benchmark_async_compute(log, true);
+
+    // Shader and pipeline compilation cost, for every render params preset
+    benchmark_startup(log, "fast", &pl_render_fast_params);
+    benchmark_startup(log, "default", &pl_render_default_params);
+    benchmark_startup(log, "high_quality", &pl_render_high_quality_params);
+
+    // Frame queue producer/consumer contention
+    benchmark_queue_contention(vk->gpu);
+    for (int depth = 8; depth <= 512; depth *= 4)
+        benchmark_queue_depth(vk->gpu, depth);
+
+    // Multiple renderers sharing one GPU, scaled by thread count
+    if (vk->gpu->limits.thread_safe) {
+        for (int n = 1; n <= MAX_THREADS; n *= 2)
+            benchmark_threads(vk->gpu, n);
+    }
+
     pl_vulkan_destroy(&vk);
     pl_log_destroy(&log);
     return 0;
@@ -1,6 +1,81 @@
 #include "tests.h"
+#include "libplacebo/dummy.h"
 #include "libplacebo/utils/dav1d.h"
 
+#define BENCH_W      1920
+#define BENCH_H      1080
+#define BENCH_FRAMES 120
+
+// Measures decode+upload throughput of pictures allocated by
+// pl_allocate_dav1dpicture, compared to regular system memory
+static void bench_upload(pl_gpu gpu, bool gpu_allocated)
+{
+    static Dav1dSequenceHeader seq_hdr;
+    static Dav1dFrameHeader frame_hdr;
+    const size_t luma_size = BENCH_W * BENCH_H;
+    uint8_t *sysmem = malloc(luma_size * 3 / 2);
+    REQUIRE(sysmem);
+
+    pl_tex tex[3] = {0};
+    struct pl_buf_pool_stats before, after;
+    pl_buf_pool_stats(gpu, &before);
+
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        Dav1dPicture pic = {
+            .p = {
+                .w = BENCH_W,
+                .h = BENCH_H,
+                .layout = DAV1D_PIXEL_LAYOUT_I420,
+                .bpc = 8,
+            },
+            .seq_hdr = &seq_hdr,
+            .frame_hdr = &frame_hdr,
+        };
+
+        if (gpu_allocated) {
+            REQUIRE(pl_allocate_dav1dpicture(&pic, (void *) gpu) == 0);
+        } else {
+            pic.stride[0] = BENCH_W;
+            pic.stride[1] = BENCH_W / 2;
+            pic.data[0] = sysmem;
+            pic.data[1] = sysmem + luma_size;
+            pic.data[2] = sysmem + luma_size * 5 / 4;
+        }
+
+        // "Decode" the picture
+        for (int p = 0; p < 3; p++) {
+            int w = p ? BENCH_W / 2 : BENCH_W, h = p ? BENCH_H / 2 : BENCH_H;
+            ptrdiff_t stride = pic.stride[p > 0];
+            for (int y = 0; y < h; y++)
+                memset((uint8_t *) pic.data[p] + y * stride, (i + y + p) & 0xFF, w);
+        }
+
+        struct pl_frame image;
+        REQUIRE(pl_upload_dav1dpicture(gpu, &image, tex, pl_dav1d_upload_params(
+            .picture = &pic,
+            .gpu_allocated = gpu_allocated,
+        )));
+
+        if (gpu_allocated)
+            pl_release_dav1dpicture(&pic, (void *) gpu);
+    }
+    pl_gpu_finish(gpu);
+    double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    pl_buf_pool_stats(gpu, &after);
+
+    printf("pl_upload_dav1dpicture (%s): %.3f ms/frame, %"PRIu64" pool hits, "
+           "%"PRIu64" misses\n", gpu_allocated ? "mapped" : "system memory",
+           1e3 * secs / BENCH_FRAMES, after.hits - before.hits,
+           after.misses - before.misses);
+    if (gpu_allocated)
+        REQUIRE(after.hits - before.hits >= BENCH_FRAMES - 1);
+
+    for (int p = 0; p < PL_ARRAY_SIZE(tex); p++)
+        pl_tex_destroy(gpu, &tex[p]);
+    free(sysmem);
+}
+
 int main()
 {
     // Test enum functions
@@ -36,4 +111,11 @@ int main()
         enum pl_chroma_location loc2 = pl_chroma_from_dav1d(dloc);
         REQUIRE(!loc2 || loc2 == loc);
     }
+
+    pl_log log = pl_test_logger();
+    pl_gpu gpu = pl_gpu_dummy_create(log, NULL);
+    bench_upload(gpu, false);
+    bench_upload(gpu, true);
+    pl_gpu_dummy_destroy(&gpu);
+    pl_log_destroy(&log);
 }
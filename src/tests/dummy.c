@@ -7,6 +7,94 @@ int main()
     pl_buffer_tests(gpu);
     pl_texture_tests(gpu);
 
+    // Test uploading formats with no matching texture format, which must be
+    // repacked on the CPU
+    struct pl_plane_data packed = {
+        .type = PL_FMT_UNORM,
+        .width = 2,
+        .height = 1,
+        .pixel_stride = 4,
+        .pixels = (uint32_t[2]) {
+            (1023u << 20) | (512u << 10) | (3u << 30), // a2r10g10b10
+            0x0,
+        },
+    };
+
+    pl_plane_data_from_mask(&packed, (uint64_t[4]) {
+        0x3FF00000, 0x000FFC00, 0x000003FF, 0xC0000000,
+    });
+
+    pl_tex packed_tex = NULL;
+    struct pl_plane plane;
+    REQUIRE(!pl_plane_find_fmt(gpu, NULL, &packed));
+    REQUIRE(pl_upload_plane(gpu, &plane, &packed_tex, &packed));
+    REQUIRE(packed_tex->params.format == pl_find_named_fmt(gpu, "rgba16"));
+    REQUIRE(plane.components == 4);
+    REQUIRE(plane.component_mapping[0] == PL_CHANNEL_B);
+    REQUIRE(plane.component_mapping[2] == PL_CHANNEL_R);
+    const uint16_t *data16 = (uint16_t *) pl_tex_dummy_data(packed_tex);
+    REQUIRE(data16[0] == 0 && data16[1] == 32800);
+    REQUIRE(data16[2] == 0xFFFF && data16[3] == 0xFFFF);
+    REQUIRE(data16[4] == 0 && data16[7] == 0);
+
+    packed.pixel_stride = 2;
+    packed.pixels = (uint16_t[2]) { 0xFFFF, (16 << 11) | (32 << 5) }; // rgb565
+    pl_plane_data_from_mask(&packed, (uint64_t[4]) { 0xF800, 0x07E0, 0x001F });
+    REQUIRE(pl_upload_plane(gpu, &plane, &packed_tex, &packed));
+    REQUIRE(packed_tex->params.format == pl_find_named_fmt(gpu, "rgb8"));
+    const uint8_t *data8 = pl_tex_dummy_data(packed_tex);
+    REQUIRE(data8[0] == 0xFF && data8[1] == 0xFF && data8[2] == 0xFF);
+    REQUIRE(data8[3] == 0 && data8[4] == 130 && data8[5] == 132);
+
+    packed.pixel_stride = 5;
+    packed.pixels = (uint8_t[10]) { 1, 2, 3, 0xAA, 0xAA, 4, 5, 6, 0xAA, 0xAA };
+    pl_plane_data_from_mask(&packed, (uint64_t[4]) { 0xFF, 0xFF00, 0xFF0000 });
+    REQUIRE(pl_upload_plane(gpu, &plane, &packed_tex, &packed));
+    data8 = pl_tex_dummy_data(packed_tex);
+    REQUIRE(memcmp(data8, (uint8_t[6]) { 1, 2, 3, 4, 5, 6 }, 6) == 0);
+    pl_tex_destroy(gpu, &packed_tex);
+
+    // Test unpacking formats with several pixels per group of bits, which
+    // happens on the CPU without a dispatch
+    const uint32_t v210[4] = {
+        (3u << 20) | (2u << 10) | 1u,      // Cr0 Y0 Cb0
+        (6u << 20) | (5u << 10) | 4u,      // Y2 Cb1 Y1
+        (9u << 20) | (8u << 10) | 1023u,   // Cb2 Y3 Cr1
+        (12u << 20) | (11u << 10) | 10u,   // Y5 Cr2 Y4
+    };
+
+    pl_tex packed_planes[3] = {0};
+    struct pl_plane planes[3];
+    struct pl_bit_encoding bits;
+    REQUIRE(pl_upload_packed(gpu, NULL, planes, packed_planes, &bits,
+        &(struct pl_packed_data) {
+            .format = PL_PACKED_V210,
+            .width  = 6,
+            .height = 1,
+            .pixels = v210,
+        }) == 3);
+    REQUIRE(bits.color_depth == 10 && bits.bit_shift == 6);
+    REQUIRE(planes[2].component_mapping[0] == PL_CHANNEL_CR);
+    REQUIRE(packed_planes[1]->params.w == 3);
+    data16 = (uint16_t *) pl_tex_dummy_data(packed_planes[0]);
+    REQUIRE(memcmp(data16, (uint16_t[6]) { 2 << 6, 4 << 6, 6 << 6,
+                                           8 << 6, 10 << 6, 12 << 6 }, 12) == 0);
+    data16 = (uint16_t *) pl_tex_dummy_data(packed_planes[2]);
+    REQUIRE(memcmp(data16, (uint16_t[3]) { 3 << 6, 1023 << 6, 11 << 6 }, 6) == 0);
+
+    REQUIRE(pl_upload_packed(gpu, NULL, NULL, packed_planes, &bits,
+        &(struct pl_packed_data) {
+            .format = PL_PACKED_BAYER12,
+            .width  = 2,
+            .height = 1,
+            .pixels = (uint8_t[3]) { 0xAB, 0xCD, 0x21 },
+        }) == 1);
+    REQUIRE(bits.color_depth == 12 && bits.bit_shift == 4);
+    data16 = (uint16_t *) pl_tex_dummy_data(packed_planes[0]);
+    REQUIRE(data16[0] == 0xAB10 && data16[1] == 0xCD20);
+    for (int i = 0; i < 3; i++)
+        pl_tex_destroy(gpu, &packed_planes[i]);
+
     // Attempt creating a shader and accessing the resulting LUT
     pl_tex dummy = pl_tex_dummy_create(gpu, pl_tex_dummy_params(
         .w = 100,
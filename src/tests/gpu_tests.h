@@ -73,6 +73,27 @@ static void pl_buffer_tests(pl_gpu gpu)
         REQUIRE(!pl_buf_poll(gpu, buf, 0));
         REQUIRE(memcmp(test_src, buf->data, buf_size) == 0);
         pl_buf_destroy(gpu, &buf);
+
+        printf("test buffer pool re-use\n");
+        struct pl_buf_pool_stats before, after;
+        const struct pl_buf_params pool_params = {
+            .size = buf_size,
+            .host_mapped = true,
+        };
+
+        buf = pl_buf_pool_get(gpu, &pool_params);
+        REQUIRE(buf && buf->params.size >= buf_size);
+        memcpy(buf->data, test_src, buf_size);
+        pl_buf_pool_put(gpu, &buf);
+        REQUIRE(!buf);
+
+        pl_buf_pool_stats(gpu, &before);
+        REQUIRE(before.num_bufs >= 1);
+        buf = pl_buf_pool_get(gpu, &pool_params);
+        REQUIRE(buf && buf->params.size >= buf_size);
+        pl_buf_pool_stats(gpu, &after);
+        REQUIRE(after.hits == before.hits + 1);
+        pl_buf_pool_put(gpu, &buf);
     }
 
     free(test_src);
@@ -221,6 +242,49 @@ static void pl_texture_tests(pl_gpu gpu)
     }
 
     free(test_src);
+
+    // Stream enough uploads to wrap around the upload ring several times
+    pl_fmt fmt = pl_find_named_fmt(gpu, "rgba8");
+    if (!fmt || !(fmt->caps & PL_FMT_CAP_HOST_READABLE))
+        return;
+
+    const int dim = PL_MIN(1024, gpu->limits.max_tex_2d_dim);
+    pl_tex tex = pl_tex_create(gpu, pl_tex_params(
+        .format        = fmt,
+        .w             = dim,
+        .h             = dim,
+        .host_writable = true,
+        .host_readable = true,
+    ));
+
+    REQUIRE(tex);
+    uint32_t *frame = malloc(dim * dim * sizeof(uint32_t));
+    const int num_frames = 40;
+    for (int n = 0; n < num_frames; n++) {
+        for (int i = 0; i < dim * dim; i++)
+            frame[i] = n * 0x01010101u + i;
+        REQUIRE(pl_tex_upload(gpu, pl_tex_transfer_params(
+            .tex = tex,
+            .ptr = frame,
+        )));
+    }
+
+    memset(frame, 0, dim * dim * sizeof(uint32_t));
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = frame,
+    )));
+    for (int i = 0; i < dim * dim; i++)
+        REQUIRE(frame[i] == (num_frames - 1) * 0x01010101u + i);
+
+    struct pl_gpu_upload_stats stats;
+    pl_gpu_upload_stats(gpu, &stats);
+    REQUIRE(stats.ring_peak <= stats.ring_size);
+    REQUIRE(stats.ring_used <= stats.ring_peak);
+    REQUIRE(!stats.ring_size || stats.uploads >= num_frames);
+
+    free(frame);
+    pl_tex_destroy(gpu, &tex);
 }
 
 static void pl_shader_tests(pl_gpu gpu)
@@ -548,7 +612,8 @@ static void pl_shader_tests(pl_gpu gpu)
     pl_shader_obj peak_state = NULL;
     struct pl_color_space csp_gamma22 = { .transfer = PL_COLOR_TRC_GAMMA22 };
     struct pl_peak_detect_params peak_params = { .minimum_peak = 0.01 };
-    if (pl_shader_detect_peak(sh, csp_gamma22, &peak_state, &peak_params)) {
+    bool has_peak = pl_shader_detect_peak(sh, csp_gamma22, &peak_state, &peak_params);
+    if (has_peak) {
         REQUIRE(pl_dispatch_compute(dp, &(struct pl_dispatch_compute_params) {
             .shader = &sh,
             .width = fbo->params.w,
@@ -578,6 +643,33 @@ static void pl_shader_tests(pl_gpu gpu)
     }
 
     pl_dispatch_abort(dp, &sh);
+
+    // Test asynchronous readback of the peak detection histogram
+    if (has_peak) {
+        peak_params.readback_frames = 2;
+        for (int i = 0; i < 3; i++) {
+            sh = pl_dispatch_begin(dp);
+            pl_shader_sample_nearest(sh, pl_sample_src( .tex = src ));
+            REQUIRE(pl_shader_detect_peak(sh, csp_gamma22, &peak_state, &peak_params));
+            REQUIRE(pl_dispatch_compute(dp, &(struct pl_dispatch_compute_params) {
+                .shader = &sh,
+                .width = fbo->params.w,
+                .height = fbo->params.h,
+            }));
+        }
+
+        pl_gpu_finish(gpu);
+        struct pl_peak_detect_stats stats;
+        REQUIRE(pl_get_detected_stats(peak_state, &stats));
+        uint64_t total = 0;
+        for (int i = 0; i < PL_PEAK_HISTOGRAM_BINS; i++)
+            total += stats.histogram[i];
+        REQUIRE(total == fbo->params.w * fbo->params.h);
+        REQUIRE(feq(stats.frame_peak, stats.peak, 1e-4));
+        REQUIRE(stats.latency == 1);
+        REQUIRE(!pl_get_detected_stats(peak_state, &stats));
+    }
+
     pl_shader_obj_destroy(&peak_state);
 
     // Test film grain synthesis
@@ -863,6 +955,30 @@ static bool frame_passthrough(pl_gpu gpu, pl_tex *tex,
     return true;
 }
 
+static bool frame_upload(pl_gpu gpu, pl_tex *tex,
+                         const struct pl_source_frame *src, struct pl_frame *out_frame)
+{
+    static const uint8_t pixels[32 * 32] = {0};
+    const int size = (intptr_t) src->frame_data;
+    struct pl_plane_data data = {
+        .type           = PL_FMT_UNORM,
+        .width          = size,
+        .height         = size,
+        .component_size = {8},
+        .component_map  = {0},
+        .pixel_stride   = 1,
+        .pixels         = pixels,
+    };
+
+    *out_frame = (struct pl_frame) {
+        .num_planes = 1,
+        .repr       = pl_color_repr_rgb,
+        .color      = pl_color_space_srgb,
+    };
+
+    return pl_upload_plane(gpu, &out_frame->planes[0], &tex[0], &data);
+}
+
 static enum pl_queue_status get_frame_ptr(struct pl_source_frame *out_frame,
                                           const struct pl_queue_params *qparams)
 {
@@ -874,6 +990,13 @@ static enum pl_queue_status get_frame_ptr(struct pl_source_frame *out_frame,
     return PL_QUEUE_OK;
 }
 
+static void throughput_done(void *priv, bool ok)
+{
+    int *done = priv;
+    REQUIRE(ok);
+    (*done)++;
+}
+
 static void render_info_cb(void *priv, const struct pl_render_info *info)
 {
     printf("{%d} Executed shader: %s\n", info->index,
@@ -1000,6 +1123,65 @@ static void pl_render_tests(pl_gpu gpu)
     REQUIRE(pl_render_image(rr, &image, &target, &params));
     params = pl_render_default_params;
 
+    // Test tiled rendering, on a target large enough to be split into several
+    // tiles in each direction. The result must match rendering in one pass,
+    // so the image is upscaled to make any seams visible
+    pl_fmt tile_fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, 4, 32, 32,
+                                  PL_FMT_CAP_RENDERABLE | PL_FMT_CAP_BLITTABLE |
+                                  PL_FMT_CAP_HOST_READABLE);
+    if (tile_fmt) {
+        enum { TILED_SIZE = 64, TILE_SIZE = 16 };
+        pl_tex tiled_fbo = pl_tex_create(gpu, pl_tex_params(
+            .w              = TILED_SIZE,
+            .h              = TILED_SIZE,
+            .format         = tile_fmt,
+            .renderable     = true,
+            .blit_src       = true,
+            .blit_dst       = true,
+            .host_readable  = true,
+        ));
+        REQUIRE(tiled_fbo);
+        pl_tex_clear_ex(gpu, tiled_fbo, (union pl_clear_color){0});
+
+        struct pl_frame tiled_target = target;
+        tiled_target.planes[0].texture = tiled_fbo;
+        tiled_target.crop = (struct pl_rect2df) {0};
+
+        params.render_tile_size = TILE_SIZE;
+        params.deband_params = &pl_deband_default_params;
+        REQUIRE(pl_render_image(rr, &image, &tiled_target, &params));
+        params.deband_params = NULL; // randomized, so can't be compared
+        params.dither_params = NULL;
+
+        const size_t num_floats = TILED_SIZE * TILED_SIZE * 4;
+        float *ref = malloc(num_floats * sizeof(float));
+        float *tiled = malloc(num_floats * sizeof(float));
+        REQUIRE(ref && tiled);
+
+        params.render_tile_size = 0;
+        REQUIRE(pl_render_image(rr, &image, &tiled_target, &params));
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = tiled_fbo,
+            .ptr = ref,
+        )));
+
+        params.render_tile_size = TILE_SIZE;
+        REQUIRE(pl_render_image(rr, &image, &tiled_target, &params));
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = tiled_fbo,
+            .ptr = tiled,
+        )));
+
+        for (size_t i = 0; i < num_floats; i++)
+            REQUIRE(feq(ref[i], tiled[i], 1e-4));
+
+        free(ref);
+        free(tiled);
+        pl_tex_destroy(gpu, &tiled_fbo);
+    }
+
+    params = pl_render_default_params;
+
     // Test film grain synthesis
     image.film_grain.type = PL_FILM_GRAIN_AV1;
     image.film_grain.params.av1 = av1_grain_data,
@@ -1194,6 +1376,120 @@ static void pl_render_tests(pl_gpu gpu)
 
     pl_queue_destroy(&queue);
 
+    // Test asynchronous frame mapping
+    if (gpu->limits.thread_safe) {
+        printf("testing async frame mapping\n");
+        queue = pl_queue_create_ex(gpu, pl_queue_create_params(
+            .map_threads = 2,
+            .prefetch_frames = 6,
+        ));
+
+        frame_ptr = &srcframes[0];
+        qparams.pts = 0.0;
+        int num_mixed = 0;
+        while ((ret = pl_queue_update(queue, &mix, &qparams)) != PL_QUEUE_EOF) {
+            REQUIRE(ret == PL_QUEUE_OK);
+            REQUIRE(mix.num_frames >= 1 && mix.num_frames <= 2);
+            REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
+            qparams.pts += qparams.vsync_duration;
+            num_mixed++;
+        }
+        REQUIRE(num_mixed > NUM_MIX_FRAMES);
+
+        // Reset while frames may still be in the process of being mapped
+        frame_ptr = &srcframes[0];
+        qparams.pts = 0.0;
+        REQUIRE(pl_queue_update(queue, &mix, &qparams) == PL_QUEUE_OK);
+        pl_queue_reset(queue);
+        pl_queue_destroy(&queue);
+    }
+
+    // Test texture reuse across a resolution change
+    queue = pl_queue_create_ex(gpu, pl_queue_create_params(
+        .texture_pool_size = 4,
+    ));
+
+    for (int i = 0; i < NUM_MIX_FRAMES; i++) {
+        pl_queue_push(queue, &(struct pl_source_frame) {
+            .pts = i * qparams.frame_duration,
+            .map = frame_upload,
+            .frame_data = (void *) (intptr_t) (i < NUM_MIX_FRAMES / 2 ? 16 : 32),
+        });
+    }
+    pl_queue_push(queue, NULL);
+
+    qparams.pts = 0.0;
+    qparams.get_frame = NULL;
+    while ((ret = pl_queue_update(queue, &mix, &qparams)) != PL_QUEUE_EOF) {
+        REQUIRE(ret == PL_QUEUE_OK);
+        qparams.pts += qparams.vsync_duration;
+    }
+
+    struct pl_queue_pool_stats pool_stats;
+    pl_queue_pool_stats(queue, &pool_stats);
+    REQUIRE(pool_stats.hits + pool_stats.misses == NUM_MIX_FRAMES);
+    REQUIRE(pool_stats.hits >= NUM_MIX_FRAMES / 2);
+    REQUIRE(pool_stats.num_textures <= 4);
+    pl_queue_destroy(&queue);
+
+    // Test out-of-order insertion
+    queue = pl_queue_create(gpu);
+    for (int i = 0; i < NUM_MIX_FRAMES; i++)
+        pl_queue_push(queue, &srcframes[(i * 7) % NUM_MIX_FRAMES]);
+    pl_queue_push(queue, NULL);
+
+    qparams = (struct pl_queue_params) {
+        .vsync_duration = qparams.vsync_duration,
+        .frame_duration = qparams.frame_duration,
+    };
+
+    while ((ret = pl_queue_update(queue, &mix, &qparams)) != PL_QUEUE_EOF) {
+        REQUIRE(ret == PL_QUEUE_OK);
+        for (int i = 1; i < mix.num_frames; i++)
+            REQUIRE(mix.timestamps[i] > mix.timestamps[i - 1]);
+        if (mix.num_frames == 2)
+            REQUIRE(mix.timestamps[0] <= 0.0 && mix.timestamps[1] >= 0.0);
+        qparams.pts += qparams.vsync_duration;
+    }
+    pl_queue_destroy(&queue);
+
+    // Test pipelined offline rendering
+    pl_fmt out_fmt = pl_find_named_fmt(gpu, "rgba8");
+    if (out_fmt && (out_fmt->caps & PL_FMT_CAP_HOST_READABLE)) {
+        printf("testing pl_throughput\n");
+        pl_throughput tp = pl_throughput_create(gpu, pl_throughput_params(
+            .renderer           = rr,
+            .frames_in_flight   = 2,
+            .format             = out_fmt,
+            .width              = 16,
+            .height             = 16,
+            .color              = pl_color_space_srgb,
+            .repr               = pl_color_repr_rgb,
+        ));
+        REQUIRE(tp);
+
+        static uint8_t out[2][16 * 16 * 4];
+        int done = 0;
+        for (int i = 0; i < 5; i++) {
+            memset(out[i % 2], 0xFF, sizeof(out[0]));
+            REQUIRE(pl_throughput_submit(tp, &(struct pl_throughput_frame) {
+                .src.map        = frame_passthrough,
+                .src.frame_data = &image,
+                .out_ptr        = out[i % 2],
+                .done           = throughput_done,
+                .priv           = &done,
+            }));
+        }
+
+        pl_throughput_drain(tp);
+        struct pl_throughput_stats stats;
+        pl_throughput_stats(tp, &stats);
+        REQUIRE(done == 5);
+        REQUIRE(stats.submitted == 5 && stats.completed == 5);
+        REQUIRE(stats.failed == 0);
+        pl_throughput_destroy(&tp);
+    }
+
 error:
     pl_renderer_destroy(&rr);
     pl_tex_destroy(gpu, &img5x5_tex);
@@ -1430,13 +1726,166 @@ static void pl_test_host_ptr(pl_gpu gpu)
 
     REQUIRE(buf);
     REQUIRE(memcmp(data + offset, buf->data, slice) == 0);
-
     pl_buf_destroy(gpu, &buf);
+
+    // Large asynchronous uploads import the user's memory directly, instead
+    // of staging it, so the callback must not fire before it was read
+    pl_fmt fmt = pl_find_named_fmt(gpu, "r8");
+    if (fmt && (fmt->caps & PL_FMT_CAP_HOST_READABLE) && gpu->limits.callbacks) {
+        pl_tex tex = pl_tex_create(gpu, &(struct pl_tex_params) {
+            .format         = fmt,
+            .w              = 1024,
+            .h              = 1024,
+            .sampleable     = true,
+            .host_writable  = true,
+            .host_readable  = true,
+        });
+
+        REQUIRE(tex);
+        uint8_t *out = malloc(1024 * 1024);
+        struct pl_gpu_upload_stats before, after;
+        pl_gpu_upload_stats(gpu, &before);
+        bool uploaded = false;
+        REQUIRE(pl_tex_upload(gpu, &(struct pl_tex_transfer_params) {
+            .tex = tex,
+            .ptr = data,
+            .callback = test_cb,
+            .priv = &uploaded,
+        }));
+        pl_gpu_upload_stats(gpu, &after);
+        REQUIRE(after.uploads == before.uploads);
+        REQUIRE(after.fallbacks == before.fallbacks);
+
+        pl_gpu_finish(gpu);
+        REQUIRE(uploaded);
+        memset(data, 0, size); // must not affect the completed upload
+        REQUIRE(pl_tex_download(gpu, &(struct pl_tex_transfer_params) {
+            .tex = tex,
+            .ptr = out,
+        }));
+        for (int i = 0; i < 1024 * 1024; i++)
+            REQUIRE(out[i] == (uint8_t) i);
+
+        // Synchronous uploads may import the user's memory as well, in which
+        // case they must not return before the transfer has completed
+        for (int i = 0; i < size; i++)
+            data[i] = (uint8_t) (i + 1);
+        REQUIRE(pl_tex_upload(gpu, &(struct pl_tex_transfer_params) {
+            .tex = tex,
+            .ptr = data,
+        }));
+        memset(data, 0, size);
+        REQUIRE(pl_tex_download(gpu, &(struct pl_tex_transfer_params) {
+            .tex = tex,
+            .ptr = out,
+        }));
+        for (int i = 0; i < 1024 * 1024; i++)
+            REQUIRE(out[i] == (uint8_t) (i + 1));
+
+        free(out);
+        pl_tex_destroy(gpu, &tex);
+    }
+
     free(data);
 
 #endif // unix
 }
 
+static void pl_unpack_tests(pl_gpu gpu)
+{
+    pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+    enum { W = 37, H = 11 };
+    uint32_t pixels[W * H];
+    for (int i = 0; i < W * H; i++)
+        pixels[i] = i * 0x9E3779B9u; // pseudo-random bit patterns
+
+    struct pl_plane_data data = {
+        .type = PL_FMT_UNORM,
+        .width = W,
+        .height = H,
+        .pixel_stride = sizeof(uint32_t),
+        .pixels = pixels,
+    };
+
+    // a1rgb10x1, which has no native texture format anywhere, is unpacked
+    // on the GPU and compared against the result of repacking it on the CPU
+    pl_plane_data_from_mask(&data, (uint64_t[4]) {
+        0x7FE00000, 0x001FF800, 0x000007FE, 0x80000000,
+    });
+
+    pl_tex cpu_tex = NULL, gpu_tex = NULL;
+    uint16_t cpu_data[W * H * 4], gpu_data[W * H * 4];
+    REQUIRE(!pl_plane_find_fmt(gpu, NULL, &data));
+    REQUIRE(pl_upload_plane(gpu, NULL, &cpu_tex, &data));
+    REQUIRE(pl_upload_plane_unpack(gpu, dp, NULL, &gpu_tex, &data));
+    pl_fmt fmt = gpu_tex->params.format;
+    REQUIRE(cpu_tex->params.format == fmt);
+    REQUIRE(fmt->texel_size == sizeof(uint16_t[4]));
+
+    if (fmt->caps & PL_FMT_CAP_HOST_READABLE) {
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = cpu_tex,
+            .ptr = cpu_data,
+        )));
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = gpu_tex,
+            .ptr = gpu_data,
+        )));
+        for (int i = 0; i < W * H * 4; i++)
+            REQUIRE(abs((int) cpu_data[i] - (int) gpu_data[i]) <= 1);
+    }
+
+    pl_tex_destroy(gpu, &cpu_tex);
+    pl_tex_destroy(gpu, &gpu_tex);
+
+    // Packed formats are unpacked on the GPU and compared against the result
+    // of unpacking them on the CPU, which must match exactly
+    for (enum pl_packed_fmt f = 0; f < PL_PACKED_FMT_COUNT; f++) {
+        size_t stride = pl_packed_row_stride(f, W);
+        uint8_t *packed = malloc(stride * H);
+        for (int i = 0; i < stride * H; i++)
+            packed[i] = (i * 0x9E3779B9u) >> 24;
+
+        struct pl_packed_data pdata = {
+            .format = f,
+            .width  = W,
+            .height = H,
+            .pixels = packed,
+        };
+
+        pl_tex cpu_planes[3] = {0}, gpu_planes[3] = {0};
+        struct pl_bit_encoding bits;
+        int num = pl_upload_packed(gpu, NULL, NULL, cpu_planes, &bits, &pdata);
+        REQUIRE(num == (f == PL_PACKED_BAYER12 ? 1 : 3));
+        REQUIRE(pl_upload_packed(gpu, dp, NULL, gpu_planes, NULL, &pdata) == num);
+        REQUIRE(bits.sample_depth == 16 && bits.color_depth + bits.bit_shift == 16);
+
+        for (int i = 0; i < num; i++) {
+            pl_tex tex = gpu_planes[i];
+            if (!(tex->params.format->caps & PL_FMT_CAP_HOST_READABLE))
+                continue;
+            REQUIRE(tex->params.w == (i ? (W + 1) / 2 : W));
+            REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+                .tex = cpu_planes[i],
+                .ptr = cpu_data,
+            )));
+            REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+                .tex = tex,
+                .ptr = gpu_data,
+            )));
+            REQUIRE(memcmp(cpu_data, gpu_data, tex->params.w * H * sizeof(uint16_t)) == 0);
+        }
+
+        for (int i = 0; i < 3; i++) {
+            pl_tex_destroy(gpu, &cpu_planes[i]);
+            pl_tex_destroy(gpu, &gpu_planes[i]);
+        }
+        free(packed);
+    }
+
+    pl_dispatch_destroy(&dp);
+}
+
 static void gpu_shader_tests(pl_gpu gpu)
 {
     pl_buffer_tests(gpu);
@@ -1445,6 +1894,7 @@ static void gpu_shader_tests(pl_gpu gpu)
     pl_scaler_tests(gpu);
     pl_render_tests(gpu);
     pl_ycbcr_tests(gpu);
+    pl_unpack_tests(gpu);
 
     REQUIRE(!pl_gpu_is_failed(gpu));
 }
@@ -1,6 +1,185 @@
 #include "tests.h"
+#include "libplacebo/dummy.h"
 #include "libplacebo/utils/libav.h"
 
+#define BENCH_W      1920
+#define BENCH_H      1080
+#define BENCH_FRAMES 120
+#define BENCH_DEPTH  4 // frames in flight
+
+static bool frame_equal(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    for (int p = 0; p < av_pix_fmt_count_planes(a->format); p++) {
+        bool is_chroma = p == 1 || p == 2;
+        int w = AV_CEIL_RSHIFT(a->width, is_chroma ? desc->log2_chroma_w : 0);
+        int h = AV_CEIL_RSHIFT(a->height, is_chroma ? desc->log2_chroma_h : 0);
+        for (int y = 0; y < h; y++) {
+            if (memcmp(a->data[p] + y * a->linesize[p],
+                       b->data[p] + y * b->linesize[p], w))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static AVFrame *alloc_frame(void)
+{
+    AVFrame *frame = av_frame_alloc();
+    REQUIRE(frame);
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = BENCH_W;
+    frame->height = BENCH_H;
+    return frame;
+}
+
+static void set_done(void *priv)
+{
+    bool *done = priv;
+    *done = true;
+}
+
+// Compares pl_download_avframe against pl_download_avframe_async, both for
+// correctness and throughput
+static void test_download(pl_gpu gpu)
+{
+    AVFrame *ref = alloc_frame();
+    REQUIRE(av_frame_get_buffer(ref, 0) >= 0);
+    for (int p = 0; p < 3; p++) {
+        int h = p ? BENCH_H / 2 : BENCH_H;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < ref->linesize[p]; x++)
+                ref->data[p][y * ref->linesize[p] + x] = (x + 3 * y + 7 * p) & 0xFF;
+        }
+    }
+
+    pl_tex tex[4] = {0};
+    struct pl_frame image;
+    REQUIRE(pl_frame_recreate_from_avframe(gpu, &image, tex, ref));
+    for (int p = 0; p < image.num_planes; p++) {
+        REQUIRE(pl_tex_upload(gpu, pl_tex_transfer_params(
+            .tex = tex[p],
+            .row_pitch = ref->linesize[p],
+            .ptr = ref->data[p],
+        )));
+    }
+
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        AVFrame *out = alloc_frame();
+        REQUIRE(av_frame_get_buffer(out, 0) >= 0);
+        REQUIRE(pl_download_avframe(gpu, &image, out));
+        if (!i)
+            REQUIRE(frame_equal(ref, out));
+        av_frame_free(&out);
+    }
+    double secs_sync = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    AVFrame *frames[BENCH_DEPTH] = {0};
+    bool done[BENCH_DEPTH] = {0};
+    struct pl_buf_pool_stats before, after;
+    pl_buf_pool_stats(gpu, &before);
+
+    start = clock();
+    for (int i = 0; i < BENCH_FRAMES + BENCH_DEPTH; i++) {
+        const int idx = i % BENCH_DEPTH;
+        if (frames[idx]) {
+            while (!done[idx])
+                pl_tex_poll(gpu, tex[0], UINT64_MAX);
+            REQUIRE(frame_equal(ref, frames[idx]));
+            av_frame_free(&frames[idx]);
+        }
+
+        if (i >= BENCH_FRAMES)
+            continue;
+
+        frames[idx] = alloc_frame();
+        done[idx] = false;
+        REQUIRE(pl_download_avframe_async(gpu, &image, frames[idx],
+                                          set_done, &done[idx]));
+        pl_gpu_flush(gpu);
+    }
+    double secs_async = (double) (clock() - start) / CLOCKS_PER_SEC;
+    pl_buf_pool_stats(gpu, &after);
+
+    printf("pl_download_avframe: %.3f ms/frame (sync), %.3f ms/frame (async, "
+           "%d in flight), %"PRIu64" pool hits, %"PRIu64" misses\n",
+           1e3 * secs_sync / BENCH_FRAMES, 1e3 * secs_async / BENCH_FRAMES,
+           BENCH_DEPTH, after.hits - before.hits, after.misses - before.misses);
+    REQUIRE(after.hits > before.hits);
+
+    for (int p = 0; p < PL_ARRAY_SIZE(tex); p++)
+        pl_tex_destroy(gpu, &tex[p]);
+    av_frame_free(&ref);
+}
+
+// Stand-in for a software decoder supporting direct rendering
+static const AVCodec decoder_stub = {
+    .name = "stub",
+    .type = AVMEDIA_TYPE_VIDEO,
+    .capabilities = AV_CODEC_CAP_DR1,
+};
+
+// Measures decode+upload throughput with frames allocated by pl_get_buffer2,
+// compared to regular system memory
+static void test_get_buffer2(pl_gpu gpu, bool mapped)
+{
+    AVCodecContext *avctx = avcodec_alloc_context3(NULL);
+    REQUIRE(avctx);
+    avctx->codec = &decoder_stub;
+    avctx->opaque = &gpu;
+    avctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    avctx->width = BENCH_W;
+    avctx->height = BENCH_H;
+
+    pl_tex tex[4] = {0};
+    struct pl_buf_pool_stats before, after;
+    pl_buf_pool_stats(gpu, &before);
+
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        AVFrame *frame = alloc_frame();
+        if (mapped) {
+            REQUIRE(pl_get_buffer2(avctx, frame, 0) >= 0);
+            for (int p = 0; p < 3; p++)
+                REQUIRE(pl_avalloc_get_buf(frame->buf[p]));
+        } else {
+            REQUIRE(av_frame_get_buffer(frame, 0) >= 0);
+        }
+
+        // "Decode" the frame
+        for (int p = 0; p < 3; p++) {
+            int w = p ? BENCH_W / 2 : BENCH_W, h = p ? BENCH_H / 2 : BENCH_H;
+            for (int y = 0; y < h; y++)
+                memset(frame->data[p] + y * frame->linesize[p], (i + y + p) & 0xFF, w);
+        }
+
+        struct pl_frame image;
+        REQUIRE(pl_map_avframe_ex(gpu, &image, pl_avframe_params(
+            .frame = frame,
+            .tex = tex,
+        )));
+        pl_unmap_avframe(gpu, &image);
+        av_frame_free(&frame);
+    }
+    pl_gpu_finish(gpu);
+    double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    pl_buf_pool_stats(gpu, &after);
+
+    printf("pl_get_buffer2 (%s): %.3f ms/frame, %"PRIu64" pool hits, "
+           "%"PRIu64" misses\n", mapped ? "mapped" : "system memory",
+           1e3 * secs / BENCH_FRAMES, after.hits - before.hits,
+           after.misses - before.misses);
+    if (mapped)
+        REQUIRE(after.hits - before.hits >= 3 * (BENCH_FRAMES - 1));
+
+    for (int p = 0; p < PL_ARRAY_SIZE(tex); p++)
+        pl_tex_destroy(gpu, &tex[p]);
+    avctx->codec = NULL;
+    avcodec_free_context(&avctx);
+}
+
 int main()
 {
     struct pl_plane_data data[4] = {0};
@@ -333,4 +512,12 @@ int main()
         enum pl_chroma_location loc2 = pl_chroma_from_av(avloc);
         REQUIRE(loc2 == loc);
     }
+
+    pl_log log = pl_test_logger();
+    pl_gpu gpu = pl_gpu_dummy_create(log, NULL);
+    test_download(gpu);
+    test_get_buffer2(gpu, false);
+    test_get_buffer2(gpu, true);
+    pl_gpu_dummy_destroy(&gpu);
+    pl_log_destroy(&log);
 }
@@ -1,4 +1,5 @@
 #include "gpu_tests.h"
+#include "pl_thread.h"
 #include "vulkan/command.h"
 #include "vulkan/gpu.h"
 #include <vulkan/vulkan.h>
@@ -104,6 +105,216 @@ static void vulkan_swapchain_tests(pl_vulkan vk, VkSurfaceKHR surf)
     pl_swapchain_destroy(&sw);
 }
 
+static void vulkan_budget_tests(pl_log log, const struct pl_vulkan_params *base)
+{
+    printf("testing vulkan memory budget\n");
+    struct pl_vulkan_params params = *base;
+    params.memory_budget = 16 << 20;
+    pl_vulkan vk = pl_vulkan_create(log, &params);
+    REQUIRE(vk);
+
+    pl_gpu gpu = vk->gpu;
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_SAMPLEABLE);
+    if (!fmt)
+        goto done;
+
+    // Allocate more textures than fit into the budget, releasing them again
+    // afterwards. This should trigger eviction without failing allocations.
+    pl_tex tex[16] = {0};
+    for (int i = 0; i < PL_ARRAY_SIZE(tex); i++) {
+        tex[i] = pl_tex_create(gpu, pl_tex_params(
+            .w = 1024,
+            .h = 1024,
+            .format = fmt,
+            .sampleable = true,
+        ));
+        REQUIRE(tex[i]);
+    }
+
+    struct pl_vulkan_memory_stats stats;
+    pl_vulkan_memory_stats(vk, &stats);
+    REQUIRE(stats.num_heaps > 0);
+    REQUIRE(stats.evictions > 0);
+    for (int i = 0; i < stats.num_heaps; i++) {
+        const struct pl_vulkan_heap_stats *heap = &stats.heaps[i];
+        REQUIRE(heap->used <= heap->allocated);
+        if (heap->flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            REQUIRE(heap->budget <= params.memory_budget);
+    }
+
+    for (int i = 0; i < PL_ARRAY_SIZE(tex); i++)
+        pl_tex_destroy(gpu, &tex[i]);
+
+done:
+    pl_vulkan_destroy(&vk);
+}
+
+// Records commands from several threads at once, which must be serialized
+// internally since they all share the same command pools. Any violation of
+// the external synchronization rules is reported by the validation layers.
+enum { REC_THREADS = 4, REC_SIZE = 64, REC_FRAMES = 64 };
+
+struct record_thread {
+    pl_gpu gpu;
+    pl_tex tex;
+    int index;
+    bool failed;
+    uint8_t data[REC_SIZE * REC_SIZE * 4];
+    uint8_t out[REC_SIZE * REC_SIZE * 4];
+};
+
+static PL_THREAD_VOID record_thread_run(void *priv)
+{
+    struct record_thread *t = priv;
+    for (int frame = 0; frame < REC_FRAMES && !t->failed; frame++) {
+        for (int n = 0; n < sizeof(t->data); n++)
+            t->data[n] = (n + frame * 31 + t->index * 97) & 0xFF;
+
+        t->failed |= !pl_tex_upload(t->gpu, pl_tex_transfer_params(
+            .tex = t->tex,
+            .ptr = t->data,
+        ));
+
+        t->failed |= !pl_tex_download(t->gpu, pl_tex_transfer_params(
+            .tex = t->tex,
+            .ptr = t->out,
+        ));
+
+        t->failed |= memcmp(t->data, t->out, sizeof(t->out)) != 0;
+        pl_gpu_flush(t->gpu);
+    }
+
+    PL_THREAD_RETURN();
+}
+
+static void vulkan_thread_tests(pl_gpu gpu)
+{
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_HOST_READABLE);
+    if (!fmt)
+        return;
+
+    printf("testing vulkan multi-threaded command recording\n");
+    static struct record_thread threads[REC_THREADS];
+    pl_thread handles[REC_THREADS];
+    for (int i = 0; i < REC_THREADS; i++) {
+        threads[i] = (struct record_thread) {
+            .gpu = gpu,
+            .index = i,
+            .tex = pl_tex_create(gpu, pl_tex_params(
+                .w = REC_SIZE,
+                .h = REC_SIZE,
+                .format = fmt,
+                .host_writable = true,
+                .host_readable = true,
+            )),
+        };
+        REQUIRE(threads[i].tex);
+    }
+
+    for (int i = 0; i < REC_THREADS; i++)
+        REQUIRE(pl_thread_create(&handles[i], record_thread_run, &threads[i]) == 0);
+    for (int i = 0; i < REC_THREADS; i++)
+        pl_thread_join(handles[i]);
+
+    pl_gpu_finish(gpu);
+    REQUIRE(!pl_gpu_is_failed(gpu));
+    for (int i = 0; i < REC_THREADS; i++) {
+        REQUIRE(!threads[i].failed);
+        pl_tex_destroy(gpu, &threads[i].tex);
+    }
+}
+
+static void vulkan_defrag_tests(pl_log log, const struct pl_vulkan_params *params)
+{
+    // Use a separate context, so the layout of the memory pools only depends
+    // on the allocations made here
+    pl_vulkan vk = pl_vulkan_create(log, params);
+    REQUIRE(vk);
+
+    pl_gpu gpu = vk->gpu;
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_BLITTABLE);
+    if (!fmt)
+        goto done;
+
+    printf("testing vulkan memory defragmentation\n");
+    enum { NUM_TEX = 32, SIZE = 256 };
+    static uint8_t data[NUM_TEX][SIZE * SIZE * 4], out[SIZE * SIZE * 4];
+    pl_tex tex[NUM_TEX] = {0};
+    for (int i = 0; i < NUM_TEX; i++) {
+        for (int n = 0; n < sizeof(data[i]); n++)
+            data[i][n] = RANDOM * 255;
+
+        // Only textures owned by libplacebo itself may be moved
+        tex[i] = pl_tex_create_internal(gpu, pl_tex_params(
+            .w = SIZE,
+            .h = SIZE,
+            .format = fmt,
+            .sampleable = true,
+            .host_writable = true,
+            .host_readable = true,
+            .initial_data = data[i],
+        ));
+        REQUIRE(tex[i]);
+    }
+
+    pl_tex user_tex = pl_tex_create(gpu, pl_tex_params(
+        .w = SIZE,
+        .h = SIZE,
+        .format = fmt,
+        .sampleable = true,
+    ));
+    REQUIRE(user_tex);
+    REQUIRE(!((struct pl_tex_vk *) PL_PRIV(user_tex))->movable);
+    pl_tex_destroy(gpu, &user_tex);
+
+    // Free most textures to leave sparsely used slabs behind, then keep
+    // using the survivors for a while, giving them a chance to be moved
+    for (int i = 0; i < NUM_TEX; i++) {
+        if (i % 8)
+            pl_tex_destroy(gpu, &tex[i]);
+    }
+
+    struct pl_vulkan_memory_stats before, after;
+    pl_vulkan_memory_stats(vk, &before);
+
+    for (int frame = 0; frame < 256; frame++) {
+        for (int i = 0; i < NUM_TEX; i += 8) {
+            REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+                .tex = tex[i],
+                .ptr = out,
+            )));
+            REQUIRE(memcmp(data[i], out, sizeof(out)) == 0);
+        }
+        pl_gpu_flush(gpu);
+    }
+
+    // At least one survivor must have been evacuated out of its slab, and
+    // the contents must have survived the move
+    pl_vulkan_memory_stats(vk, &after);
+    uint64_t moves = after.defrag_moves - before.defrag_moves;
+    REQUIRE(moves > 0);
+    REQUIRE(after.defrag_bytes - before.defrag_bytes >= moves * sizeof(out));
+
+    for (int i = 0; i < NUM_TEX; i += 8) {
+        memset(out, 0, sizeof(out));
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = tex[i],
+            .ptr = out,
+        )));
+        REQUIRE(memcmp(data[i], out, sizeof(out)) == 0);
+    }
+
+    // Unwrapped textures must stay in place
+    REQUIRE(pl_vulkan_unwrap(gpu, tex[0], NULL, NULL));
+    REQUIRE(!((struct pl_tex_vk *) PL_PRIV(tex[0]))->movable);
+
+    for (int i = 0; i < NUM_TEX; i++)
+        pl_tex_destroy(gpu, &tex[i]);
+
+done:
+    pl_vulkan_destroy(&vk);
+}
+
 int main()
 {
     pl_log log = pl_test_logger();
@@ -193,6 +404,9 @@ int main()
 
         gpu_shader_tests(vk->gpu);
         vulkan_swapchain_tests(vk, surf);
+        vulkan_budget_tests(log, &params);
+        vulkan_thread_tests(vk->gpu);
+        vulkan_defrag_tests(log, &params);
 
         // Print heap statistics
         pl_vk_print_heap(vk->gpu, PL_LOG_DEBUG);
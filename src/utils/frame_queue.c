@@ -16,7 +16,9 @@
  */
 
 #include <errno.h>
+#include <limits.h>
 #include <math.h>
+#include <stdatomic.h>
 
 #include "common.h"
 #include "log.h"
@@ -26,13 +28,24 @@ struct cache_entry {
     pl_tex tex[4];
 };
 
+// Unused texture, available for reuse by any frame
+struct pool_tex {
+    pl_tex tex;
+    uint64_t last_used;
+};
+
 struct entry {
     struct cache_entry cache;
     struct pl_source_frame src;
     struct pl_frame frame;
     uint64_t signature;
+    size_t size; // texture memory held while mapped
     bool mapped;
     bool ok;
+
+    // Asynchronous mapping state
+    bool busy;   // currently being mapped by a worker thread
+    bool culled; // culled while busy, to be freed by the worker thread
 };
 
 // Hard limits for vsync timing validity
@@ -50,6 +63,28 @@ struct entry {
 // Maximum number of not-yet-mapped frames to allow queueing in advance
 #define PREFETCH_FRAMES 2
 
+// Default number of frames to map ahead of time, if async mapping is enabled
+#define ASYNC_PREFETCH_FRAMES 4
+
+// Default maximum number of unused textures to keep around for reuse
+#define POOL_TEXTURES 32
+
+// Capacity of the lock-free ring of incoming frames
+#define INCOMING_FRAMES 16
+
+// Bounded single-producer/single-consumer ring of frames pushed by
+// `pl_queue_push`, which are moved into the queue proper by whichever thread
+// next holds `lock_weak`. Only one producer may use the ring at a time; other
+// producers fall back to taking `lock_weak` directly.
+struct incoming {
+    struct pl_source_frame frames[INCOMING_FRAMES]; // `map == NULL` means EOF
+    atomic_size_t head; // next frame to consume
+    atomic_size_t tail; // next free slot
+    atomic_flag producing;
+    atomic_int room;    // cached `queue_room` result, for `pl_queue_push_block`
+    atomic_bool waiting; // a consumer is blocked on `wakeup` for new frames
+};
+
 struct pool {
     float samples[MAX_SAMPLES];
     float estimate;
@@ -93,24 +128,82 @@ struct pl_queue {
     PL_ARRAY(float) tmp_ts;
     PL_ARRAY(const struct pl_frame *) tmp_frame;
 
-    // Queue of GPU objects to reuse
-    PL_ARRAY(struct cache_entry) cache;
+    // Pool of unused textures, and the texture parameters of the most
+    // recently mapped frame, used to predict what the next frame will need
+    PL_ARRAY(struct pool_tex) pool;
+    struct pl_tex_params last_params[4];
+    uint64_t pool_clock;
+    struct pl_queue_pool_stats pool_stats;
+
+    // Frames pushed without taking `lock_weak`
+    struct incoming *incoming;
+
+    // Asynchronous mapping state. The worker threads are guarded by
+    // `lock_weak`, and are woken up via `work`.
+    struct pl_queue_create_params params;
+    pl_thread *workers;
+    int num_workers;
+    pl_cond work;
+    bool quit;
+    int num_busy;
+    size_t mapped_size; // total size of all mapped frames
+    size_t last_size;   // size of the most recently mapped frame
 };
 
-pl_queue pl_queue_create(pl_gpu gpu)
+static PL_THREAD_VOID map_worker(void *priv);
+static void drain_incoming(pl_queue p);
+static void update_room(pl_queue p);
+
+pl_queue pl_queue_create_ex(pl_gpu gpu, const struct pl_queue_create_params *params)
 {
     pl_queue p = pl_alloc_ptr(NULL, p);
     *p = (struct pl_queue) {
         .gpu = gpu,
         .log = gpu->log,
+        .params = *PL_DEF(params, &(struct pl_queue_create_params) {0}),
+        .incoming = pl_alloc_ptr(p, p->incoming),
     };
 
+    struct incoming *in = p->incoming;
+    atomic_init(&in->head, 0);
+    atomic_init(&in->tail, 0);
+    atomic_flag_clear(&in->producing);
+    atomic_init(&in->waiting, false);
+
     pl_mutex_init(&p->lock_strong);
     pl_mutex_init(&p->lock_weak);
     PL_CHECK_ERR(pl_cond_init(&p->wakeup));
+    PL_CHECK_ERR(pl_cond_init(&p->work));
+
+    if (p->params.map_threads && !gpu->limits.thread_safe) {
+        PL_WARN(p, "Asynchronous frame mapping requires a thread-safe GPU, "
+                "ignoring `map_threads`!");
+        p->params.map_threads = 0;
+    }
+
+    if (p->params.map_threads) {
+        p->params.prefetch_frames = PL_DEF(p->params.prefetch_frames,
+                                           ASYNC_PREFETCH_FRAMES);
+        p->workers = pl_calloc_ptr(p, p->params.map_threads, p->workers);
+        for (int i = 0; i < p->params.map_threads; i++) {
+            if (pl_thread_create(&p->workers[i], map_worker, p) != 0) {
+                PL_ERR(p, "Failed creating frame mapping thread!");
+                break;
+            }
+            p->num_workers++;
+        }
+    }
+
+    p->params.prefetch_frames = PL_MAX(p->params.prefetch_frames, PREFETCH_FRAMES);
+    atomic_init(&in->room, p->params.prefetch_frames);
     return p;
 }
 
+pl_queue pl_queue_create(pl_gpu gpu)
+{
+    return pl_queue_create_ex(gpu, NULL);
+}
+
 static inline void unmap_frame(pl_queue p, struct entry *entry)
 {
     if (!entry->mapped && entry->src.discard) {
@@ -124,6 +217,9 @@ static inline void unmap_frame(pl_queue p, struct entry *entry)
                  entry->signature, entry->src.pts);
         entry->src.unmap(p->gpu, &entry->frame, &entry->src);
     }
+
+    p->mapped_size -= entry->size;
+    entry->size = 0;
 }
 
 
@@ -133,6 +229,14 @@ void pl_queue_destroy(pl_queue *queue)
     if (!p)
         return;
 
+    pl_mutex_lock(&p->lock_weak);
+    p->quit = true;
+    pl_cond_broadcast(&p->work);
+    pl_mutex_unlock(&p->lock_weak);
+    for (int i = 0; i < p->num_workers; i++)
+        pl_thread_join(p->workers[i]);
+
+    drain_incoming(p);
     for (int n = 0; n < p->queue.num; n++) {
         struct entry *entry = p->queue.elem[n];
         unmap_frame(p, entry);
@@ -140,11 +244,10 @@ void pl_queue_destroy(pl_queue *queue)
             pl_tex_destroy(p->gpu, &entry->cache.tex[i]);
     }
 
-    for (int n = 0; n < p->cache.num; n++) {
-        for (int i = 0; i < PL_ARRAY_SIZE(p->cache.elem[n].tex); i++)
-            pl_tex_destroy(p->gpu, &p->cache.elem[n].tex[i]);
-    }
+    for (int n = 0; n < p->pool.num; n++)
+        pl_tex_destroy(p->gpu, &p->pool.elem[n].tex);
 
+    pl_cond_destroy(&p->work);
     pl_cond_destroy(&p->wakeup);
     pl_mutex_destroy(&p->lock_weak);
     pl_mutex_destroy(&p->lock_strong);
@@ -152,20 +255,108 @@ void pl_queue_destroy(pl_queue *queue)
     *queue = NULL;
 }
 
-static inline void cull_entry(pl_queue p, struct entry *entry)
+static inline size_t tex_size(pl_tex tex)
 {
-    unmap_frame(p, entry);
+    return (size_t) tex->params.format->texel_size * tex->params.w *
+           PL_MAX(tex->params.h, 1) * PL_MAX(tex->params.d, 1);
+}
+
+// Textures are keyed on their format, size and usage
+static bool tex_matches(pl_tex tex, const struct pl_tex_params *params)
+{
+    const struct pl_tex_params *a = &tex->params;
+    return a->format        == params->format &&
+           a->w             == params->w &&
+           a->h             == params->h &&
+           a->d             == params->d &&
+           a->sampleable    == params->sampleable &&
+           a->renderable    == params->renderable &&
+           a->storable      == params->storable &&
+           a->blit_src      == params->blit_src &&
+           a->blit_dst      == params->blit_dst &&
+           a->host_writable == params->host_writable &&
+           a->host_readable == params->host_readable;
+}
+
+// Evict least recently used textures until the pool fits within its limits
+static void pool_trim(pl_queue p)
+{
+    const size_t budget = p->params.texture_pool_budget;
+    const int max_num = PL_DEF(p->params.texture_pool_size, POOL_TEXTURES);
+    while (p->pool.num > max_num || (budget && p->pool_stats.size > budget)) {
+        int lru = 0;
+        for (int i = 1; i < p->pool.num; i++) {
+            if (p->pool.elem[i].last_used < p->pool.elem[lru].last_used)
+                lru = i;
+        }
 
-    // Recycle non-empty texture cache entries
-    static const struct cache_entry null_cache = {0};
-    if (memcmp(&entry->cache, &null_cache, sizeof(null_cache)) != 0) {
-        for (int i = 0; i < PL_ARRAY_SIZE(entry->cache.tex); i++) {
-            if (entry->cache.tex[i])
-                pl_tex_invalidate(p->gpu, entry->cache.tex[i]);
+        pl_tex tex = p->pool.elem[lru].tex;
+        p->pool_stats.size -= tex_size(tex);
+        p->pool_stats.evictions++;
+        pl_tex_destroy(p->gpu, &tex);
+        PL_ARRAY_REMOVE_AT(p->pool, lru);
+    }
+
+    p->pool_stats.num_textures = p->pool.num;
+}
+
+// Hand out pooled textures matching the previously mapped frame
+static void pool_acquire(pl_queue p, struct entry *entry)
+{
+    for (int i = 0; i < PL_ARRAY_SIZE(entry->cache.tex); i++) {
+        const struct pl_tex_params *params = &p->last_params[i];
+        if (entry->cache.tex[i] || !params->format)
+            continue;
+
+        // Prefer the most recently used texture, which is most likely to
+        // still be resident
+        int best = -1;
+        for (int n = 0; n < p->pool.num; n++) {
+            if (!tex_matches(p->pool.elem[n].tex, params))
+                continue;
+            if (best < 0 || p->pool.elem[n].last_used > p->pool.elem[best].last_used)
+                best = n;
+        }
+
+        if (best >= 0) {
+            entry->cache.tex[i] = p->pool.elem[best].tex;
+            p->pool_stats.size -= tex_size(entry->cache.tex[i]);
+            PL_ARRAY_REMOVE_AT(p->pool, best);
         }
-        PL_ARRAY_APPEND(p, p->cache, entry->cache);
     }
 
+    p->pool_stats.num_textures = p->pool.num;
+}
+
+static void pool_release(pl_queue p, struct entry *entry)
+{
+    for (int i = 0; i < PL_ARRAY_SIZE(entry->cache.tex); i++) {
+        pl_tex tex = entry->cache.tex[i];
+        if (!tex)
+            continue;
+
+        pl_tex_invalidate(p->gpu, tex);
+        PL_ARRAY_APPEND(p, p->pool, (struct pool_tex) {
+            .tex = tex,
+            .last_used = ++p->pool_clock,
+        });
+        p->pool_stats.size += tex_size(tex);
+        entry->cache.tex[i] = NULL;
+    }
+
+    pool_trim(p);
+}
+
+static inline void cull_entry(pl_queue p, struct entry *entry)
+{
+    if (entry->busy) {
+        // Defer to the worker thread currently mapping this frame
+        entry->culled = true;
+        return;
+    }
+
+    unmap_frame(p, entry);
+    pool_release(p, entry);
     pl_free(entry);
 }
 
@@ -174,6 +365,8 @@ void pl_queue_reset(pl_queue p)
     pl_mutex_lock(&p->lock_strong);
     pl_mutex_lock(&p->lock_weak);
 
+    // Also discard any frames still waiting in the incoming ring
+    drain_incoming(p);
     for (int i = 0; i < p->queue.num; i++)
         cull_entry(p, p->queue.elem[i]);
 
@@ -186,16 +379,29 @@ void pl_queue_reset(pl_queue p)
         .lock_weak = p->lock_weak,
         .wakeup = p->wakeup,
 
+        // Preserve async mapping state, including frames still being mapped
+        .params = p->params,
+        .workers = p->workers,
+        .num_workers = p->num_workers,
+        .work = p->work,
+        .num_busy = p->num_busy,
+        .mapped_size = p->mapped_size,
+        .last_size = p->last_size,
+
         // Explicitly preserve allocations
         .queue.elem = p->queue.elem,
         .tmp_sig.elem = p->tmp_sig.elem,
         .tmp_ts.elem = p->tmp_ts.elem,
         .tmp_frame.elem = p->tmp_frame.elem,
+        .incoming = p->incoming,
 
         // Reuse GPU object cache entirely
-        .cache = p->cache,
+        .pool = p->pool,
+        .pool_clock = p->pool_clock,
+        .pool_stats = p->pool_stats,
     };
 
+    update_room(p);
     pl_cond_signal(&p->wakeup);
     pl_mutex_unlock(&p->lock_weak);
     pl_mutex_unlock(&p->lock_strong);
@@ -229,6 +435,24 @@ static inline void update_estimate(struct pool *pool, float cur)
         pool->estimate = pool->sum / pool->num;
 }
 
+// Returns the index of the first frame with a PTS above `pts` (if `upper`),
+// or at least `pts` (otherwise). The queue is always sorted by PTS.
+static int queue_bound(pl_queue p, float pts, bool upper)
+{
+    int lo = 0, hi = p->queue.num;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        float mid_pts = p->queue.elem[mid]->src.pts;
+        if (upper ? mid_pts <= pts : mid_pts < pts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
 static void queue_push(pl_queue p, const struct pl_source_frame *src)
 {
     if (p->eof && !src)
@@ -270,48 +494,120 @@ static void queue_push(pl_queue p, const struct pl_source_frame *src)
         .signature = p->signature++,
         .src = *src,
     };
-    PL_ARRAY_POP(p->cache, &entry->cache);
     PL_TRACE(p, "Added new frame id %"PRIu64" with PTS %f",
              entry->signature, src->pts);
 
-    // Insert new entry into the correct spot in the queue, sorted by PTS
-    for (int i = p->queue.num;; i--) {
-        if (i == 0 || p->queue.elem[i - 1]->src.pts <= src->pts) {
-            PL_ARRAY_INSERT_AT(p, p->queue, i, entry);
-            break;
-        }
-    }
+    // Insert new entry into the correct spot in the queue, sorted by PTS,
+    // after any existing frames with the same PTS
+    int idx = queue_bound(p, src->pts, true);
+    PL_ARRAY_INSERT_AT(p, p->queue, idx, entry);
 
     p->want_frame = false;
+    pl_cond_signal(&p->work);
 }
 
-void pl_queue_push(pl_queue p, const struct pl_source_frame *frame)
+// Move all frames from the incoming ring into the queue. Must be called with
+// `lock_weak` held, which makes this the only consumer.
+static void drain_incoming(pl_queue p)
 {
-    pl_mutex_lock(&p->lock_weak);
-    queue_push(p, frame);
-    pl_mutex_unlock(&p->lock_weak);
+    struct incoming *in = p->incoming;
+    size_t head = atomic_load_explicit(&in->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&in->tail, memory_order_acquire);
+    for (; head != tail; head++) {
+        struct pl_source_frame src = in->frames[head % INCOMING_FRAMES];
+        atomic_store_explicit(&in->head, head + 1, memory_order_release);
+        queue_push(p, src.map ? &src : NULL);
+    }
 }
 
-static bool queue_has_room(pl_queue p)
+// Number of additional frames that may be queued before the queue is judged
+// to be too full
+static int queue_room(pl_queue p)
 {
     if (p->want_frame)
-        return true;
+        return INT_MAX;
 
     // Examine the queue tail
     for (int i = p->queue.num - 1; i >= 0; i--) {
         if (p->queue.elem[i]->mapped)
-            return true;
-        if (p->queue.num - i >= PREFETCH_FRAMES)
-            return false;
+            return p->params.prefetch_frames - (p->queue.num - 1 - i);
+        if (p->queue.num - i >= p->params.prefetch_frames)
+            return 0;
     }
 
-    return true;
+    return p->params.prefetch_frames - p->queue.num;
+}
+
+static inline bool queue_has_room(pl_queue p)
+{
+    return queue_room(p) > 0;
+}
+
+// Publish the current `queue_room` for lock-free producers
+static void update_room(pl_queue p)
+{
+    atomic_store_explicit(&p->incoming->room, queue_room(p), memory_order_relaxed);
+}
+
+// Try pushing a frame without taking `lock_weak`. Fails if the ring is
+// full or contended, or (if `block`) if the queue might not have room.
+static bool push_lockfree(pl_queue p, const struct pl_source_frame *src, bool block)
+{
+    struct incoming *in = p->incoming;
+    if (atomic_flag_test_and_set_explicit(&in->producing, memory_order_acquire))
+        return false;
+
+    size_t tail = atomic_load_explicit(&in->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&in->head, memory_order_acquire);
+    size_t used = tail - head;
+    bool ok = used < INCOMING_FRAMES;
+    if (ok && block && src)
+        ok = used < atomic_load_explicit(&in->room, memory_order_relaxed);
+
+    if (ok) {
+        in->frames[tail % INCOMING_FRAMES] = src ? *src : (struct pl_source_frame) {0};
+        atomic_store(&in->tail, tail + 1);
+    }
+
+    atomic_flag_clear_explicit(&in->producing, memory_order_release);
+
+    // Make sure a consumer blocked waiting for frames gets woken up. This is
+    // a store to `tail` followed by a load of `waiting`, while the consumer
+    // stores `waiting` and then loads `tail`, so both sides need a full fence
+    // in between. Pairs with the fence in `get_frame`.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (ok && atomic_load_explicit(&in->waiting, memory_order_relaxed)) {
+        pl_mutex_lock(&p->lock_weak);
+        pl_cond_signal(&p->wakeup);
+        pl_mutex_unlock(&p->lock_weak);
+    }
+
+    return ok;
+}
+
+static void push_locked(pl_queue p, const struct pl_source_frame *frame)
+{
+    pl_mutex_lock(&p->lock_weak);
+    drain_incoming(p); // preserve ordering relative to earlier pushes
+    queue_push(p, frame);
+    update_room(p);
+    pl_mutex_unlock(&p->lock_weak);
+}
+
+void pl_queue_push(pl_queue p, const struct pl_source_frame *frame)
+{
+    if (!push_lockfree(p, frame, false))
+        push_locked(p, frame);
 }
 
 bool pl_queue_push_block(pl_queue p, uint64_t timeout,
                          const struct pl_source_frame *frame)
 {
+    if (push_lockfree(p, frame, true))
+        return true;
+
     pl_mutex_lock(&p->lock_weak);
+    drain_incoming(p);
     if (!timeout || !frame || p->eof)
         goto skip_blocking;
 
@@ -320,11 +616,13 @@ bool pl_queue_push_block(pl_queue p, uint64_t timeout,
             pl_mutex_unlock(&p->lock_weak);
             return false;
         }
+        drain_incoming(p);
     }
 
 skip_blocking:
 
     queue_push(p, frame);
+    update_room(p);
     pl_mutex_unlock(&p->lock_weak);
     return true;
 }
@@ -361,13 +659,26 @@ static enum pl_queue_status get_frame(pl_queue p, const struct pl_queue_params *
             return PL_QUEUE_MORE;
 
         p->want_frame = true;
+        update_room(p);
         pl_cond_signal(&p->wakeup);
 
+        // Pairs with the fence in `push_lockfree`: either the producer sees
+        // this flag, or we see its frame while draining
+        struct incoming *in = p->incoming;
+        atomic_store_explicit(&in->waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        drain_incoming(p);
         while (p->want_frame) {
-            if (pl_cond_timedwait(&p->wakeup, &p->lock_weak, params->timeout) == ETIMEDOUT)
+            if (pl_cond_timedwait(&p->wakeup, &p->lock_weak, params->timeout) == ETIMEDOUT) {
+                atomic_store(&in->waiting, false);
+                update_room(p);
                 return PL_QUEUE_MORE;
+            }
+            drain_incoming(p);
         }
 
+        atomic_store(&in->waiting, false);
+        update_room(p);
         return p->eof ? PL_QUEUE_EOF : PL_QUEUE_OK;
     }
 
@@ -379,10 +690,10 @@ static enum pl_queue_status get_frame(pl_queue p, const struct pl_queue_params *
     enum pl_queue_status ret;
     switch ((ret = params->get_frame(&src, params))) {
     case PL_QUEUE_OK:
-        pl_queue_push(p, &src);
+        push_locked(p, &src);
         break;
     case PL_QUEUE_EOF:
-        pl_queue_push(p, NULL);
+        push_locked(p, NULL);
         break;
     case PL_QUEUE_MORE:
     case PL_QUEUE_ERR:
@@ -393,22 +704,156 @@ static enum pl_queue_status get_frame(pl_queue p, const struct pl_queue_params *
     return ret;
 }
 
+static size_t frame_size(const struct pl_frame *frame)
+{
+    size_t size = 0;
+    for (int i = 0; i < frame->num_planes; i++) {
+        pl_tex tex = frame->planes[i].texture;
+        if (tex)
+            size += tex_size(tex);
+    }
+
+    return size;
+}
+
+static void map_done(pl_queue p, struct entry *entry,
+                     const struct cache_entry *given, bool ok)
+{
+    entry->mapped = true;
+    entry->ok = ok;
+
+    // Textures that `map` had to (re)create are pool misses. Also remember
+    // the texture parameters, so the next frame can be given matching ones.
+    for (int i = 0; i < PL_ARRAY_SIZE(entry->cache.tex); i++) {
+        pl_tex tex = entry->cache.tex[i];
+        if (!ok)
+            continue;
+        if (!tex) {
+            p->last_params[i] = (struct pl_tex_params) {0};
+            continue;
+        }
+
+        if (tex == given->tex[i]) {
+            p->pool_stats.hits++;
+        } else {
+            p->pool_stats.misses++;
+        }
+
+        const struct pl_tex_params *params = &tex->params;
+        p->last_params[i] = (struct pl_tex_params) {
+            .w              = params->w,
+            .h              = params->h,
+            .d              = params->d,
+            .format         = params->format,
+            .sampleable     = params->sampleable,
+            .renderable     = params->renderable,
+            .storable       = params->storable,
+            .blit_src       = params->blit_src,
+            .blit_dst       = params->blit_dst,
+            .host_writable  = params->host_writable,
+            .host_readable  = params->host_readable,
+        };
+    }
+
+    if (!ok) {
+        PL_ERR(p, "Failed mapping frame id %"PRIu64" with PTS %f",
+               entry->signature, entry->src.pts);
+        return;
+    }
+
+    entry->size = frame_size(&entry->frame);
+    p->mapped_size += entry->size;
+    p->last_size = entry->size;
+}
+
 static bool map_frame(pl_queue p, struct entry *entry)
 {
+    // Wait for the worker thread to finish mapping this frame
+    while (entry->busy)
+        pl_cond_wait(&p->wakeup, &p->lock_weak);
+
     if (!entry->mapped) {
         PL_TRACE(p, "Mapping frame id %"PRIu64" with PTS %f",
                  entry->signature, entry->src.pts);
-        entry->mapped = true;
-        entry->ok = entry->src.map(p->gpu, entry->cache.tex,
-                                   &entry->src, &entry->frame);
-        if (!entry->ok)
-            PL_ERR(p, "Failed mapping frame id %"PRIu64" with PTS %f",
-                   entry->signature, entry->src.pts);
+        pool_acquire(p, entry);
+        const struct cache_entry given = entry->cache;
+        bool ok = entry->src.map(p->gpu, entry->cache.tex, &entry->src,
+                                 &entry->frame);
+        map_done(p, entry, &given, ok);
     }
 
     return entry->ok;
 }
 
+// Returns the next frame that should be mapped ahead of time, if any
+static struct entry *next_prefetch(pl_queue p)
+{
+    const size_t budget = p->params.memory_budget;
+    const size_t pending = (p->num_busy + 1) * p->last_size;
+    if (budget && p->mapped_size + pending > budget)
+        return NULL;
+
+    const int num = PL_MIN(p->queue.num, p->params.prefetch_frames);
+    for (int i = 0; i < num; i++) {
+        struct entry *entry = p->queue.elem[i];
+        if (!entry->mapped && !entry->busy)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static PL_THREAD_VOID map_worker(void *priv)
+{
+    pl_queue p = priv;
+    pl_mutex_lock(&p->lock_weak);
+    while (!p->quit) {
+        struct entry *entry = next_prefetch(p);
+        if (!entry) {
+            pl_cond_wait(&p->work, &p->lock_weak);
+            continue;
+        }
+
+        PL_TRACE(p, "Mapping frame id %"PRIu64" with PTS %f asynchronously",
+                 entry->signature, entry->src.pts);
+        entry->busy = true;
+        p->num_busy++;
+        pool_acquire(p, entry);
+        const struct cache_entry given = entry->cache;
+        pl_mutex_unlock(&p->lock_weak);
+
+        bool ok = entry->src.map(p->gpu, entry->cache.tex, &entry->src,
+                                 &entry->frame);
+
+        pl_mutex_lock(&p->lock_weak);
+        entry->busy = false;
+        p->num_busy--;
+        map_done(p, entry, &given, ok);
+        if (entry->culled)
+            cull_entry(p, entry);
+        update_room(p);
+        pl_cond_broadcast(&p->wakeup);
+    }
+
+    pl_mutex_unlock(&p->lock_weak);
+    PL_THREAD_RETURN();
+}
+
+// Whether a frame may be included in a frame mix without blocking
+static inline bool frame_ready(pl_queue p, const struct entry *entry)
+{
+    return !p->num_workers || (entry->mapped && !entry->busy);
+}
+
+// Cull all frames except the last frame before `pts`
+static void cull_before(pl_queue p, float pts)
+{
+    int culled = PL_MAX(queue_bound(p, pts, true) - 1, 0);
+    for (int i = 0; i < culled; i++)
+        cull_entry(p, p->queue.elem[i]);
+    PL_ARRAY_REMOVE_RANGE(p->queue, 0, culled);
+}
+
 // Advance the queue as needed to make sure idx 0 is the last frame before
 // `pts`, and idx 1 is the first frame after `pts` (unless this is the last).
 //
@@ -416,34 +861,27 @@ static bool map_frame(pl_queue p, struct entry *entry)
 static enum pl_queue_status advance(pl_queue p, float pts,
                                     const struct pl_queue_params *params)
 {
-    // Cull all frames except the last frame before `pts`
-    int culled = 0;
-    for (int i = 1; i < p->queue.num; i++) {
-        if (p->queue.elem[i]->src.pts <= pts) {
-            cull_entry(p, p->queue.elem[i - 1]);
-            culled++;
-        }
-    }
-    PL_ARRAY_REMOVE_RANGE(p->queue, 0, culled);
+    cull_before(p, pts);
 
     // Keep adding new frames until we find one in the future, or EOF
     while (p->queue.num < 2) {
-        enum pl_queue_status ret;
-        switch ((ret = get_frame(p, params))) {
-        case PL_QUEUE_ERR:
+        enum pl_queue_status ret = get_frame(p, params);
+        if (ret == PL_QUEUE_ERR)
             return ret;
+
+        // Several frames may have arrived at once, possibly followed by EOF
+        cull_before(p, pts);
+
+        switch (ret) {
+        case PL_QUEUE_ERR:
+            pl_unreachable();
         case PL_QUEUE_EOF:
             if (!p->queue.num)
                 return ret;
             goto done;
         case PL_QUEUE_MORE:
+            return ret;
         case PL_QUEUE_OK:
-            while (p->queue.num > 1 && p->queue.elem[1]->src.pts <= pts) {
-                cull_entry(p, p->queue.elem[0]);
-                PL_ARRAY_REMOVE_AT(p->queue, 0);
-            }
-            if (ret == PL_QUEUE_MORE)
-                return ret;
             continue;
         }
     }
@@ -474,20 +912,18 @@ done:
 static inline enum pl_queue_status point(pl_queue p, struct pl_frame_mix *mix,
                                          const struct pl_queue_params *params)
 {
-    // Find closest frame (nearest neighbour semantics)
+    // Find closest frame (nearest neighbour semantics), preferring the
+    // earlier frame in the event of a tie
     pl_assert(p->queue.num);
-    struct entry *entry = p->queue.elem[0];
-    double best = fabs(entry->src.pts - params->pts);
-    for (int i = 1; i < p->queue.num; i++) {
-        double dist = fabs(p->queue.elem[i]->src.pts - params->pts);
-        if (dist < best) {
-            entry = p->queue.elem[i];
-            best = dist;
-            continue;
-        } else {
-            break;
-        }
+    int idx = queue_bound(p, params->pts, false);
+    if (idx == p->queue.num || (idx > 0 &&
+        params->pts - p->queue.elem[idx - 1]->src.pts <=
+        p->queue.elem[idx]->src.pts - params->pts))
+    {
+        // Use the first of possibly several frames with the same PTS
+        idx = queue_bound(p, p->queue.elem[idx - 1]->src.pts, false);
     }
+    struct entry *entry = p->queue.elem[idx];
 
     if (!map_frame(p, entry))
         return PL_QUEUE_ERR;
@@ -680,6 +1116,10 @@ done: ;
         struct entry *entry = p->queue.elem[i];
         if (entry->src.pts > max_pts)
             break;
+        // Stop at the first frame not yet mapped (unless it's required), so
+        // the mix stays a contiguous run of frames
+        if (p->tmp_frame.num && !frame_ready(p, entry))
+            break;
         if (!map_frame(p, entry))
             return PL_QUEUE_ERR;
 
@@ -746,6 +1186,7 @@ enum pl_queue_status pl_queue_update(pl_queue p, struct pl_frame_mix *out_mix,
 {
     pl_mutex_lock(&p->lock_strong);
     pl_mutex_lock(&p->lock_weak);
+    drain_incoming(p);
     default_estimate(&p->fps, params->frame_duration);
     default_estimate(&p->vps, params->vsync_duration);
 
@@ -804,8 +1245,17 @@ enum pl_queue_status pl_queue_update(pl_queue p, struct pl_frame_mix *out_mix,
         ret = nearest(p, out_mix, params);
     }
 
+    update_room(p);
     pl_cond_signal(&p->wakeup);
+    pl_cond_broadcast(&p->work);
     pl_mutex_unlock(&p->lock_weak);
     pl_mutex_unlock(&p->lock_strong);
     return ret;
 }
+
+void pl_queue_pool_stats(pl_queue p, struct pl_queue_pool_stats *out_stats)
+{
+    pl_mutex_lock(&p->lock_weak);
+    *out_stats = p->pool_stats;
+    pl_mutex_unlock(&p->lock_weak);
+}
@@ -0,0 +1,213 @@
+/*
+ * This file is part of libplacebo.
+ *
+ * libplacebo is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplacebo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplacebo. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "log.h"
+
+// A single frame in flight. The source textures are recycled between frames
+// submitted to the same slot, like the texture cache of `pl_queue`.
+struct slot {
+    pl_throughput tp;
+    pl_tex src_tex[4];
+    pl_tex fbo;
+
+    struct pl_throughput_frame frame;
+    struct pl_frame image;
+    bool mapped;
+    bool busy; // download still in flight
+};
+
+struct pl_throughput {
+    pl_gpu gpu;
+    struct pl_throughput_params params;
+    struct pl_throughput_stats stats;
+
+    struct slot slots[PL_THROUGHPUT_MAX_FRAMES];
+    int num_slots;
+    int idx;
+};
+
+pl_throughput pl_throughput_create(pl_gpu gpu, const struct pl_throughput_params *params)
+{
+    pl_fmt fmt = params->format;
+    if (!params->renderer || !fmt || !params->width || !params->height) {
+        PL_ERR(gpu, "Missing required parameters for pl_throughput!");
+        return NULL;
+    }
+
+    if (!(fmt->caps & PL_FMT_CAP_RENDERABLE) || !(fmt->caps & PL_FMT_CAP_HOST_READABLE)) {
+        PL_ERR(gpu, "Format '%s' is not renderable and host-readable!", fmt->name);
+        return NULL;
+    }
+
+    pl_throughput tp = pl_zalloc_ptr(NULL, tp);
+    tp->gpu = gpu;
+    tp->params = *params;
+    tp->num_slots = PL_DEF(params->frames_in_flight, 3);
+    tp->num_slots = PL_CLAMP(tp->num_slots, 1, PL_THROUGHPUT_MAX_FRAMES);
+
+    for (int i = 0; i < tp->num_slots; i++) {
+        struct slot *slot = &tp->slots[i];
+        slot->tp = tp;
+        slot->fbo = pl_tex_create(gpu, pl_tex_params(
+            .format         = fmt,
+            .w              = params->width,
+            .h              = params->height,
+            .renderable     = true,
+            .host_readable  = true,
+            .blit_dst       = !!(fmt->caps & PL_FMT_CAP_BLITTABLE),
+            .storable       = !!(fmt->caps & PL_FMT_CAP_STORABLE),
+        ));
+
+        if (!slot->fbo) {
+            PL_ERR(gpu, "Failed creating output texture for pl_throughput!");
+            pl_throughput_destroy(&tp);
+            return NULL;
+        }
+    }
+
+    return tp;
+}
+
+static void slot_complete(struct slot *slot, bool ok)
+{
+    pl_throughput tp = slot->tp;
+    if (ok) {
+        tp->stats.completed++;
+    } else {
+        tp->stats.failed++;
+    }
+
+    if (slot->frame.done)
+        slot->frame.done(slot->frame.priv, ok);
+}
+
+static void download_cb(void *priv)
+{
+    struct slot *slot = priv;
+    slot->busy = false;
+    slot_complete(slot, true);
+}
+
+// Wait until the frame in this slot has been fully downloaded, and release
+// its source frame
+static void slot_wait(pl_throughput tp, struct slot *slot)
+{
+    pl_gpu gpu = tp->gpu;
+    while (slot->busy && pl_tex_poll(gpu, slot->fbo, UINT64_MAX))
+        ; // do nothing
+
+    // Should be unreachable in practice, but guarantees forward progress in
+    // case the texture was idle before the callback got dispatched
+    if (slot->busy)
+        pl_gpu_finish(gpu);
+    pl_assert(!slot->busy);
+
+    if (slot->mapped && slot->frame.src.unmap)
+        slot->frame.src.unmap(gpu, &slot->image, &slot->frame.src);
+    slot->mapped = false;
+}
+
+void pl_throughput_destroy(pl_throughput *ptp)
+{
+    pl_throughput tp = *ptp;
+    if (!tp)
+        return;
+
+    pl_throughput_drain(tp);
+    for (int i = 0; i < tp->num_slots; i++) {
+        struct slot *slot = &tp->slots[i];
+        for (int n = 0; n < PL_ARRAY_SIZE(slot->src_tex); n++)
+            pl_tex_destroy(tp->gpu, &slot->src_tex[n]);
+        pl_tex_destroy(tp->gpu, &slot->fbo);
+    }
+
+    pl_free_ptr(ptp);
+}
+
+bool pl_throughput_submit(pl_throughput tp, const struct pl_throughput_frame *frame)
+{
+    pl_gpu gpu = tp->gpu;
+    const struct pl_throughput_params *params = &tp->params;
+    struct slot *slot = &tp->slots[tp->idx];
+    tp->idx = (tp->idx + 1) % tp->num_slots;
+
+    slot_wait(tp, slot);
+    slot->frame = *frame;
+    slot->image = (struct pl_frame) {0};
+    if (!frame->src.map(gpu, slot->src_tex, &slot->frame.src, &slot->image)) {
+        PL_ERR(gpu, "Failed mapping source frame!");
+        goto error;
+    }
+    slot->mapped = true;
+
+    struct pl_frame target = {
+        .num_planes = 1,
+        .planes[0] = {
+            .texture = slot->fbo,
+            .components = params->format->num_components,
+            .component_mapping = {0, 1, 2, 3},
+        },
+        .repr = params->repr,
+        .color = params->color,
+    };
+
+    if (!pl_render_image(params->renderer, &slot->image, &target,
+                         params->render_params))
+        goto error;
+
+    // Fall back to a blocking download if the GPU doesn't support callbacks
+    bool async = gpu->limits.callbacks;
+    slot->busy = async;
+    bool ok = pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex        = slot->fbo,
+        .ptr        = frame->out_ptr,
+        .row_pitch  = frame->row_pitch,
+        .callback   = async ? download_cb : NULL,
+        .priv       = slot,
+    ));
+
+    if (!ok) {
+        slot->busy = false;
+        goto error;
+    }
+
+    tp->stats.submitted++;
+    if (!async)
+        slot_complete(slot, true);
+
+    // Make sure the GPU starts working on this frame while we prepare the
+    // next one
+    pl_gpu_flush(gpu);
+    return true;
+
+error:
+    slot_complete(slot, false);
+    return false;
+}
+
+void pl_throughput_drain(pl_throughput tp)
+{
+    // Wait for slots in submission order, starting with the oldest
+    for (int i = 0; i < tp->num_slots; i++)
+        slot_wait(tp, &tp->slots[(tp->idx + i) % tp->num_slots]);
+}
+
+void pl_throughput_stats(pl_throughput tp, struct pl_throughput_stats *out_stats)
+{
+    *out_stats = tp->stats;
+}
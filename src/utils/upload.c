@@ -20,6 +20,7 @@
 #include "log.h"
 #include "common.h"
 #include "gpu.h"
+#include "shaders.h"
 
 #define MAX_COMPS 4
 
@@ -201,18 +202,228 @@ next_fmt: ; // acts as `continue`
     return NULL;
 }
 
+// Fallback for formats with no matching texture format, e.g. packed 10-bit
+// formats like X2RGB10, or 24-bit RGB on GPUs without 3-component formats.
+// The data is unpacked (either on the CPU, or by a compute shader) into the
+// smallest UNORM format with byte-aligned components of uniform depth (8 or
+// 16 bits), and padded with unused components if necessary.
+struct repack {
+    pl_fmt fmt;
+    int depth;                      // bits per output component
+    int num_comps;                  // number of unpacked source components
+    int shift[MAX_COMPS];           // bit offset of each source component
+    int size[MAX_COMPS];            // size in bits of each source component
+    uint16_t *lut[MAX_COMPS];       // expansion LUT, or NULL if not needed
+};
+
+// Largest component size to expand via LUT rather than bit replication
+#define REPACK_LUT_BITS 10
+
+static pl_fmt find_repack_fmt(pl_gpu gpu, int out_map[4], struct repack *rp,
+                              const struct pl_plane_data *data,
+                              enum pl_fmt_caps caps)
+{
+    if (data->type != PL_FMT_UNORM || data->pixel_stride > sizeof(uint64_t))
+        return NULL;
+
+    int num = 0, offset = 0, max_size = 0;
+    for (int i = 0; i < MAX_COMPS; i++) {
+        if (!data->component_size[i])
+            continue;
+        offset += data->component_pad[i];
+        rp->shift[num] = offset;
+        rp->size[num] = data->component_size[i];
+        out_map[num++] = data->component_map[i];
+        offset += data->component_size[i];
+        max_size = PL_MAX(max_size, data->component_size[i]);
+    }
+
+    if (!num || offset > data->pixel_stride * 8 || max_size > 16)
+        return NULL;
+
+    const int depth = max_size > 8 ? 16 : 8;
+    pl_fmt best = NULL;
+    for (int n = 0; n < gpu->num_formats; n++) {
+        pl_fmt fmt = gpu->formats[n];
+        if (fmt->opaque || fmt->type != PL_FMT_UNORM || fmt->num_components < num)
+            continue;
+        if ((fmt->caps & caps) != caps)
+            continue;
+        if (fmt->texel_size * 8 != fmt->num_components * depth)
+            continue;
+        for (int c = 0; c < fmt->num_components; c++) {
+            if (fmt->host_bits[c] != depth || fmt->sample_order[c] != c)
+                goto next_fmt;
+        }
+        if (!best || fmt->num_components < best->num_components)
+            best = fmt;
+next_fmt: ;
+    }
+
+    if (!best)
+        return NULL;
+
+    for (int i = num; i < MAX_COMPS; i++)
+        out_map[i] = -1;
+    rp->fmt = best;
+    rp->depth = depth;
+    rp->num_comps = num;
+    return best;
+}
+
+static void repack_init_luts(struct repack *rp, void *alloc)
+{
+    const uint32_t out_max = (1u << rp->depth) - 1;
+    for (int c = 0; c < rp->num_comps; c++) {
+        const int size = rp->size[c];
+        if (size == rp->depth || size > REPACK_LUT_BITS)
+            continue;
+
+        const uint32_t in_max = (1u << size) - 1;
+        rp->lut[c] = pl_alloc(alloc, (in_max + 1) * sizeof(uint16_t));
+        for (uint32_t v = 0; v <= in_max; v++)
+            rp->lut[c][v] = (v * out_max + in_max / 2) / in_max;
+    }
+}
+
+// Expand by bit replication, for components too large for a LUT
+static inline uint32_t expand_bits(uint32_t v, int size, int depth)
+{
+    return (v << (depth - size)) | (v >> (2 * size - depth));
+}
+
+static inline uint32_t repack_comp(const struct repack *rp, int c, uint64_t px)
+{
+    uint32_t v = (px >> rp->shift[c]) & ((1u << rp->size[c]) - 1);
+    if (rp->lut[c])
+        return rp->lut[c][v];
+    if (rp->size[c] != rp->depth)
+        return expand_bits(v, rp->size[c], rp->depth);
+    return v;
+}
+
+// Fast path for byte-aligned 8-bit components, which is a pure byte shuffle
+static void repack_row_bytes(const struct repack *rp, uint8_t *restrict dst,
+                             const uint8_t *restrict src, int width,
+                             size_t src_stride, int dst_comps)
+{
+    int offsets[MAX_COMPS];
+    for (int c = 0; c < rp->num_comps; c++)
+        offsets[c] = rp->shift[c] >> 3;
+
+    for (int x = 0; x < width; x++) {
+        for (int c = 0; c < rp->num_comps; c++)
+            dst[c] = src[offsets[c]];
+        for (int c = rp->num_comps; c < dst_comps; c++)
+            dst[c] = 0;
+        src += src_stride;
+        dst += dst_comps;
+    }
+}
+
+static void repack_row(const struct repack *rp, uint8_t *restrict dst,
+                       const uint8_t *restrict src, int width,
+                       size_t src_stride, int dst_comps)
+{
+    uint16_t *dst16 = (uint16_t *) dst;
+    for (int x = 0; x < width; x++) {
+        uint64_t px = 0;
+        memcpy(&px, src, src_stride);
+        if (rp->depth == 16) {
+            for (int c = 0; c < rp->num_comps; c++)
+                dst16[c] = repack_comp(rp, c, px);
+            for (int c = rp->num_comps; c < dst_comps; c++)
+                dst16[c] = 0;
+            dst16 += dst_comps;
+        } else {
+            for (int c = 0; c < rp->num_comps; c++)
+                dst[c] = repack_comp(rp, c, px);
+            for (int c = rp->num_comps; c < dst_comps; c++)
+                dst[c] = 0;
+            dst += dst_comps;
+        }
+        src += src_stride;
+    }
+}
+
+static bool upload_repacked(pl_gpu gpu, pl_tex tex, struct repack *rp,
+                            const struct pl_plane_data *data)
+{
+    if (!data->pixels) {
+        PL_ERR(gpu, "Software repacking requires `pl_plane_data.pixels`!");
+        return false;
+    }
+
+    void *tmp = pl_tmp(NULL);
+    const size_t src_stride = PL_DEF(data->row_stride, data->width * data->pixel_stride);
+    const size_t dst_stride = data->width * rp->fmt->texel_size;
+    const size_t size = dst_stride * data->height;
+
+    // Write directly into a mapped staging buffer, if possible, to avoid an
+    // extra memcpy in `pl_tex_upload`. These are recycled through the buffer
+    // pool, since repacked planes are typically uploaded once per frame.
+    pl_buf buf = NULL;
+    if (gpu->limits.buf_transfer && size <= gpu->limits.max_mapped_size) {
+        buf = pl_buf_pool_get(gpu, pl_buf_params(
+            .size = size,
+            .host_mapped = true,
+        ));
+    }
+
+    uint8_t *dst = buf ? buf->data : pl_alloc(tmp, size);
+    repack_init_luts(rp, tmp);
+
+    bool bytes = rp->depth == 8;
+    for (int c = 0; c < rp->num_comps; c++)
+        bytes &= rp->size[c] == 8 && rp->shift[c] % 8 == 0;
+
+    const uint8_t *src = data->pixels;
+    for (int y = 0; y < data->height; y++) {
+        uint8_t *dst_row = dst + y * dst_stride;
+        const uint8_t *src_row = src + y * src_stride;
+        if (bytes) {
+            repack_row_bytes(rp, dst_row, src_row, data->width,
+                             data->pixel_stride, rp->fmt->num_components);
+        } else {
+            repack_row(rp, dst_row, src_row, data->width,
+                       data->pixel_stride, rp->fmt->num_components);
+        }
+    }
+
+    // The source data is no longer needed past this point
+    if (data->callback)
+        data->callback(data->priv);
+
+    bool ok = pl_tex_upload(gpu, pl_tex_transfer_params(
+        .tex = tex,
+        .buf = buf,
+        .ptr = buf ? NULL : dst,
+    ));
+
+    pl_buf_pool_put(gpu, &buf);
+    pl_free(tmp);
+    return ok;
+}
+
 bool pl_upload_plane(pl_gpu gpu, struct pl_plane *out_plane,
                      pl_tex *tex, const struct pl_plane_data *data)
 {
     pl_assert(!data->buf ^ !data->pixels); // exactly one
 
     int out_map[4];
+    struct repack rp = {0};
     pl_fmt fmt = pl_plane_find_fmt(gpu, out_map, data);
+    if (!fmt && data->pixels) {
+        fmt = find_repack_fmt(gpu, out_map, &rp, data, PL_FMT_CAP_SAMPLEABLE);
+        if (fmt) {
+            PL_DEBUG(gpu, "No texture format matches plane data, repacking "
+                     "to '%s' on the CPU", fmt->name);
+        }
+    }
+
     if (!fmt) {
         PL_ERR(gpu, "Failed picking any compatible texture format for a plane!");
         return false;
-
-        // TODO: try soft-converting to a supported format using e.g zimg?
     }
 
     bool ok = pl_tex_recreate(gpu, tex, pl_tex_params(
@@ -239,6 +450,9 @@ bool pl_upload_plane(pl_gpu gpu, struct pl_plane *out_plane,
         }
     }
 
+    if (rp.fmt)
+        return upload_repacked(gpu, *tex, &rp, data);
+
     return pl_tex_upload(gpu, pl_tex_transfer_params(
         .tex        = *tex,
         .row_pitch  = data->row_stride,
@@ -250,6 +464,516 @@ bool pl_upload_plane(pl_gpu gpu, struct pl_plane *out_plane,
     ));
 }
 
+// Uploads raw packed data as-is into a storage buffer. The size is padded to
+// a whole number of words, since the unpacking shaders operate on 32-bit
+// words. The padding is left uninitialized, and never affects the result.
+static pl_buf upload_raw(pl_gpu gpu, const void *pixels, size_t size)
+{
+    pl_buf buf = pl_buf_create(gpu, pl_buf_params(
+        .size = PL_ALIGN2(size, sizeof(uint32_t)),
+        .storable = true,
+        .host_writable = true,
+        .debug_tag = PL_DEBUG_TAG,
+    ));
+
+    if (!buf) {
+        PL_ERR(gpu, "Failed creating buffer for packed plane data!");
+        return NULL;
+    }
+
+    pl_buf_write(gpu, buf, 0, pixels, size);
+    return buf;
+}
+
+// Binds `buf` as an SSBO of 32-bit `words`
+static bool unpack_bind_words(pl_shader sh, pl_buf buf)
+{
+    struct pl_shader_desc desc = {
+        .desc = {
+            .name   = "PackedData",
+            .type   = PL_DESC_BUF_STORAGE,
+            .access = PL_DESC_ACCESS_READONLY,
+        },
+        .binding.object = buf,
+    };
+
+    struct pl_var words = pl_var_uint("words");
+    words.dim_a = buf->params.size / sizeof(uint32_t);
+    if (!sh_buf_desc_append(SH_TMP(sh), SH_GPU(sh), &desc, NULL, words)) {
+        SH_FAIL(sh, "Packed plane data exhausts device limits!");
+        return false;
+    }
+
+    sh_desc(sh, desc);
+    return true;
+}
+
+// Emits a compute shader unpacking one pixel of `data` (bound as an SSBO of
+// 32-bit words) per invocation, and writing it to `out`
+static bool unpack_plane_sh(pl_shader sh, pl_tex out, pl_buf buf,
+                            const struct repack *rp,
+                            const struct pl_plane_data *data)
+{
+    if (!sh_try_compute(sh, 16, 16, false, 0)) {
+        SH_FAIL(sh, "Unpacking plane data requires compute shaders!");
+        return false;
+    }
+
+    if (!unpack_bind_words(sh, buf))
+        return false;
+    const size_t num_words = buf->params.size / sizeof(uint32_t);
+
+    ident_t img = sh_desc(sh, (struct pl_shader_desc) {
+        .binding.object = out,
+        .desc = {
+            .name   = "image",
+            .type   = PL_DESC_STORAGE_IMG,
+            .access = PL_DESC_ACCESS_WRITEONLY,
+        },
+    });
+
+    const size_t row_stride = PL_DEF(data->row_stride, data->width * data->pixel_stride);
+    sh_describe(sh, "unpacking");
+    GLSL("// unpack_plane_sh                                                  \n"
+         "ivec2 pos = ivec2(gl_GlobalInvocationID);                           \n"
+         "if (pos.x >= %d || pos.y >= %d)                                     \n"
+         "    return;                                                         \n"
+         "uint offset = %s + uint(pos.y) * %s + uint(pos.x) * %s;             \n"
+         "uint idx = offset >> 2u;                                            \n"
+         "uint shift = (offset & 3u) << 3u;                                   \n"
+         "uint w0 = words[idx],                                               \n"
+         "     w1 = words[min(idx + 1u, %zuu)],                               \n"
+         "     w2 = words[min(idx + 2u, %zuu)];                               \n"
+         "uint lo = w0, hi = w1;                                              \n"
+         "if (shift != 0u) {                                                  \n"
+         "    lo = (w0 >> shift) | (w1 << (32u - shift));                     \n"
+         "    hi = (w1 >> shift) | (w2 << (32u - shift));                     \n"
+         "}                                                                   \n"
+         "vec4 color = vec4(0.0);                                             \n",
+         data->width, data->height,
+         SH_UINT(data->buf_offset), SH_UINT(row_stride),
+         SH_UINT(data->pixel_stride), num_words - 1, num_words - 1);
+
+    for (int c = 0; c < rp->num_comps; c++) {
+        const int off = rp->shift[c], size = rp->size[c];
+        const unsigned mask = (1u << size) - 1;
+        if (off + size <= 32) {
+            GLSL("color[%d] = float((lo >> %du) & %uu); \n", c, off, mask);
+        } else if (off >= 32) {
+            GLSL("color[%d] = float((hi >> %du) & %uu); \n", c, off - 32, mask);
+        } else {
+            GLSL("color[%d] = float(((lo >> %du) | (hi << %du)) & %uu); \n",
+                 c, off, 32 - off, mask);
+        }
+        GLSL("color[%d] *= %s; \n", c, SH_FLOAT(1.0 / mask));
+    }
+
+    GLSL("imageStore(%s, pos, color); \n", img);
+    return true;
+}
+
+bool pl_upload_plane_unpack(pl_gpu gpu, pl_dispatch dp, struct pl_plane *out_plane,
+                            pl_tex *tex, const struct pl_plane_data *data)
+{
+    pl_assert(!data->buf ^ !data->pixels); // exactly one
+
+    // Prefer direct uploads whenever possible
+    if (pl_plane_find_fmt(gpu, NULL, data))
+        return pl_upload_plane(gpu, out_plane, tex, data);
+
+    int out_map[4];
+    struct repack rp = {0};
+    const enum pl_fmt_caps caps = PL_FMT_CAP_SAMPLEABLE | PL_FMT_CAP_STORABLE;
+    pl_fmt fmt = find_repack_fmt(gpu, out_map, &rp, data, caps);
+    const size_t row_stride = PL_DEF(data->row_stride, data->width * data->pixel_stride);
+    const size_t size = PL_ALIGN2(row_stride * data->height, sizeof(uint32_t));
+    const size_t ssbo_size = data->buf ? data->buf->params.size : size;
+    if (!fmt || !gpu->glsl.compute || ssbo_size > gpu->limits.max_ssbo_size) {
+        // Fall back to repacking on the CPU
+        return pl_upload_plane(gpu, out_plane, tex, data);
+    }
+
+    pl_buf buf = data->buf;
+    if (buf && (!buf->params.storable || data->buf_offset % sizeof(uint32_t))) {
+        PL_ERR(gpu, "Packed plane data buffers must be storable, with an "
+               "offset aligned to 4 bytes!");
+        return false;
+    }
+
+    if (!buf) {
+        buf = upload_raw(gpu, data->pixels, row_stride * data->height);
+        if (data->callback)
+            data->callback(data->priv);
+        if (!buf)
+            return false;
+    }
+
+    bool ok = pl_tex_recreate(gpu, tex, pl_tex_params(
+        .w = data->width,
+        .h = data->height,
+        .format = fmt,
+        .sampleable = true,
+        .storable = true,
+        .host_readable = fmt->caps & PL_FMT_CAP_HOST_READABLE,
+        .blit_src = fmt->caps & PL_FMT_CAP_BLITTABLE,
+    ));
+
+    if (!ok) {
+        PL_ERR(gpu, "Failed initializing plane texture!");
+        goto done;
+    }
+
+    if (out_plane) {
+        out_plane->texture = *tex;
+        out_plane->components = 0;
+        for (int i = 0; i < PL_ARRAY_SIZE(out_map); i++) {
+            out_plane->component_mapping[i] = out_map[i];
+            if (out_map[i] >= 0)
+                out_plane->components = i+1;
+        }
+    }
+
+    pl_shader sh = pl_dispatch_begin(dp);
+    if (!unpack_plane_sh(sh, *tex, buf, &rp, data)) {
+        pl_dispatch_abort(dp, &sh);
+        ok = false;
+        goto done;
+    }
+
+    ok = pl_dispatch_compute(dp, pl_dispatch_compute_params(
+        .shader = &sh,
+        .dispatch_size = {
+            (data->width + 15) / 16,
+            (data->height + 15) / 16,
+            1,
+        },
+    ));
+
+    if (ok && data->buf && data->callback)
+        data->callback(data->priv);
+
+done:
+    if (buf != data->buf)
+        pl_buf_destroy(gpu, &buf);
+    return ok;
+}
+
+// Static properties of each `pl_packed_fmt`
+static const struct packed_desc {
+    int num_planes;
+    int color_depth;    // bits per sample
+    int unit_pixels;    // luma pixels per group of bits (unpacked together)
+    int unit_bytes;     // size of each group of bits
+} packed_descs[PL_PACKED_FMT_COUNT] = {
+    [PL_PACKED_V210]    = { 3, 10, 6, 16 },
+    [PL_PACKED_Y210]    = { 3, 10, 2,  8 },
+    [PL_PACKED_BAYER12] = { 1, 12, 2,  3 },
+};
+
+size_t pl_packed_row_stride(enum pl_packed_fmt format, int width)
+{
+    pl_assert(format >= 0 && format < PL_PACKED_FMT_COUNT);
+    const struct packed_desc *desc = &packed_descs[format];
+    size_t units = PL_DIV_UP(width, desc->unit_pixels);
+    size_t stride = units * desc->unit_bytes;
+    return format == PL_PACKED_V210 ? PL_ALIGN2(stride, 128) : stride;
+}
+
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Unpacks a single row into MSB-aligned 16-bit samples
+static void unpack_row(const struct pl_packed_data *data, const uint8_t *src,
+                       uint16_t *y, uint16_t *cb, uint16_t *cr)
+{
+    const int w = data->width, cw = PL_DIV_UP(w, 2);
+    switch (data->format) {
+    case PL_PACKED_V210:
+        for (int x = 0; x < w; x += 6, src += 16) {
+            uint16_t v[12];
+            for (int i = 0; i < 12; i++)
+                v[i] = ((load_le32(src + 4 * (i / 3)) >> (10 * (i % 3))) & 0x3FF) << 6;
+            for (int i = 0; i < 6 && x + i < w; i++)
+                y[x + i] = v[2 * i + 1];
+            for (int i = 0; i < 3 && x / 2 + i < cw; i++) {
+                cb[x / 2 + i] = v[4 * i];
+                cr[x / 2 + i] = v[4 * i + 2];
+            }
+        }
+        return;
+
+    case PL_PACKED_Y210:
+        for (int x = 0; x < w; x += 2, src += 8) {
+            y[x] = src[0] | (src[1] << 8);
+            if (x + 1 < w)
+                y[x + 1] = src[4] | (src[5] << 8);
+            cb[x / 2] = src[2] | (src[3] << 8);
+            cr[x / 2] = src[6] | (src[7] << 8);
+        }
+        return;
+
+    case PL_PACKED_BAYER12:
+        for (int x = 0; x < w; x += 2, src += 3) {
+            y[x] = ((src[0] << 4) | (src[2] & 0xF)) << 4;
+            if (x + 1 < w)
+                y[x + 1] = ((src[1] << 4) | (src[2] >> 4)) << 4;
+        }
+        return;
+
+    case PL_PACKED_FMT_COUNT: break;
+    }
+
+    pl_unreachable();
+}
+
+static bool upload_packed_cpu(pl_gpu gpu, pl_tex tex[3],
+                              const struct pl_packed_data *data, size_t row_stride)
+{
+    if (!data->pixels) {
+        PL_ERR(gpu, "Unpacking packed data on the CPU requires `pixels`!");
+        return false;
+    }
+
+    const struct packed_desc *desc = &packed_descs[data->format];
+    const int w = data->width, h = data->height, cw = PL_DIV_UP(w, 2);
+    uint16_t *planes = pl_alloc(NULL, (w + 2 * cw) * h * sizeof(uint16_t));
+    uint16_t *y = planes, *cb = y + w * h, *cr = cb + cw * h;
+    for (int row = 0; row < h; row++) {
+        unpack_row(data, (const uint8_t *) data->pixels + row * row_stride,
+                   y + row * w, cb + row * cw, cr + row * cw);
+    }
+
+    if (data->callback)
+        data->callback(data->priv);
+
+    bool ok = true;
+    for (int i = 0; i < desc->num_planes; i++) {
+        ok &= pl_tex_upload(gpu, pl_tex_transfer_params(
+            .tex = tex[i],
+            .ptr = i == 0 ? y : i == 1 ? cb : cr,
+        ));
+    }
+
+    pl_free(planes);
+    return ok;
+}
+
+// Writes the sample `val` to column `x` of the current row of `img`, if it is
+// within the `width` of the plane. Samples are written MSB-aligned into 16-bit
+// UNORM textures, by shifting them up by `shift` bits.
+static void unpack_store(pl_shader sh, ident_t img, int width, const char *x,
+                         const char *val, int shift)
+{
+    GLSL("if (%s < %d)                                                      \n"
+         "    imageStore(%s, ivec2(%s, pos.y), vec4(float((%s) << %du) * %s)); \n",
+         x, width, img, x, val, shift, SH_FLOAT(1.0 / 0xFFFF));
+}
+
+// Emits a compute shader unpacking one group of bits per invocation into the
+// planes `tex`, with the packed data bound as an SSBO of 32-bit words
+static bool unpack_packed_sh(pl_shader sh, pl_tex tex[3], pl_buf buf,
+                             const struct pl_packed_data *data, size_t row_stride)
+{
+    const struct packed_desc *desc = &packed_descs[data->format];
+    if (!sh_try_compute(sh, 16, 16, false, 0)) {
+        SH_FAIL(sh, "Unpacking packed data requires compute shaders!");
+        return false;
+    }
+
+    if (!unpack_bind_words(sh, buf))
+        return false;
+
+    ident_t img[3];
+    for (int i = 0; i < desc->num_planes; i++) {
+        img[i] = sh_desc(sh, (struct pl_shader_desc) {
+            .binding.object = tex[i],
+            .desc = {
+                .name   = "plane",
+                .type   = PL_DESC_STORAGE_IMG,
+                .access = PL_DESC_ACCESS_WRITEONLY,
+            },
+        });
+    }
+
+    // Loads 32 bits starting at an arbitrary byte offset
+    const size_t num_words = buf->params.size / sizeof(uint32_t);
+    ident_t load = sh_fresh(sh, "load_bytes");
+    GLSLH("uint %s(uint offset)                                         \n"
+          "{                                                            \n"
+          "    uint idx = offset >> 2u, shift = (offset & 3u) << 3u;    \n"
+          "    if (shift == 0u)                                         \n"
+          "        return words[idx];                                   \n"
+          "    return (words[idx] >> shift) |                           \n"
+          "           (words[min(idx + 1u, %zuu)] << (32u - shift));    \n"
+          "}                                                            \n",
+          load, num_words - 1);
+
+    const int w = data->width, cw = PL_DIV_UP(w, 2);
+    const int units = PL_DIV_UP(w, desc->unit_pixels);
+    const int shift = 16 - desc->color_depth;
+    sh_describe(sh, "unpacking");
+    GLSL("// unpack_packed_sh                                               \n"
+         "ivec2 pos = ivec2(gl_GlobalInvocationID);                         \n"
+         "if (pos.x >= %d || pos.y >= %d)                                   \n"
+         "    return;                                                       \n"
+         "uint base = %s + uint(pos.y) * %s + uint(pos.x) * %du;            \n",
+         units, data->height, SH_UINT(data->buf_offset), SH_UINT(row_stride),
+         desc->unit_bytes);
+
+    switch (data->format) {
+    case PL_PACKED_V210:
+        // Cb0 Y0 Cr0 | Y1 Cb1 Y2 | Cr1 Y3 Cb2 | Y4 Cr2 Y5
+        GLSL("uint w[4] = uint[4](%s(base), %s(base + 4u),              \n"
+             "                    %s(base + 8u), %s(base + 12u));       \n"
+             "uint v[12];                                               \n"
+             "for (int i = 0; i < 12; i++)                              \n"
+             "    v[i] = (w[i / 3] >> uint(10 * (i %% 3))) & 0x3FFu;    \n"
+             "for (int i = 0; i < 6; i++) {                             \n",
+             load, load, load, load);
+        unpack_store(sh, img[0], w, "6 * pos.x + i", "v[2 * i + 1]", shift);
+        GLSL("}                                                         \n"
+             "for (int i = 0; i < 3; i++) {                             \n");
+        unpack_store(sh, img[1], cw, "3 * pos.x + i", "v[4 * i]", shift);
+        unpack_store(sh, img[2], cw, "3 * pos.x + i", "v[4 * i + 2]", shift);
+        GLSL("}                                                         \n");
+        break;
+
+    case PL_PACKED_Y210:
+        // Already MSB-aligned, so store the samples as-is
+        GLSL("uint w0 = %s(base), w1 = %s(base + 4u); \n", load, load);
+        unpack_store(sh, img[0], w, "2 * pos.x", "w0 & 0xFFFFu", 0);
+        unpack_store(sh, img[0], w, "2 * pos.x + 1", "w1 & 0xFFFFu", 0);
+        unpack_store(sh, img[1], cw, "pos.x", "w0 >> 16u", 0);
+        unpack_store(sh, img[2], cw, "pos.x", "w1 >> 16u", 0);
+        break;
+
+    case PL_PACKED_BAYER12:
+        GLSL("uint b = %s(base); \n", load);
+        unpack_store(sh, img[0], w, "2 * pos.x",
+                     "((b & 0xFFu) << 4u) | ((b >> 16u) & 0xFu)", shift);
+        unpack_store(sh, img[0], w, "2 * pos.x + 1",
+                     "((b >> 4u) & 0xFF0u) | ((b >> 20u) & 0xFu)", shift);
+        break;
+
+    case PL_PACKED_FMT_COUNT:
+        pl_unreachable();
+    }
+
+    return true;
+}
+
+int pl_upload_packed(pl_gpu gpu, pl_dispatch dp, struct pl_plane out_planes[3],
+                     pl_tex tex[3], struct pl_bit_encoding *out_bits,
+                     const struct pl_packed_data *data)
+{
+    pl_assert(!data->buf ^ !data->pixels); // exactly one
+    pl_assert(data->format >= 0 && data->format < PL_PACKED_FMT_COUNT);
+    const struct packed_desc *desc = &packed_descs[data->format];
+    const size_t row_stride = PL_DEF(data->row_stride,
+                                     pl_packed_row_stride(data->format, data->width));
+
+    // The last row does not need to include any padding
+    const size_t row_size = PL_DIV_UP(data->width, desc->unit_pixels) * desc->unit_bytes;
+    const size_t size = row_stride * (data->height - 1) + row_size;
+
+    const enum pl_fmt_caps caps = PL_FMT_CAP_SAMPLEABLE | PL_FMT_CAP_STORABLE;
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 1, 16, 16, caps);
+    const size_t ssbo_size = data->buf ? data->buf->params.size
+                                       : PL_ALIGN2(size, sizeof(uint32_t));
+    bool use_gpu = dp && fmt && gpu->glsl.compute &&
+                   ssbo_size <= gpu->limits.max_ssbo_size;
+    if (!use_gpu)
+        fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 1, 16, 16, PL_FMT_CAP_SAMPLEABLE);
+    if (!fmt) {
+        PL_ERR(gpu, "No 16-bit texture format available for unpacked planes!");
+        return 0;
+    }
+
+    pl_buf buf = data->buf;
+    if (buf && (!buf->params.storable || data->buf_offset % sizeof(uint32_t))) {
+        PL_ERR(gpu, "Packed data buffers must be storable, with an offset "
+               "aligned to 4 bytes!");
+        return 0;
+    }
+
+    static const enum pl_channel channels[3] = {
+        PL_CHANNEL_Y, PL_CHANNEL_CB, PL_CHANNEL_CR,
+    };
+
+    for (int i = 0; i < desc->num_planes; i++) {
+        bool ok = pl_tex_recreate(gpu, &tex[i], pl_tex_params(
+            .w = i ? PL_DIV_UP(data->width, 2) : data->width,
+            .h = data->height,
+            .format = fmt,
+            .sampleable = true,
+            .storable = use_gpu,
+            .host_writable = !use_gpu,
+            .host_readable = fmt->caps & PL_FMT_CAP_HOST_READABLE,
+            .blit_src = fmt->caps & PL_FMT_CAP_BLITTABLE,
+            .debug_tag = PL_DEBUG_TAG,
+        ));
+
+        if (!ok) {
+            PL_ERR(gpu, "Failed initializing plane texture!");
+            return 0;
+        }
+
+        if (out_planes) {
+            out_planes[i] = (struct pl_plane) {
+                .texture = tex[i],
+                .components = 1,
+                .component_mapping = { channels[i] },
+            };
+        }
+    }
+
+    if (out_bits) {
+        *out_bits = (struct pl_bit_encoding) {
+            .sample_depth = 16,
+            .color_depth = desc->color_depth,
+            .bit_shift = 16 - desc->color_depth,
+        };
+    }
+
+    if (!use_gpu)
+        return upload_packed_cpu(gpu, tex, data, row_stride) ? desc->num_planes : 0;
+
+    if (!buf) {
+        buf = upload_raw(gpu, data->pixels, size);
+        if (data->callback)
+            data->callback(data->priv);
+        if (!buf)
+            return 0;
+    }
+
+    bool ok = false;
+    pl_shader sh = pl_dispatch_begin(dp);
+    if (!unpack_packed_sh(sh, tex, buf, data, row_stride)) {
+        pl_dispatch_abort(dp, &sh);
+        goto done;
+    }
+
+    const int units = PL_DIV_UP(data->width, desc->unit_pixels);
+    ok = pl_dispatch_compute(dp, pl_dispatch_compute_params(
+        .shader = &sh,
+        .dispatch_size = {
+            PL_DIV_UP(units, 16),
+            PL_DIV_UP(data->height, 16),
+            1,
+        },
+    ));
+
+    if (ok && data->buf && data->callback)
+        data->callback(data->priv);
+
+done:
+    if (buf != data->buf)
+        pl_buf_destroy(gpu, &buf);
+    return ok ? desc->num_planes : 0;
+}
+
 bool pl_recreate_plane(pl_gpu gpu, struct pl_plane *out_plane,
                        pl_tex *tex, const struct pl_plane_data *data)
 {
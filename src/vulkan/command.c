@@ -18,11 +18,39 @@
 #include "command.h"
 #include "utils.h"
 
-// returns VK_SUCCESS (completed), VK_TIMEOUT (not yet completed) or an error
+// Maximum number of commands to queue up before forcing a flush
+#define MAX_QUEUED_CMDS 64
+
+// returns VK_SUCCESS (completed), VK_TIMEOUT (not yet completed) or an error.
+// On success, `*reached` is updated to a lower bound of the timeline value
 static VkResult vk_cmd_poll(struct vk_ctx *vk, struct vk_cmd *cmd,
-                            uint64_t timeout)
+                            uint64_t timeout, uint64_t *reached)
 {
-    return vk->WaitForFences(vk->dev, 1, &cmd->fence, false, timeout);
+    if (!cmd->timeline)
+        return VK_SUCCESS; // never submitted
+
+    uint64_t value = 0;
+    VkResult res = vk->GetSemaphoreCounterValueKHR(vk->dev, cmd->timeline, &value);
+    if (res != VK_SUCCESS)
+        return res;
+
+    if (value < cmd->timeline_value) {
+        if (!timeout)
+            return VK_TIMEOUT;
+
+        res = vk->WaitSemaphoresKHR(vk->dev, &(VkSemaphoreWaitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &cmd->timeline,
+            .pValues = &cmd->timeline_value,
+        }, timeout);
+        if (res != VK_SUCCESS)
+            return res;
+        value = cmd->timeline_value;
+    }
+
+    *reached = value;
+    return VK_SUCCESS;
 }
 
 static void flush_callbacks(struct vk_ctx *vk)
@@ -50,6 +78,10 @@ static void vk_cmd_reset(struct vk_ctx *vk, struct vk_cmd *cmd)
     cmd->depvalues.num = 0;
     cmd->sigs.num = 0;
     cmd->sigvalues.num = 0;
+    cmd->img_barrs.num = 0;
+    cmd->buf_barrs.num = 0;
+    cmd->barr_src = cmd->barr_dst = 0;
+    cmd->barr_stats = (struct vk_barrier_stats) {0};
 }
 
 static void vk_cmd_destroy(struct vk_ctx *vk, struct vk_cmd *cmd)
@@ -57,9 +89,9 @@ static void vk_cmd_destroy(struct vk_ctx *vk, struct vk_cmd *cmd)
     if (!cmd)
         return;
 
-    vk_cmd_poll(vk, cmd, UINT64_MAX);
+    uint64_t reached;
+    vk_cmd_poll(vk, cmd, UINT64_MAX, &reached);
     vk_cmd_reset(vk, cmd);
-    vk->DestroyFence(vk->dev, cmd->fence, PL_VK_ALLOC);
     vk->FreeCommandBuffers(vk->dev, cmd->pool->pool, 1, &cmd->buf);
 
     pl_free(cmd);
@@ -78,15 +110,6 @@ static struct vk_cmd *vk_cmd_create(struct vk_ctx *vk, struct vk_cmdpool *pool)
     };
 
     VK(vk->AllocateCommandBuffers(vk->dev, &ainfo, &cmd->buf));
-
-    VkFenceCreateInfo finfo = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
-    };
-
-    VK(vk->CreateFence(vk->dev, &finfo, PL_VK_ALLOC, &cmd->fence));
-    PL_VK_NAME(FENCE, cmd->fence, "cmd");
-
     return cmd;
 
 error:
@@ -99,7 +122,10 @@ void vk_dev_callback(struct vk_ctx *vk, vk_cb callback,
                      const void *priv, const void *arg)
 {
     pl_mutex_lock(&vk->lock);
-    if (vk->cmds_pending.num > 0) {
+    if (vk->cmds_queued.num > 0) {
+        struct vk_cmd *last_cmd = vk->cmds_queued.elem[vk->cmds_queued.num - 1];
+        vk_cmd_callback(last_cmd, callback, priv, arg);
+    } else if (vk->cmds_pending.num > 0) {
         struct vk_cmd *last_cmd = vk->cmds_pending.elem[vk->cmds_pending.num - 1];
         vk_cmd_callback(last_cmd, callback, priv, arg);
     } else {
@@ -169,6 +195,92 @@ error:
     return false;
 }
 
+// Returns false if the barrier needs to be recorded as a memory barrier, or
+// true if it was either dropped or reduced to a pure execution dependency
+static bool barrier_elide(struct vk_cmd *cmd, VkPipelineStageFlags src,
+                          VkPipelineStageFlags dst, VkAccessFlags src_access,
+                          bool is_trans, bool is_xfer)
+{
+    cmd->barr_stats.requested++;
+    if (is_trans || is_xfer || (src_access & vk_access_write))
+        return false;
+
+    // Without any layout transition, ownership transfer or prior writes to
+    // make available, there is no need for a memory barrier. Accesses other
+    // than writes still need to be ordered against the previous reads (WAR),
+    // which an execution dependency is sufficient for.
+    cmd->barr_stats.elided++;
+    if (!src_access)
+        return true;
+
+    cmd->barr_src |= src;
+    cmd->barr_dst |= dst;
+    return true;
+}
+
+void vk_cmd_image_barrier(struct vk_ctx *vk, struct vk_cmd *cmd,
+                          VkPipelineStageFlags src, VkPipelineStageFlags dst,
+                          const VkImageMemoryBarrier *barr)
+{
+    bool is_trans = barr->oldLayout != barr->newLayout;
+    bool is_xfer = barr->srcQueueFamilyIndex != barr->dstQueueFamilyIndex;
+    if (barrier_elide(cmd, src, dst, barr->srcAccessMask, is_trans, is_xfer))
+        return;
+
+    // Barriers within a single vkCmdPipelineBarrier are unordered, so make
+    // sure to flush any previous barrier affecting the same image first
+    for (int i = 0; i < cmd->img_barrs.num; i++) {
+        if (cmd->img_barrs.elem[i].image == barr->image) {
+            vk_cmd_flush_barriers(vk, cmd);
+            break;
+        }
+    }
+
+    PL_ARRAY_APPEND(cmd, cmd->img_barrs, *barr);
+    cmd->barr_src |= src;
+    cmd->barr_dst |= dst;
+}
+
+void vk_cmd_buffer_barrier(struct vk_ctx *vk, struct vk_cmd *cmd,
+                           VkPipelineStageFlags src, VkPipelineStageFlags dst,
+                           const VkBufferMemoryBarrier *barr)
+{
+    bool is_xfer = barr->srcQueueFamilyIndex != barr->dstQueueFamilyIndex;
+    if (barrier_elide(cmd, src, dst, barr->srcAccessMask, false, is_xfer))
+        return;
+
+    for (int i = 0; i < cmd->buf_barrs.num; i++) {
+        const VkBufferMemoryBarrier *prev = &cmd->buf_barrs.elem[i];
+        if (prev->buffer == barr->buffer &&
+            prev->offset < barr->offset + barr->size &&
+            barr->offset < prev->offset + prev->size)
+        {
+            vk_cmd_flush_barriers(vk, cmd);
+            break;
+        }
+    }
+
+    PL_ARRAY_APPEND(cmd, cmd->buf_barrs, *barr);
+    cmd->barr_src |= src;
+    cmd->barr_dst |= dst;
+}
+
+void vk_cmd_flush_barriers(struct vk_ctx *vk, struct vk_cmd *cmd)
+{
+    if (!cmd->barr_dst)
+        return;
+
+    vk->CmdPipelineBarrier(cmd->buf, cmd->barr_src, cmd->barr_dst, 0, 0, NULL,
+                           cmd->buf_barrs.num, cmd->buf_barrs.elem,
+                           cmd->img_barrs.num, cmd->img_barrs.elem);
+
+    cmd->barr_stats.emitted += cmd->buf_barrs.num + cmd->img_barrs.num;
+    cmd->barr_stats.calls++;
+    cmd->img_barrs.num = 0;
+    cmd->buf_barrs.num = 0;
+    cmd->barr_src = cmd->barr_dst = 0;
+}
+
 struct vk_sync_scope vk_sem_barrier(struct vk_ctx *vk, struct vk_cmd *cmd,
                                     struct vk_sem *sem, VkPipelineStageFlags stage,
                                     VkAccessFlags access, bool is_trans)
@@ -254,11 +366,30 @@ struct vk_cmdpool *vk_cmdpool_create(struct vk_ctx *vk,
         .qf = qinfo.queueFamilyIndex,
         .queues = pl_calloc(pool, qinfo.queueCount, sizeof(VkQueue)),
         .num_queues = qinfo.queueCount,
+        .timelines = pl_calloc(pool, qinfo.queueCount, sizeof(VkSemaphore)),
+        .timeline_values = pl_calloc(pool, qinfo.queueCount, sizeof(uint64_t)),
     };
 
+    pl_mutex_init(&pool->lock);
     for (int n = 0; n < pool->num_queues; n++)
         vk->GetDeviceQueue(vk->dev, pool->qf, n, &pool->queues[n]);
 
+    static const VkSemaphoreTypeCreateInfo stinfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType  = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue   = 0,
+    };
+
+    static const VkSemaphoreCreateInfo sinfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &stinfo,
+    };
+
+    for (int n = 0; n < pool->num_queues; n++) {
+        VK(vk->CreateSemaphore(vk->dev, &sinfo, PL_VK_ALLOC, &pool->timelines[n]));
+        PL_VK_NAME(SEMAPHORE, pool->timelines[n], "queue timeline");
+    }
+
     VkCommandPoolCreateInfo cinfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
@@ -285,29 +416,46 @@ void vk_cmdpool_destroy(struct vk_ctx *vk, struct vk_cmdpool *pool)
         vk_cmd_destroy(vk, pool->cmds.elem[i]);
 
     vk->DestroyCommandPool(vk->dev, pool->pool, PL_VK_ALLOC);
+    for (int n = 0; n < pool->num_queues; n++)
+        vk->DestroySemaphore(vk->dev, pool->timelines[n], PL_VK_ALLOC);
+
+    pl_mutex_destroy(&pool->lock);
     pl_free(pool);
 }
 
+static bool pop_cmd(struct vk_cmdpool *pool, struct vk_cmd **cmd)
+{
+    pl_mutex_lock(&pool->lock);
+    bool ret = PL_ARRAY_POP(pool->cmds, cmd);
+    pl_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+static void push_cmd(struct vk_cmd *cmd)
+{
+    struct vk_cmdpool *pool = cmd->pool;
+    pl_mutex_lock(&pool->lock);
+    PL_ARRAY_APPEND(pool, pool->cmds, cmd);
+    pl_mutex_unlock(&pool->lock);
+}
+
 struct vk_cmd *vk_cmd_begin(struct vk_ctx *vk, struct vk_cmdpool *pool,
                             pl_debug_tag debug_tag)
 {
-    // Garbage collect the cmdpool first, to increase the chances of getting
-    // an already-available command buffer.
-    vk_poll_commands(vk, 0);
-
     struct vk_cmd *cmd = NULL;
-    pl_mutex_lock(&vk->lock);
-    if (!PL_ARRAY_POP(pool->cmds, &cmd)) {
-        cmd = vk_cmd_create(vk, pool);
-        if (!cmd) {
-            pl_mutex_unlock(&vk->lock);
-            goto error;
+    if (!pop_cmd(pool, &cmd)) {
+        // Garbage collect completed commands first, to increase the chances
+        // of getting an already-available command buffer.
+        vk_poll_commands(vk, 0);
+        if (!pop_cmd(pool, &cmd)) {
+            cmd = vk_cmd_create(vk, pool);
+            if (!cmd)
+                goto error;
         }
     }
 
-    cmd->qindex = pool->idx_queues;
+    cmd->qindex = atomic_load(&pool->idx_queues);
     cmd->queue = pool->queues[cmd->qindex];
-    pl_mutex_unlock(&vk->lock);
 
     VkCommandBufferBeginInfo binfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -318,7 +466,6 @@ struct vk_cmd *vk_cmd_begin(struct vk_ctx *vk, struct vk_cmdpool *pool,
 
     debug_tag = PL_DEF(debug_tag, "vk_cmd");
     PL_VK_NAME(COMMAND_BUFFER, cmd->buf, debug_tag);
-    PL_VK_NAME(FENCE, cmd->fence, debug_tag);
     return cmd;
 
 error:
@@ -328,6 +475,118 @@ error:
     return NULL;
 }
 
+// Must be called with vk->lock held. The lock is held for the entire duration
+// of the flush, to ensure commands from concurrent flushes can't be reordered.
+static bool flush_queued(struct vk_ctx *vk)
+{
+    struct vk_cmd **cmds = vk->cmds_queued.elem;
+    int num = vk->cmds_queued.num;
+    pl_assert(num <= MAX_QUEUED_CMDS);
+
+    struct vk_cmd *batch[MAX_QUEUED_CMDS];
+    VkSubmitInfo sinfos[MAX_QUEUED_CMDS];
+    VkTimelineSemaphoreSubmitInfo tinfos[MAX_QUEUED_CMDS];
+    bool ret = true;
+
+    for (int i = 0; i < num; i++) {
+        if (!cmds[i])
+            continue; // already submitted as part of an earlier batch
+
+        // Gather all queued commands for this queue into a single batch. This
+        // may reorder submissions *across* queues, which is fine because all
+        // internal cross-queue dependencies are timeline semaphores (which
+        // may be waited on before the corresponding signal is submitted), and
+        // we always flush before exposing any semaphore externally.
+        VkQueue queue = cmds[i]->queue;
+        int count = 0;
+        for (int n = i; n < num; n++) {
+            if (cmds[n] && cmds[n]->queue == queue) {
+                batch[count++] = cmds[n];
+                cmds[n] = NULL;
+            }
+        }
+
+        // Only the last command in each batch needs to signal the queue's
+        // timeline, since commands submitted to the same queue complete in
+        // order
+        struct vk_cmd *last = batch[count - 1];
+        struct vk_cmdpool *pool = last->pool;
+        VkSemaphore timeline = pool->timelines[last->qindex];
+        uint64_t value = pool->timeline_values[last->qindex] + 1;
+        vk_cmd_sig(last, (pl_vulkan_sem) { timeline, value });
+
+        for (int c = 0; c < count; c++) {
+            const struct vk_cmd *cmd = batch[c];
+            tinfos[c] = (VkTimelineSemaphoreSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .waitSemaphoreValueCount = cmd->depvalues.num,
+                .pWaitSemaphoreValues = cmd->depvalues.elem,
+                .signalSemaphoreValueCount = cmd->sigvalues.num,
+                .pSignalSemaphoreValues = cmd->sigvalues.elem,
+            };
+
+            sinfos[c] = (VkSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = &tinfos[c],
+                .commandBufferCount = 1,
+                .pCommandBuffers = &cmd->buf,
+                .waitSemaphoreCount = cmd->deps.num,
+                .pWaitSemaphores = cmd->deps.elem,
+                .pWaitDstStageMask = cmd->depstages.elem,
+                .signalSemaphoreCount = cmd->sigs.num,
+                .pSignalSemaphores = cmd->sigs.elem,
+            };
+        }
+
+        if (pl_msg_test(vk->log, PL_LOG_TRACE)) {
+            PL_TRACE(vk, "Submitting %d command(s) on queue %p (QF %d):",
+                     count, (void *) queue, pool->qf);
+            for (int c = 0; c < count; c++) {
+                const struct vk_cmd *cmd = batch[c];
+                PL_TRACE(vk, "  command %p:", (void *) cmd->buf);
+                for (int n = 0; n < cmd->deps.num; n++) {
+                    PL_TRACE(vk, "    waits on semaphore %p = %"PRIu64,
+                             (void *) cmd->deps.elem[n], cmd->depvalues.elem[n]);
+                }
+                for (int n = 0; n < cmd->sigs.num; n++) {
+                    PL_TRACE(vk, "    signals semaphore %p = %"PRIu64,
+                            (void *) cmd->sigs.elem[n], cmd->sigvalues.elem[n]);
+                }
+                if (cmd->callbacks.num)
+                    PL_TRACE(vk, "    signals %d callbacks", cmd->callbacks.num);
+            }
+        }
+
+        vk->lock_queue(vk->queue_ctx, pool->qf, last->qindex);
+        VkResult res = vk->QueueSubmit(queue, count, sinfos, VK_NULL_HANDLE);
+        vk->unlock_queue(vk->queue_ctx, pool->qf, last->qindex);
+
+        if (res != VK_SUCCESS) {
+            PL_ERR(vk, "vkQueueSubmit: %s", vk_res_str(res));
+            for (int c = 0; c < count; c++) {
+                vk_cmd_reset(vk, batch[c]);
+                push_cmd(batch[c]);
+            }
+            vk->failed = true;
+            ret = false;
+            continue;
+        }
+
+        pool->timeline_values[last->qindex] = value;
+        for (int c = 0; c < count; c++) {
+            batch[c]->timeline = timeline;
+            batch[c]->timeline_value = value;
+            PL_ARRAY_APPEND(vk->alloc, vk->cmds_pending, batch[c]);
+        }
+
+        vk->num_submits++;
+        vk->num_cmds_submitted += count;
+    }
+
+    vk->cmds_queued.num = 0;
+    return ret;
+}
+
 bool vk_cmd_submit(struct vk_ctx *vk, struct vk_cmd **pcmd)
 {
     struct vk_cmd *cmd = *pcmd;
@@ -335,85 +594,87 @@ bool vk_cmd_submit(struct vk_ctx *vk, struct vk_cmd **pcmd)
         return true;
 
     *pcmd = NULL;
-    struct vk_cmdpool *pool = cmd->pool;
-
+    vk_cmd_flush_barriers(vk, cmd);
     VK(vk->EndCommandBuffer(cmd->buf));
-    VK(vk->ResetFences(vk->dev, 1, &cmd->fence));
-
-    VkTimelineSemaphoreSubmitInfo tinfo = {
-        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
-        .waitSemaphoreValueCount = cmd->depvalues.num,
-        .pWaitSemaphoreValues = cmd->depvalues.elem,
-        .signalSemaphoreValueCount = cmd->sigvalues.num,
-        .pSignalSemaphoreValues = cmd->sigvalues.elem,
-    };
 
-    VkSubmitInfo sinfo = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = &tinfo,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &cmd->buf,
-        .waitSemaphoreCount = cmd->deps.num,
-        .pWaitSemaphores = cmd->deps.elem,
-        .pWaitDstStageMask = cmd->depstages.elem,
-        .signalSemaphoreCount = cmd->sigs.num,
-        .pSignalSemaphores = cmd->sigs.elem,
-    };
+    bool ret = true;
+    pl_mutex_lock(&vk->lock);
+    struct vk_barrier_stats *stats = &vk->barrier_stats;
+    stats->requested += cmd->barr_stats.requested;
+    stats->elided += cmd->barr_stats.elided;
+    stats->emitted += cmd->barr_stats.emitted;
+    stats->calls += cmd->barr_stats.calls;
+    PL_ARRAY_APPEND(vk->alloc, vk->cmds_queued, cmd);
+    if (vk->cmds_queued.num >= MAX_QUEUED_CMDS)
+        ret = flush_queued(vk);
+    pl_mutex_unlock(&vk->lock);
+    return ret;
 
-    if (pl_msg_test(vk->log, PL_LOG_TRACE)) {
-        PL_TRACE(vk, "Submitting command %p on queue %p (QF %d):",
-                 (void *) cmd->buf, (void *) cmd->queue, pool->qf);
-        for (int n = 0; n < cmd->deps.num; n++) {
-            PL_TRACE(vk, "    waits on semaphore %p = %"PRIu64,
-                     (void *) cmd->deps.elem[n], cmd->depvalues.elem[n]);
-        }
+error:
+    vk_cmd_reset(vk, cmd);
+    push_cmd(cmd);
+    vk->failed = true;
+    return false;
+}
+
+bool vk_cmd_queued_sig(struct vk_ctx *vk, const struct vk_cmdpool *pool,
+                       VkSemaphore sem, uint64_t value)
+{
+    bool ret = false;
+    pl_mutex_lock(&vk->lock);
+    for (int i = 0; i < vk->cmds_queued.num && !ret; i++) {
+        const struct vk_cmd *cmd = vk->cmds_queued.elem[i];
+        if (cmd->pool != pool)
+            continue;
         for (int n = 0; n < cmd->sigs.num; n++) {
-            PL_TRACE(vk, "    signals semaphore %p = %"PRIu64,
-                    (void *) cmd->sigs.elem[n], cmd->sigvalues.elem[n]);
+            if (cmd->sigs.elem[n] == sem && cmd->sigvalues.elem[n] == value) {
+                ret = true;
+                break;
+            }
         }
-        PL_TRACE(vk, "    signals fence %p", (void *) cmd->fence);
-        if (cmd->callbacks.num)
-            PL_TRACE(vk, "    signals %d callbacks", cmd->callbacks.num);
     }
-
-    vk->lock_queue(vk->queue_ctx, pool->qf, cmd->qindex);
-    VkResult res = vk->QueueSubmit(cmd->queue, 1, &sinfo, cmd->fence);
-    vk->unlock_queue(vk->queue_ctx, pool->qf, cmd->qindex);
-    PL_VK_ASSERT(res, "vkQueueSubmit");
-
-    pl_mutex_lock(&vk->lock);
-    PL_ARRAY_APPEND(vk->alloc, vk->cmds_pending, cmd);
     pl_mutex_unlock(&vk->lock);
-    return true;
+    return ret;
+}
 
-error:
-    vk_cmd_reset(vk, cmd);
+bool vk_flush_commands(struct vk_ctx *vk)
+{
     pl_mutex_lock(&vk->lock);
-    PL_ARRAY_APPEND(pool, pool->cmds, cmd);
+    bool ret = flush_queued(vk);
     pl_mutex_unlock(&vk->lock);
-    vk->failed = true;
-    return false;
+    return ret;
 }
 
 bool vk_poll_commands(struct vk_ctx *vk, uint64_t timeout)
 {
     bool ret = false;
     pl_mutex_lock(&vk->lock);
+    if (timeout)
+        flush_queued(vk);
+
+    // Last known value of the most recently queried timeline semaphore, to
+    // avoid re-querying it for every command submitted in the same batch
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    uint64_t reached = 0;
 
     while (vk->cmds_pending.num) {
         struct vk_cmd *cmd = vk->cmds_pending.elem[0];
-        struct vk_cmdpool *pool = cmd->pool;
-        pl_mutex_unlock(&vk->lock); // don't hold mutex while blocking
-        if (vk_cmd_poll(vk, cmd, timeout) == VK_TIMEOUT)
-            return ret;
-        pl_mutex_lock(&vk->lock);
-        if (!vk->cmds_pending.num || vk->cmds_pending.elem[0] != cmd)
-            continue; // another thread modified this state while blocking
-
-        PL_TRACE(vk, "VkFence signalled: %p", (void *) cmd->fence);
+        if (cmd->timeline != timeline || cmd->timeline_value > reached) {
+            pl_mutex_unlock(&vk->lock); // don't hold mutex while blocking
+            timeline = cmd->timeline;
+            reached = 0;
+            if (vk_cmd_poll(vk, cmd, timeout, &reached) == VK_TIMEOUT)
+                return ret;
+            pl_mutex_lock(&vk->lock);
+            if (!vk->cmds_pending.num || vk->cmds_pending.elem[0] != cmd)
+                continue; // another thread modified this state while blocking
+        }
+
+        PL_TRACE(vk, "Command %p completed (timeline %p = %"PRIu64")",
+                 (void *) cmd->buf, (void *) cmd->timeline, cmd->timeline_value);
         PL_ARRAY_REMOVE_AT(vk->cmds_pending, 0); // remove before callbacks
         vk_cmd_reset(vk, cmd);
-        PL_ARRAY_APPEND(pool, pool->cmds, cmd);
+        push_cmd(cmd);
         ret = true;
 
         // If we've successfully spent some time waiting for at least one
@@ -44,7 +44,10 @@ struct vk_cmd {
     VkQueue queue;           // the submission queue (for recording/pending)
     int qindex;              // the index of `queue` in `pool`
     VkCommandBuffer buf;     // the command buffer itself
-    VkFence fence;           // the fence guards cmd buffer reuse
+    // The queue's timeline semaphore, and the value it reaches once this
+    // command completes. This guards cmd buffer reuse.
+    VkSemaphore timeline;
+    uint64_t timeline_value;
     // The semaphores represent dependencies that need to complete before
     // this command can be executed. These are *not* owned by the vk_cmd
     PL_ARRAY(VkSemaphore) deps;
@@ -58,6 +61,12 @@ struct vk_cmd {
     // to fire once the VkFence completes. These are used for multiple purposes,
     // ranging from garbage collection (resource deallocation) to fencing.
     PL_ARRAY(struct vk_callback) callbacks;
+    // Pipeline barriers accumulated since the last `vk_cmd_flush_barriers`,
+    // together with the union of their stage masks
+    PL_ARRAY(VkImageMemoryBarrier) img_barrs;
+    PL_ARRAY(VkBufferMemoryBarrier) buf_barrs;
+    VkPipelineStageFlags barr_src, barr_dst;
+    struct vk_barrier_stats barr_stats;
 };
 
 // Associate a callback with the completion of the current command. This
@@ -73,6 +82,24 @@ void vk_cmd_dep(struct vk_cmd *cmd, VkPipelineStageFlags stage, pl_vulkan_sem de
 // after the command completes.
 void vk_cmd_sig(struct vk_cmd *cmd, pl_vulkan_sem sig);
 
+// Record a pipeline barrier into the current command. Barriers are not
+// emitted immediately, but accumulated until the next call to
+// `vk_cmd_flush_barriers`, which merges all of them into a single
+// vkCmdPipelineBarrier. Barriers without any effect are dropped, and barriers
+// without layout transition or prior writes are reduced to pure execution
+// dependencies.
+void vk_cmd_image_barrier(struct vk_ctx *vk, struct vk_cmd *cmd,
+                          VkPipelineStageFlags src, VkPipelineStageFlags dst,
+                          const VkImageMemoryBarrier *barr);
+void vk_cmd_buffer_barrier(struct vk_ctx *vk, struct vk_cmd *cmd,
+                           VkPipelineStageFlags src, VkPipelineStageFlags dst,
+                           const VkBufferMemoryBarrier *barr);
+
+// Emit all pending barriers. This must be called before recording any action
+// command (draw, dispatch, copy, etc.) that depends on them. Called
+// automatically by `vk_cmd_submit`.
+void vk_cmd_flush_barriers(struct vk_ctx *vk, struct vk_cmd *cmd);
+
 // Synchronization scope
 struct vk_sync_scope {
     uint64_t value;             // last timeline semaphore value
@@ -108,9 +135,15 @@ struct vk_cmdpool {
     VkCommandPool pool;
     VkQueue *queues;
     int num_queues;
-    int idx_queues;
+    _Atomic int idx_queues;
+    // Timeline semaphore signalled by each queue upon command completion,
+    // together with the last value submitted to it (guarded by vk->lock)
+    VkSemaphore *timelines;
+    uint64_t *timeline_values;
     // Command buffers associated with this queue. These are available for
-    // re-recording
+    // re-recording. Guarded by `lock`, since commands are recycled by
+    // whichever thread happens to poll for their completion.
+    pl_mutex lock;
     PL_ARRAY(struct vk_cmd *) cmds;
 };
 
@@ -123,22 +156,44 @@ void vk_cmdpool_destroy(struct vk_ctx *vk, struct vk_cmdpool *pool);
 
 // Fetch a command buffer from a command pool and begin recording to it.
 // Returns NULL on failure.
+//
+// Note: The underlying VkCommandPool is externally synchronized, so all
+// command buffers allocated from the same pool must be begun, recorded and
+// submitted under a common lock (`pl_vk.recording`).
 struct vk_cmd *vk_cmd_begin(struct vk_ctx *vk, struct vk_cmdpool *pool,
                             pl_debug_tag debug_tag);
 
-// Finish recording a command buffer and submit it for execution. This function
+// Finish recording a command buffer and queue it for execution. This function
 // takes over ownership of **cmd, and sets *cmd to NULL in doing so.
+//
+// Note: Queued commands are only actually submitted to the device once
+// `vk_flush_commands` is called (or enough commands have accumulated), so
+// that all commands recorded in between can share a single vkQueueSubmit.
 bool vk_cmd_submit(struct vk_ctx *vk, struct vk_cmd **cmd);
 
+// Returns whether a command queued by `vk_cmd_submit` on `pool`, but not yet
+// submitted to the device, signals `sem` with `value`.
+bool vk_cmd_queued_sig(struct vk_ctx *vk, const struct vk_cmdpool *pool,
+                       VkSemaphore sem, uint64_t value);
+
+// Submit all queued commands to their respective queues, using one batched
+// vkQueueSubmit per queue. This must be called before any of the semaphores
+// signalled by queued commands are made visible to the outside world (e.g.
+// exported, or waited on by the host or by a presentation request).
+bool vk_flush_commands(struct vk_ctx *vk);
+
 // Block until some commands complete executing. This is the only function that
 // actually processes the callbacks. Will wait at most `timeout` nanoseconds
 // for the completion of any command. The timeout may also be passed as 0, in
 // which case this function will not block, but only poll for completed
-// commands. Returns whether any forward progress was made.
+// commands, which costs a single timeline semaphore query per queue. Returns
+// whether any forward progress was made.
 //
-// This does *not* flush any queued commands, forgetting to do so may result
-// in infinite loops if waiting for the completion of callbacks that were
-// never flushed!
+// If `timeout` is nonzero, this first flushes all queued commands, to avoid
+// blocking on commands that were never submitted. This does *not* submit the
+// command currently being recorded, forgetting to do so may result in
+// infinite loops if waiting for the completion of callbacks that were never
+// submitted!
 bool vk_poll_commands(struct vk_ctx *vk, uint64_t timeout);
 
 // Rotate through queues in each command pool. Call this once per frame, after
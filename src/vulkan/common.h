@@ -49,12 +49,21 @@
 #define VK_API_VERSION_1_2 VK_MAKE_VERSION(1, 2, 0)
 #endif
 
+// Pipeline barrier statistics
+struct vk_barrier_stats {
+    uint64_t requested; // number of image/buffer barriers requested
+    uint64_t elided;    // ... dropped, or reduced to execution dependencies
+    uint64_t emitted;   // number of image/buffer barriers actually recorded
+    uint64_t calls;     // number of vkCmdPipelineBarrier calls
+};
+
 // Shared struct used to hold vulkan context information
 struct vk_ctx {
     pl_mutex lock;
     pl_vulkan vulkan;
     void *alloc; // host allocations bound to the lifetime of this vk_ctx
     struct vk_malloc *ma; // VRAM malloc layer
+    size_t memory_budget; // user-supplied per-heap budget, or 0
     pl_vk_inst internal_instance;
     pl_log log;
     VkInstance inst;
@@ -87,8 +96,17 @@ struct vk_ctx {
 
     // Pending commands. These are shared for the entire mpvk_ctx to ensure
     // submission and callbacks are FIFO
+    PL_ARRAY(struct vk_cmd *) cmds_queued;  // recorded but not yet submitted
     PL_ARRAY(struct vk_cmd *) cmds_pending; // submitted but not completed
 
+    // Submission statistics, for debugging/benchmarking purposes
+    uint64_t num_submits;        // number of vkQueueSubmit calls
+    uint64_t num_cmds_submitted; // number of command buffers submitted
+
+    // Pipeline barrier statistics, for debugging/benchmarking purposes. These
+    // are collected per command and added up on submission
+    struct vk_barrier_stats barrier_stats;
+
     // Pending callbacks that still need to be drained before processing
     // callbacks for the next command (in case commands are recursively being
     // polled from another callback)
@@ -107,6 +125,7 @@ struct vk_ctx {
     PL_VK_FUN(GetPhysicalDeviceFormatProperties2KHR);
     PL_VK_FUN(GetPhysicalDeviceImageFormatProperties2KHR);
     PL_VK_FUN(GetPhysicalDeviceMemoryProperties);
+    PL_VK_FUN(GetPhysicalDeviceMemoryProperties2);
     PL_VK_FUN(GetPhysicalDeviceProperties);
     PL_VK_FUN(GetPhysicalDeviceProperties2);
     PL_VK_FUN(GetPhysicalDeviceQueueFamilyProperties);
@@ -143,6 +162,7 @@ struct vk_ctx {
     PL_VK_FUN(CmdPipelineBarrier);
     PL_VK_FUN(CmdPushConstants);
     PL_VK_FUN(CmdPushDescriptorSetKHR);
+    PL_VK_FUN(CmdPushDescriptorSetWithTemplateKHR);
     PL_VK_FUN(CmdResetQueryPool);
     PL_VK_FUN(CmdSetEvent);
     PL_VK_FUN(CmdSetScissor);
@@ -157,6 +177,7 @@ struct vk_ctx {
     PL_VK_FUN(CreateDebugReportCallbackEXT);
     PL_VK_FUN(CreateDescriptorPool);
     PL_VK_FUN(CreateDescriptorSetLayout);
+    PL_VK_FUN(CreateDescriptorUpdateTemplate);
     PL_VK_FUN(CreateEvent);
     PL_VK_FUN(CreateFence);
     PL_VK_FUN(CreateFramebuffer);
@@ -177,6 +198,7 @@ struct vk_ctx {
     PL_VK_FUN(DestroyDebugReportCallbackEXT);
     PL_VK_FUN(DestroyDescriptorPool);
     PL_VK_FUN(DestroyDescriptorSetLayout);
+    PL_VK_FUN(DestroyDescriptorUpdateTemplate);
     PL_VK_FUN(DestroyDevice);
     PL_VK_FUN(DestroyEvent);
     PL_VK_FUN(DestroyFence);
@@ -207,17 +229,20 @@ struct vk_ctx {
     PL_VK_FUN(GetMemoryHostPointerPropertiesEXT);
     PL_VK_FUN(GetPipelineCacheData);
     PL_VK_FUN(GetQueryPoolResults);
+    PL_VK_FUN(GetSemaphoreCounterValueKHR);
     PL_VK_FUN(GetSemaphoreFdKHR);
     PL_VK_FUN(GetSwapchainImagesKHR);
     PL_VK_FUN(InvalidateMappedMemoryRanges);
     PL_VK_FUN(MapMemory);
     PL_VK_FUN(QueuePresentKHR);
     PL_VK_FUN(QueueSubmit);
+    PL_VK_FUN(ResetDescriptorPool);
     PL_VK_FUN(ResetEvent);
     PL_VK_FUN(ResetFences);
     PL_VK_FUN(ResetQueryPoolEXT);
     PL_VK_FUN(SetDebugUtilsObjectNameEXT);
     PL_VK_FUN(SetHdrMetadataEXT);
+    PL_VK_FUN(UpdateDescriptorSetWithTemplate);
     PL_VK_FUN(UpdateDescriptorSets);
     PL_VK_FUN(WaitForFences);
     PL_VK_FUN(WaitSemaphoresKHR);
@@ -72,6 +72,7 @@ static const struct vk_fun vk_inst_funs[] = {
     PL_VK_INST_FUN(GetPhysicalDeviceFormatProperties2KHR),
     PL_VK_INST_FUN(GetPhysicalDeviceImageFormatProperties2KHR),
     PL_VK_INST_FUN(GetPhysicalDeviceMemoryProperties),
+    PL_VK_INST_FUN(GetPhysicalDeviceMemoryProperties2),
     PL_VK_INST_FUN(GetPhysicalDeviceProperties),
     PL_VK_INST_FUN(GetPhysicalDeviceProperties2),
     PL_VK_INST_FUN(GetPhysicalDeviceQueueFamilyProperties),
@@ -104,6 +105,7 @@ static const struct vk_ext vk_device_extensions[] = {
         .name = VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME,
         .funs = (struct vk_fun[]) {
             PL_VK_DEV_FUN(CmdPushDescriptorSetKHR),
+            PL_VK_DEV_FUN(CmdPushDescriptorSetWithTemplateKHR),
             {0}
         },
     }, {
@@ -174,9 +176,18 @@ static const struct vk_ext vk_device_extensions[] = {
         .name = VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
         .core_ver = VK_API_VERSION_1_2,
         .funs = (struct vk_fun[]) {
+            PL_VK_DEV_FUN(GetSemaphoreCounterValueKHR),
             PL_VK_DEV_FUN(WaitSemaphoresKHR),
             {0}
         },
+    }, {
+        .name = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#ifdef VK_EXT_graphics_pipeline_library
+    }, {
+        .name = VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+    }, {
+        .name = VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+#endif
 #ifdef VK_KHR_portability_subset
     }, {
         .name = VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME,
@@ -201,6 +212,11 @@ const char * const pl_vulkan_recommended_extensions[] = {
     VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME,
     VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME,
     VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#ifdef VK_EXT_graphics_pipeline_library
+    VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+    VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+#endif
 #ifdef VK_KHR_portability_subset
     VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME,
 #endif
@@ -216,8 +232,18 @@ static_assert(PL_ARRAY_SIZE(pl_vulkan_recommended_extensions) + 1 ==
               "vk_device_extensions?");
 
 // pNext chain of features we want enabled
+#ifdef VK_EXT_graphics_pipeline_library
+static const VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+    .graphicsPipelineLibrary = true,
+};
+#endif
+
 static const VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphores = {
     .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+#ifdef VK_EXT_graphics_pipeline_library
+    .pNext = (void *) &gpl,
+#endif
     .timelineSemaphore = true,
 };
 
@@ -285,6 +311,7 @@ static const struct vk_fun vk_dev_funs[] = {
     PL_VK_DEV_FUN(CreateComputePipelines),
     PL_VK_DEV_FUN(CreateDescriptorPool),
     PL_VK_DEV_FUN(CreateDescriptorSetLayout),
+    PL_VK_DEV_FUN(CreateDescriptorUpdateTemplate),
     PL_VK_DEV_FUN(CreateEvent),
     PL_VK_DEV_FUN(CreateFence),
     PL_VK_DEV_FUN(CreateFramebuffer),
@@ -303,6 +330,7 @@ static const struct vk_fun vk_dev_funs[] = {
     PL_VK_DEV_FUN(DestroyCommandPool),
     PL_VK_DEV_FUN(DestroyDescriptorPool),
     PL_VK_DEV_FUN(DestroyDescriptorSetLayout),
+    PL_VK_DEV_FUN(DestroyDescriptorUpdateTemplate),
     PL_VK_DEV_FUN(DestroyDevice),
     PL_VK_DEV_FUN(DestroyEvent),
     PL_VK_DEV_FUN(DestroyFence),
@@ -331,9 +359,11 @@ static const struct vk_fun vk_dev_funs[] = {
     PL_VK_DEV_FUN(InvalidateMappedMemoryRanges),
     PL_VK_DEV_FUN(MapMemory),
     PL_VK_DEV_FUN(QueueSubmit),
+    PL_VK_DEV_FUN(ResetDescriptorPool),
     PL_VK_DEV_FUN(ResetEvent),
     PL_VK_DEV_FUN(ResetFences),
     PL_VK_DEV_FUN(SetDebugUtilsObjectNameEXT),
+    PL_VK_DEV_FUN(UpdateDescriptorSetWithTemplate),
     PL_VK_DEV_FUN(UpdateDescriptorSets),
     PL_VK_DEV_FUN(WaitForFences),
 };
@@ -836,6 +866,12 @@ void pl_vulkan_destroy(pl_vulkan *pl_vk)
     pl_free_ptr((void **) pl_vk);
 }
 
+void pl_vulkan_memory_stats(pl_vulkan pl_vk, struct pl_vulkan_memory_stats *out)
+{
+    struct vk_ctx *vk = PL_PRIV(pl_vk);
+    vk_malloc_stats(vk->ma, out);
+}
+
 static bool supports_surf(pl_log log, VkInstance inst,
                           PFN_vkGetInstanceProcAddr get_addr,
                           VkPhysicalDevice physd, VkSurfaceKHR surf)
@@ -1354,6 +1390,7 @@ pl_vulkan pl_vulkan_create(pl_log log, const struct pl_vulkan_params *params)
         .alloc = pl_vk,
         .log = log,
         .inst = params->instance,
+        .memory_budget = params->memory_budget,
         .GetInstanceProcAddr = get_proc_addr_fallback(log, params->get_proc_addr),
     };
 
@@ -1466,6 +1503,7 @@ pl_vulkan pl_vulkan_import(pl_log log, const struct pl_vulkan_import_params *par
         .inst = params->instance,
         .physd = params->phys_device,
         .dev = params->device,
+        .memory_budget = params->memory_budget,
         .GetInstanceProcAddr = get_proc_addr_fallback(log, params->get_proc_addr),
         .lock_queue = params->lock_queue,
         .unlock_queue = params->unlock_queue,
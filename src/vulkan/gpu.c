@@ -210,6 +210,7 @@ bool _end_cmd(pl_gpu gpu, struct vk_cmd **pcmd, bool submit)
             pl_mutex_lock(&p->recording);
             ret = vk_cmd_submit(p->vk, &p->cmd);
             pl_mutex_unlock(&p->recording);
+            ret &= vk_flush_commands(vk);
         }
         return ret;
     }
@@ -260,6 +261,13 @@ static void vk_gpu_destroy(pl_gpu gpu)
     }
 
     spirv_compiler_destroy(&p->spirv);
+    vk_dspools_destroy(gpu);
+    vk_link_workers_destroy(gpu);
+    pl_mutex_destroy(&p->dspool_lock);
+    pl_mutex_destroy(&p->vert_lib_lock);
+    pl_cond_destroy(&p->link_work);
+    pl_cond_destroy(&p->link_done);
+    pl_mutex_destroy(&p->link_lock);
     pl_mutex_destroy(&p->recording);
     pl_free((void *) gpu);
 }
@@ -388,6 +396,11 @@ pl_gpu pl_gpu_create_vk(struct vk_ctx *vk)
 
     struct pl_vk *p = PL_PRIV(gpu);
     pl_mutex_init(&p->recording);
+    pl_mutex_init(&p->dspool_lock);
+    pl_mutex_init(&p->vert_lib_lock);
+    pl_mutex_init(&p->link_lock);
+    pl_cond_init(&p->link_work);
+    pl_cond_init(&p->link_done);
     p->impl = pl_fns_vk;
     p->vk = vk;
 
@@ -433,6 +446,13 @@ pl_gpu pl_gpu_create_vk(struct vk_ctx *vk)
     vk_link_struct(&props, &port_props);
 #endif
 
+#ifdef VK_EXT_graphics_pipeline_library
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT gpl_props = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT,
+    };
+    vk_link_struct(&props, &gpl_props);
+#endif
+
 
     vk->GetPhysicalDeviceProperties2(vk->physd, &props);
 
@@ -535,6 +555,22 @@ pl_gpu pl_gpu_create_vk(struct vk_ctx *vk)
             p->host_query_reset = host_query_reset->hostQueryReset;
     }
 
+#ifdef VK_EXT_graphics_pipeline_library
+    for (int i = 0; i < vk->exts.num; i++) {
+        if (strcmp(vk->exts.elem[i], VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) != 0)
+            continue;
+
+        // Without fast linking, linking the libraries costs about as much as
+        // compiling the complete pipeline, so don't bother in that case
+        const VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT *gpl;
+        gpl = vk_find_struct(&vk->features,
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT);
+        p->gpl = gpl && gpl->graphicsPipelineLibrary &&
+                 gpl_props.graphicsPipelineLibraryFastLinking;
+        break;
+    }
+#endif
+
     vk_setup_formats(gpu);
 
     // Compute the correct minimum texture alignment
@@ -709,6 +745,7 @@ static void vk_gpu_flush(pl_gpu gpu)
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
     CMD_SUBMIT(NULL);
+    vk_poll_commands(vk, 0);
     vk_rotate_queues(vk);
     vk_malloc_garbage_collect(vk->ma);
 }
@@ -736,7 +773,6 @@ struct vk_cmd *pl_vk_steal_cmd(pl_gpu gpu)
     pl_mutex_lock(&p->recording);
     struct vk_cmd *cmd = p->cmd;
     p->cmd = NULL;
-    pl_mutex_unlock(&p->recording);
 
     struct vk_cmdpool *pool = vk->pool_graphics;
     if (!cmd || cmd->pool != pool) {
@@ -744,9 +780,19 @@ struct vk_cmd *pl_vk_steal_cmd(pl_gpu gpu)
         cmd = vk_cmd_begin(vk, pool, NULL);
     }
 
+    if (!cmd)
+        pl_mutex_unlock(&p->recording);
     return cmd;
 }
 
+bool pl_vk_submit_stolen(pl_gpu gpu, struct vk_cmd **cmd)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    bool ret = vk_cmd_submit(p->vk, cmd);
+    pl_mutex_unlock(&p->recording);
+    return ret;
+}
+
 void pl_vk_print_heap(pl_gpu gpu, enum pl_log_level lev)
 {
     struct pl_vk *p = PL_PRIV(gpu);
@@ -772,6 +818,8 @@ static const struct pl_gpu_fns pl_fns_vk = {
     .buf_copy               = vk_buf_copy,
     .buf_export             = vk_buf_export,
     .buf_poll               = vk_buf_poll,
+    .buf_should_release     = vk_buf_should_release,
+    .tex_create_internal    = vk_tex_create_internal,
     .desc_namespace         = vk_desc_namespace,
     .pass_create            = vk_pass_create,
     .pass_destroy           = vk_pass_destroy,
@@ -29,9 +29,12 @@
 pl_gpu pl_gpu_create_vk(struct vk_ctx *vk);
 
 // This function takes the current graphics command and steals it from the
-// GPU, so the caller can do custom vk_cmd_ calls on it. The caller should
-// submit it as well.
+// GPU, so the caller can do custom vk_cmd_ calls on it. Since the command
+// shares its VkCommandPool with all other commands, it's returned with the
+// `recording` lock held, and must be submitted with `pl_vk_submit_stolen`,
+// which releases the lock again.
 struct vk_cmd *pl_vk_steal_cmd(pl_gpu gpu);
+bool pl_vk_submit_stolen(pl_gpu gpu, struct vk_cmd **cmd);
 
 // Print memory usage statistics
 void pl_vk_print_heap(pl_gpu, enum pl_log_level);
@@ -59,6 +62,7 @@ struct pl_vk {
     uint32_t max_push_descriptors;
     size_t min_texel_alignment;
     bool host_query_reset;
+    bool gpl; // VK_EXT_graphics_pipeline_library with fast linking
 
     // This is a pl_dispatch used (on ourselves!) for the purposes of
     // dispatching compute shaders for performing various emulation tasks
@@ -75,6 +79,31 @@ struct pl_vk {
     // Array of VkSamplers for every combination of sample/address modes
     VkSampler samplers[PL_TEX_SAMPLE_MODE_COUNT][PL_TEX_ADDRESS_MODE_COUNT];
 
+    // Shared ring of descriptor pools, used to allocate the descriptor sets
+    // of all passes not using push descriptors. See gpu_pass.c
+    pl_mutex dspool_lock;
+    struct vk_dspool *dspool;                  // currently allocating from
+    PL_ARRAY(struct vk_dspool *) dspools;      // all pools, for cleanup
+    PL_ARRAY(struct vk_dspool *) dspools_free; // reset and ready for re-use
+
+    // Vertex input / pre-rasterization pipeline libraries, shared between
+    // all raster passes with identical vertex stages. See gpu_pass.c
+    pl_mutex vert_lib_lock;
+    PL_ARRAY(struct vk_vert_lib *) vert_libs;
+
+    // Worker threads compiling the fragment libraries of new raster passes,
+    // and re-linking raster passes from their pipeline libraries with
+    // link-time optimization, started on demand. See gpu_pass.c
+    pl_mutex link_lock;
+    pl_cond link_work;  // signalled when a pass is queued, or on shutdown
+    pl_cond link_done;  // signalled when a worker finishes a pass
+    pl_thread link_workers[2];
+    int num_link_workers;
+    bool link_started;
+    bool link_quit;
+    PL_ARRAY(pl_pass) frag_queue; // served before `link_queue`
+    PL_ARRAY(pl_pass) link_queue;
+
     // To avoid spamming warnings
     bool warned_modless;
 };
@@ -111,9 +140,12 @@ struct pl_tex_vk {
     pl_sync ext_sync; // indicates an exported image
     bool may_invalidate;
     bool held;
+    // image was never exposed to the user, so its memory may be relocated
+    bool movable;
 };
 
 pl_tex vk_tex_create(pl_gpu, const struct pl_tex_params *);
+pl_tex vk_tex_create_internal(pl_gpu, const struct pl_tex_params *);
 void vk_tex_deref(pl_gpu, pl_tex);
 void vk_tex_invalidate(pl_gpu, pl_tex);
 void vk_tex_clear_ex(pl_gpu, pl_tex, const union pl_clear_color);
@@ -145,6 +177,7 @@ void vk_buf_copy(pl_gpu, pl_buf dst, size_t dst_offset,
                  pl_buf src, size_t src_offset, size_t size);
 bool vk_buf_export(pl_gpu, pl_buf);
 bool vk_buf_poll(pl_gpu, pl_buf, uint64_t timeout);
+bool vk_buf_should_release(pl_gpu, pl_buf);
 
 // Helper to ease buffer barrier creation. (`offset` is relative to pl_buf)
 void vk_buf_barrier(pl_gpu, struct vk_cmd *, pl_buf, VkPipelineStageFlags,
@@ -160,6 +193,12 @@ pl_pass vk_pass_create(pl_gpu, const struct pl_pass_params *);
 void vk_pass_destroy(pl_gpu, pl_pass);
 void vk_pass_run(pl_gpu, const struct pl_pass_run_params *);
 
+// Destroys all descriptor pools. The device must be idle.
+void vk_dspools_destroy(pl_gpu);
+
+// Stops the pipeline link workers, abandoning any queued work.
+void vk_link_workers_destroy(pl_gpu);
+
 struct pl_sync_vk {
     pl_rc_t rc;
     VkSemaphore wait;
@@ -61,10 +61,7 @@ void vk_buf_barrier(pl_gpu gpu, struct vk_cmd *cmd, pl_buf buf,
         .size = size,
     };
 
-    if (last.access || barr.srcQueueFamilyIndex != barr.dstQueueFamilyIndex) {
-        vk->CmdPipelineBarrier(cmd->buf, last.stage, stage, 0, 0, NULL,
-                               1, &barr, 0, NULL);
-    }
+    vk_cmd_buffer_barrier(vk, cmd, last.stage, stage, &barr);
 
     buf_vk->exported = export;
     vk_cmd_callback(cmd, (vk_cb) vk_buf_deref, gpu, buf);
@@ -300,9 +297,8 @@ void vk_buf_flush(pl_gpu gpu, struct vk_cmd *cmd, pl_buf buf,
         .size = size,
     };
 
-    vk->CmdPipelineBarrier(cmd->buf, buf_vk->sem.write.stage,
-                           VK_PIPELINE_STAGE_HOST_BIT, 0,
-                           0, NULL, 1, &buffBarrier, 0, NULL);
+    vk_cmd_buffer_barrier(vk, cmd, buf_vk->sem.write.stage,
+                          VK_PIPELINE_STAGE_HOST_BIT, &buffBarrier);
 
     // We need to hold on to the buffer until this barrier completes
     vk_cmd_callback(cmd, (vk_cb) invalidate_buf, gpu, buf);
@@ -329,6 +325,14 @@ bool vk_buf_poll(pl_gpu gpu, pl_buf buf, uint64_t timeout)
     return pl_rc_count(&buf_vk->rc) > 1;
 }
 
+bool vk_buf_should_release(pl_gpu gpu, pl_buf buf)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_buf_vk *buf_vk = PL_PRIV(buf);
+    return !buf_vk->exported && vk_malloc_should_move(vk->ma, &buf_vk->mem);
+}
+
 void vk_buf_write(pl_gpu gpu, pl_buf buf, size_t offset,
                   const void *data, size_t size)
 {
@@ -355,6 +359,7 @@ void vk_buf_write(pl_gpu gpu, pl_buf buf, size_t offset,
 
         vk_buf_barrier(gpu, cmd, buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
                        VK_ACCESS_TRANSFER_WRITE_BIT, offset, size, false);
+        vk_cmd_flush_barriers(vk, cmd);
 
         // Vulkan requires `size` to be a multiple of 4, so we need to make
         // sure to handle the end separately if the original data is not
@@ -434,6 +439,7 @@ void vk_buf_copy(pl_gpu gpu, pl_buf dst, size_t dst_offset,
                    VK_ACCESS_TRANSFER_WRITE_BIT, dst_offset, size, false);
     vk_buf_barrier(gpu, cmd, src, VK_PIPELINE_STAGE_TRANSFER_BIT,
                    VK_ACCESS_TRANSFER_READ_BIT, src_offset, size, false);
+    vk_cmd_flush_barriers(vk, cmd);
 
     VkBufferCopy region = {
         .srcOffset = src_vk->mem.offset + src_offset,
@@ -450,6 +456,8 @@ void vk_buf_copy(pl_gpu gpu, pl_buf dst, size_t dst_offset,
 
 bool vk_buf_export(pl_gpu gpu, pl_buf buf)
 {
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
     struct pl_buf_vk *buf_vk = PL_PRIV(buf);
     if (buf_vk->exported)
         return true;
@@ -465,6 +473,5 @@ bool vk_buf_export(pl_gpu gpu, pl_buf buf)
     vk_buf_barrier(gpu, cmd, buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
                    0, buf->params.size, true);
 
-
-    return CMD_SUBMIT(&cmd);
+    return CMD_SUBMIT(&cmd) && vk_flush_commands(vk);
 }
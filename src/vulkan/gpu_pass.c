@@ -18,6 +18,13 @@
 #include "gpu.h"
 #include "glsl/spirv.h"
 
+// Descriptor data, in the layout consumed by the descriptor update template
+union pl_desc_data_vk {
+    VkDescriptorImageInfo image;
+    VkDescriptorBufferInfo buffer;
+    VkBufferView texel;
+};
+
 // For pl_pass.priv
 struct pl_pass_vk {
     // Pipeline / render pass
@@ -25,14 +32,11 @@ struct pl_pass_vk {
     VkPipeline pipe;
     VkPipelineLayout pipeLayout;
     VkRenderPass renderPass;
-    // Descriptor set (bindings)
+    // Descriptor set (bindings). Unless using push descriptors, a fresh set
+    // is allocated from the shared descriptor pool ring for every run.
     bool use_pushd;
     VkDescriptorSetLayout dsLayout;
-    VkDescriptorPool dsPool;
-    // To keep track of which descriptor sets are and aren't available, we
-    // allocate a fixed number and use a bitmask of all available sets.
-    VkDescriptorSet dss[16];
-    uint16_t dmask;
+    VkDescriptorUpdateTemplate dsTemplate;
 
     // For recompilation
     VkVertexInputAttributeDescription *attrs;
@@ -40,10 +44,26 @@ struct pl_pass_vk {
     VkShaderModule vert;
     VkShaderModule shader;
 
+    // Graphics pipeline libraries, if used. `pipe` is linked from these
+    struct vk_vert_lib *vert_lib;
+    VkPipeline frag_lib;
+
+    // Compilation of `frag_lib` by a link worker, during pass creation.
+    // Guarded by `pl_vk.link_lock`
+    bool frag_queued;       // pass is in `pl_vk.frag_queue`
+    bool frag_busy;         // fragment library being compiled by a worker
+    VkResult frag_res;      // result of the compilation
+
+    // Link-time optimized replacement for `pipe`, linked from the same
+    // libraries by a background worker. Guarded by `pl_vk.link_lock`
+    bool link_queued;       // pass is in `pl_vk.link_queue`
+    bool link_stale;        // libraries were replaced while linking
+    VkPipeline link_lib;    // fragment library being linked by a worker
+    VkPipeline opt_pipe;    // finished result, not yet swapped in
+    atomic_bool opt_ready;  // `opt_pipe` is valid (readable without lock)
+
     // For updating
-    VkWriteDescriptorSet *dswrite;
-    VkDescriptorImageInfo *dsiinfo;
-    VkDescriptorBufferInfo *dsbinfo;
+    union pl_desc_data_vk *dsdata;
     VkSpecializationInfo specInfo;
     size_t spec_size;
 };
@@ -53,18 +73,24 @@ int vk_desc_namespace(pl_gpu gpu, enum pl_desc_type type)
     return 0;
 }
 
+static void vert_lib_release(pl_gpu gpu, struct vk_vert_lib *lib);
+static void link_cancel(pl_gpu gpu, pl_pass pass, bool wait);
+
 static void pass_destroy_cb(pl_gpu gpu, pl_pass pass)
 {
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
     struct pl_pass_vk *pass_vk = PL_PRIV(pass);
 
+    link_cancel(gpu, pass, true);
     vk->DestroyPipeline(vk->dev, pass_vk->pipe, PL_VK_ALLOC);
     vk->DestroyPipeline(vk->dev, pass_vk->base, PL_VK_ALLOC);
+    vk->DestroyPipeline(vk->dev, pass_vk->frag_lib, PL_VK_ALLOC);
+    vert_lib_release(gpu, pass_vk->vert_lib);
     vk->DestroyRenderPass(vk->dev, pass_vk->renderPass, PL_VK_ALLOC);
     vk->DestroyPipelineLayout(vk->dev, pass_vk->pipeLayout, PL_VK_ALLOC);
     vk->DestroyPipelineCache(vk->dev, pass_vk->cache, PL_VK_ALLOC);
-    vk->DestroyDescriptorPool(vk->dev, pass_vk->dsPool, PL_VK_ALLOC);
+    vk->DestroyDescriptorUpdateTemplate(vk->dev, pass_vk->dsTemplate, PL_VK_ALLOC);
     vk->DestroyDescriptorSetLayout(vk->dev, pass_vk->dsLayout, PL_VK_ALLOC);
     vk->DestroyShaderModule(vk->dev, pass_vk->vert, PL_VK_ALLOC);
     vk->DestroyShaderModule(vk->dev, pass_vk->shader, PL_VK_ALLOC);
@@ -94,6 +120,152 @@ static const VkDescriptorType dsType[] = {
     [PL_DESC_BUF_TEXEL_STORAGE] = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,
 };
 
+static const VkPipelineBindPoint bindPoint[] = {
+    [PL_PASS_RASTER]  = VK_PIPELINE_BIND_POINT_GRAPHICS,
+    [PL_PASS_COMPUTE] = VK_PIPELINE_BIND_POINT_COMPUTE,
+};
+
+// Descriptor sets for all passes are allocated from a shared ring of large
+// descriptor pools, rather than a small dedicated pool per pass. Each pool is
+// retired once exhausted, and reset in bulk (and thus recycled) as soon as all
+// commands using sets allocated from it have completed.
+#define DSPOOL_SETS  256
+#define DSPOOL_DESCS (DSPOOL_SETS * 8)
+
+struct vk_dspool {
+    VkDescriptorPool pool;
+    int pending;  // number of commands still using sets from this pool
+    bool retired; // exhausted, to be reset once `pending` drops to zero
+};
+
+// Must be called with `p->dspool_lock` held
+static void dspool_recycle(pl_gpu gpu, struct vk_dspool *dsp)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    vk->ResetDescriptorPool(vk->dev, dsp->pool, 0);
+    dsp->retired = false;
+    PL_ARRAY_APPEND((void *) gpu, p->dspools_free, dsp);
+}
+
+static void dspool_release(pl_gpu gpu, struct vk_dspool *dsp)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    pl_mutex_lock(&p->dspool_lock);
+    pl_assert(dsp->pending > 0);
+    if (--dsp->pending == 0 && dsp->retired)
+        dspool_recycle(gpu, dsp);
+    pl_mutex_unlock(&p->dspool_lock);
+}
+
+// Must be called with `p->dspool_lock` held
+static struct vk_dspool *dspool_get(pl_gpu gpu)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    struct vk_dspool *dsp;
+    if (PL_ARRAY_POP(p->dspools_free, &dsp))
+        return dsp;
+
+    VkDescriptorPoolSize sizes[PL_DESC_TYPE_COUNT];
+    int num_sizes = 0;
+    for (enum pl_desc_type t = PL_DESC_SAMPLED_TEX; t < PL_DESC_TYPE_COUNT; t++) {
+        sizes[num_sizes++] = (VkDescriptorPoolSize) {
+            .type = dsType[t],
+            .descriptorCount = DSPOOL_DESCS,
+        };
+    }
+
+    VkDescriptorPoolCreateInfo pinfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = DSPOOL_SETS,
+        .pPoolSizes = sizes,
+        .poolSizeCount = num_sizes,
+    };
+
+    dsp = pl_zalloc_ptr((void *) gpu, dsp);
+    VK(vk->CreateDescriptorPool(vk->dev, &pinfo, PL_VK_ALLOC, &dsp->pool));
+    PL_ARRAY_APPEND((void *) gpu, p->dspools, dsp);
+    PL_DEBUG(gpu, "Created descriptor pool #%d", p->dspools.num);
+    return dsp;
+
+error:
+    pl_free(dsp);
+    return NULL;
+}
+
+// Allocates a descriptor set for `pass`, which remains valid until `cmd`
+// completes. Returns VK_NULL_HANDLE on failure.
+static VkDescriptorSet dspool_alloc(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    VkDescriptorSet ds = VK_NULL_HANDLE;
+
+    pl_mutex_lock(&p->dspool_lock);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!p->dspool && !(p->dspool = dspool_get(gpu)))
+            break;
+
+        struct vk_dspool *dsp = p->dspool;
+        VkDescriptorSetAllocateInfo ainfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = dsp->pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &pass_vk->dsLayout,
+        };
+
+        if (vk->AllocateDescriptorSets(vk->dev, &ainfo, &ds) == VK_SUCCESS) {
+            dsp->pending++;
+            vk_cmd_callback(cmd, (vk_cb) dspool_release, gpu, dsp);
+            break;
+        }
+
+        // Pool exhausted (or fragmented), retire it and move on to the next
+        ds = VK_NULL_HANDLE;
+        p->dspool = NULL;
+        dsp->retired = true;
+        if (!dsp->pending)
+            dspool_recycle(gpu, dsp);
+    }
+    pl_mutex_unlock(&p->dspool_lock);
+
+    if (!ds)
+        PL_ERR(gpu, "Failed allocating descriptor set!");
+    return ds;
+}
+
+void vk_dspools_destroy(pl_gpu gpu)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    for (int i = 0; i < p->dspools.num; i++) {
+        vk->DestroyDescriptorPool(vk->dev, p->dspools.elem[i]->pool, PL_VK_ALLOC);
+        pl_free(p->dspools.elem[i]);
+    }
+
+    p->dspools.num = p->dspools_free.num = 0;
+    p->dspool = NULL;
+}
+
+void vk_link_workers_destroy(pl_gpu gpu)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+
+    pl_mutex_lock(&p->link_lock);
+    p->link_quit = true;
+    pl_cond_broadcast(&p->link_work);
+    pl_mutex_unlock(&p->link_lock);
+
+    for (int i = 0; i < p->num_link_workers; i++)
+        pl_thread_join(p->link_workers[i]);
+    p->num_link_workers = 0;
+}
+
 #define CACHE_MAGIC {'P','L','V','K'}
 #define CACHE_VERSION 4
 static const char vk_cache_magic[4] = CACHE_MAGIC;
@@ -181,6 +353,580 @@ static void destroy_pipeline(struct vk_ctx *vk, VkPipeline pipeline)
     vk->DestroyPipeline(vk->dev, pipeline, PL_VK_ALLOC);
 }
 
+// Subsets of graphics pipeline state, for VK_EXT_graphics_pipeline_library.
+// Zero means "complete pipeline"
+#ifdef VK_EXT_graphics_pipeline_library
+#define GPL_VERTEX (VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT | \
+                    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+#define GPL_FRAGMENT (VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT | \
+                      VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+#endif
+
+// Creates a graphics pipeline for `pass`. If `subsets` is nonzero, only
+// creates a pipeline library containing these subsets of state. If `libs` is
+// non-NULL, instead links a complete pipeline from the given libraries.
+static VkResult create_graphics_pipeline(struct vk_ctx *vk, pl_pass pass,
+                                         VkPipelineCreateFlags flags,
+                                         VkPipeline base, uint32_t subsets,
+                                         const VkPipeline *libs, int num_libs,
+                                         VkPipeline *out_pipe)
+{
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    const struct pl_pass_params *params = &pass->params;
+
+    const VkSpecializationInfo *specInfo = &pass_vk->specInfo;
+    if (!specInfo->dataSize)
+        specInfo = NULL;
+
+    static const VkBlendFactor blendFactors[] = {
+        [PL_BLEND_ZERO]                = VK_BLEND_FACTOR_ZERO,
+        [PL_BLEND_ONE]                 = VK_BLEND_FACTOR_ONE,
+        [PL_BLEND_SRC_ALPHA]           = VK_BLEND_FACTOR_SRC_ALPHA,
+        [PL_BLEND_ONE_MINUS_SRC_ALPHA] = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    };
+
+    VkPipelineColorBlendAttachmentState blendState = {
+        .colorBlendOp = VK_BLEND_OP_ADD,
+        .alphaBlendOp = VK_BLEND_OP_ADD,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+                          VK_COLOR_COMPONENT_G_BIT |
+                          VK_COLOR_COMPONENT_B_BIT |
+                          VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    const struct pl_blend_params *blend = params->blend_params;
+    if (blend) {
+        blendState.blendEnable = true;
+        blendState.srcColorBlendFactor = blendFactors[blend->src_rgb];
+        blendState.dstColorBlendFactor = blendFactors[blend->dst_rgb];
+        blendState.srcAlphaBlendFactor = blendFactors[blend->src_alpha];
+        blendState.dstAlphaBlendFactor = blendFactors[blend->dst_alpha];
+    }
+
+    static const VkPrimitiveTopology topologies[PL_PRIM_TYPE_COUNT] = {
+        [PL_PRIM_TRIANGLE_LIST]  = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        [PL_PRIM_TRIANGLE_STRIP] = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    };
+
+    VkPipelineShaderStageCreateInfo stages[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = pass_vk->vert,
+            .pName = "main",
+        }, {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = pass_vk->shader,
+            .pName = "main",
+            .pSpecializationInfo = specInfo,
+        }
+    };
+
+    VkGraphicsPipelineCreateInfo cinfo = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .flags = flags,
+        .stageCount = PL_ARRAY_SIZE(stages),
+        .pStages = stages,
+        .pVertexInputState = &(VkPipelineVertexInputStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .vertexBindingDescriptionCount = 1,
+            .pVertexBindingDescriptions = &(VkVertexInputBindingDescription) {
+                .binding = 0,
+                .stride = params->vertex_stride,
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+            },
+            .vertexAttributeDescriptionCount = params->num_vertex_attribs,
+            .pVertexAttributeDescriptions = pass_vk->attrs,
+        },
+        .pInputAssemblyState = &(VkPipelineInputAssemblyStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = topologies[params->vertex_type],
+        },
+        .pViewportState = &(VkPipelineViewportStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .viewportCount = 1,
+            .scissorCount = 1,
+        },
+        .pRasterizationState = &(VkPipelineRasterizationStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .polygonMode = VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_NONE,
+            .lineWidth = 1.0f,
+        },
+        .pMultisampleState = &(VkPipelineMultisampleStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        },
+        .pColorBlendState = &(VkPipelineColorBlendStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .attachmentCount = 1,
+            .pAttachments = &blendState,
+        },
+        .pDynamicState = &(VkPipelineDynamicStateCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = 2,
+            .pDynamicStates = (VkDynamicState[]){
+                VK_DYNAMIC_STATE_VIEWPORT,
+                VK_DYNAMIC_STATE_SCISSOR,
+            },
+        },
+        .layout = pass_vk->pipeLayout,
+        .renderPass = pass_vk->renderPass,
+        .basePipelineHandle = base,
+        .basePipelineIndex = -1,
+    };
+
+#ifdef VK_EXT_graphics_pipeline_library
+    VkGraphicsPipelineLibraryCreateInfoEXT lib_info = {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .flags = subsets,
+    };
+
+    VkPipelineLibraryCreateInfoKHR link_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = num_libs,
+        .pLibraries = libs,
+    };
+
+    if (subsets) {
+        // State belonging to other subsets is ignored, except for the
+        // shader stages, which must match the subsets exactly. Retain the
+        // information needed to later re-link with link-time optimization.
+        pl_assert(subsets == GPL_VERTEX || subsets == GPL_FRAGMENT);
+        cinfo.pNext = &lib_info;
+        cinfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+                       VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        cinfo.stageCount = 1;
+        cinfo.pStages = &stages[subsets == GPL_VERTEX ? 0 : 1];
+    } else if (libs) {
+        // Fast link, unless `flags` requests link-time optimization
+        cinfo.pNext = &link_info;
+        cinfo.stageCount = 0;
+        cinfo.pStages = NULL;
+    }
+#else
+    pl_assert(!subsets && !libs);
+#endif
+
+    return vk->CreateGraphicsPipelines(vk->dev, pass_vk->cache, 1, &cinfo,
+                                       PL_VK_ALLOC, out_pipe);
+}
+
+#ifdef VK_EXT_graphics_pipeline_library
+
+// Vertex input interface and pre-rasterization state, shared between all
+// raster passes that only differ in their fragment stage
+struct vk_vert_lib {
+    uint64_t key;
+    int refcount;
+    VkPipeline pipe;
+};
+
+// Hashes everything that goes into the vertex library. Since the pipeline
+// layout of the library must be identically defined to that of every pass
+// linking it, this includes the descriptor bindings and push constants, and
+// the target format for render pass compatibility.
+static uint64_t vert_lib_key(const struct pl_pass_params *params, pl_str vert)
+{
+    uint64_t key = pl_str_hash(vert);
+    pl_hash_merge(&key, params->target_format->signature);
+    pl_hash_merge(&key, params->vertex_type);
+    pl_hash_merge(&key, params->vertex_stride);
+    for (int i = 0; i < params->num_vertex_attribs; i++) {
+        const struct pl_vertex_attrib *va = &params->vertex_attribs[i];
+        pl_hash_merge(&key, va->fmt->signature);
+        pl_hash_merge(&key, va->location);
+        pl_hash_merge(&key, va->offset);
+    }
+
+    pl_hash_merge(&key, params->num_descriptors);
+    for (int i = 0; i < params->num_descriptors; i++) {
+        pl_hash_merge(&key, params->descriptors[i].binding);
+        pl_hash_merge(&key, params->descriptors[i].type);
+    }
+
+    pl_hash_merge(&key, params->push_constants_size);
+    return key;
+}
+
+static VkResult vert_lib_acquire(pl_gpu gpu, pl_pass pass, uint64_t key)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    VkResult res = VK_SUCCESS;
+
+    pl_mutex_lock(&p->vert_lib_lock);
+    for (int i = 0; i < p->vert_libs.num; i++) {
+        struct vk_vert_lib *lib = p->vert_libs.elem[i];
+        if (lib->key == key) {
+            lib->refcount++;
+            pass_vk->vert_lib = lib;
+            goto done;
+        }
+    }
+
+    VkPipeline pipe = VK_NULL_HANDLE;
+    res = create_graphics_pipeline(vk, pass, 0, VK_NULL_HANDLE, GPL_VERTEX,
+                                   NULL, 0, &pipe);
+    if (res != VK_SUCCESS)
+        goto done;
+
+    struct vk_vert_lib *lib = pl_alloc_ptr(NULL, lib);
+    *lib = (struct vk_vert_lib) {
+        .key = key,
+        .refcount = 1,
+        .pipe = pipe,
+    };
+
+    PL_ARRAY_APPEND((void *) gpu, p->vert_libs, lib);
+    pass_vk->vert_lib = lib;
+    PL_DEBUG(gpu, "Created new vertex pipeline library (%d total)",
+             p->vert_libs.num);
+
+done:
+    pl_mutex_unlock(&p->vert_lib_lock);
+    return res;
+}
+
+static void vert_lib_release(pl_gpu gpu, struct vk_vert_lib *lib)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    if (!lib)
+        return;
+
+    pl_mutex_lock(&p->vert_lib_lock);
+    if (--lib->refcount == 0) {
+        for (int i = 0; i < p->vert_libs.num; i++) {
+            if (p->vert_libs.elem[i] == lib) {
+                PL_ARRAY_REMOVE_AT(p->vert_libs, i);
+                break;
+            }
+        }
+
+        vk->DestroyPipeline(vk->dev, lib->pipe, PL_VK_ALLOC);
+        pl_free(lib);
+    }
+    pl_mutex_unlock(&p->vert_lib_lock);
+}
+
+static VkResult vk_link_libraries(struct vk_ctx *vk, pl_pass pass,
+                                  VkPipeline *out_pipe)
+{
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    VkPipeline libs[] = { pass_vk->vert_lib->pipe, pass_vk->frag_lib };
+    return create_graphics_pipeline(vk, pass, 0, VK_NULL_HANDLE, 0,
+                                    libs, PL_ARRAY_SIZE(libs), out_pipe);
+}
+
+static void frag_compile(struct vk_ctx *vk, pl_pass pass)
+{
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    pass_vk->frag_res = create_graphics_pipeline(vk, pass, 0, VK_NULL_HANDLE,
+                                                 GPL_FRAGMENT, NULL, 0,
+                                                 &pass_vk->frag_lib);
+}
+
+// Fast-linked pipelines may be noticeably slower than monolithic ones, so
+// every raster pass is additionally re-linked with link-time optimization by
+// a small pool of background workers. The result replaces the fast-linked
+// pipeline on the next run of the pass, see `link_swap`. The same workers
+// also compile the fragment libraries of newly created passes, which takes
+// priority since pass creation is blocked on it.
+static pl_pass link_next(struct pl_vk *p)
+{
+    for (int i = 0; i < p->link_queue.num; i++) {
+        pl_pass pass = p->link_queue.elem[i];
+        struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+        if (pass_vk->link_lib)
+            continue; // still busy with a stale link of the same pass
+
+        PL_ARRAY_REMOVE_AT(p->link_queue, i);
+        pass_vk->link_queued = false;
+        return pass;
+    }
+
+    return NULL;
+}
+
+static PL_THREAD_VOID link_worker(void *priv)
+{
+    pl_gpu gpu = priv;
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    pl_mutex_lock(&p->link_lock);
+    while (!p->link_quit) {
+        if (p->frag_queue.num) {
+            pl_pass pass = p->frag_queue.elem[0];
+            struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+            PL_ARRAY_REMOVE_AT(p->frag_queue, 0);
+            pass_vk->frag_queued = false;
+            pass_vk->frag_busy = true;
+            pl_mutex_unlock(&p->link_lock);
+
+            frag_compile(vk, pass);
+
+            pl_mutex_lock(&p->link_lock);
+            pass_vk->frag_busy = false;
+            pl_cond_broadcast(&p->link_done);
+            continue;
+        }
+
+        pl_pass pass = link_next(p);
+        if (!pass) {
+            pl_cond_wait(&p->link_work, &p->link_lock);
+            continue;
+        }
+
+        struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+        VkPipeline libs[] = { pass_vk->vert_lib->pipe, pass_vk->frag_lib };
+        pass_vk->link_lib = pass_vk->frag_lib;
+        pl_mutex_unlock(&p->link_lock);
+
+        clock_t start = clock();
+        VkPipeline pipe = VK_NULL_HANDLE;
+        VkResult res = create_graphics_pipeline(vk, pass,
+                            VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT,
+                            VK_NULL_HANDLE, 0, libs, PL_ARRAY_SIZE(libs), &pipe);
+        pl_log_cpu_time(gpu->log, start, clock(), "optimizing pipeline");
+
+        pl_mutex_lock(&p->link_lock);
+        if (pass_vk->link_stale) {
+            // The pass was re-specialized in the meantime, which left the
+            // outdated fragment library to us
+            vk->DestroyPipeline(vk->dev, pipe, PL_VK_ALLOC);
+            vk->DestroyPipeline(vk->dev, pass_vk->link_lib, PL_VK_ALLOC);
+            pass_vk->link_stale = false;
+        } else if (res == VK_SUCCESS) {
+            pl_assert(!pass_vk->opt_pipe);
+            pass_vk->opt_pipe = pipe;
+            atomic_store(&pass_vk->opt_ready, true);
+        } else {
+            PL_WARN(gpu, "Failed linking optimized pipeline: %s", vk_res_str(res));
+        }
+
+        pass_vk->link_lib = VK_NULL_HANDLE;
+        pl_cond_broadcast(&p->link_done);
+        pl_cond_broadcast(&p->link_work); // may unblock skipped passes
+    }
+
+    pl_mutex_unlock(&p->link_lock);
+    PL_THREAD_RETURN();
+}
+
+// Starts the link workers on first use. Returns whether any are available.
+// Must be called with `link_lock` held.
+static bool link_start(pl_gpu gpu)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    if (!p->link_started) {
+        p->link_started = true;
+        for (int i = 0; i < PL_ARRAY_SIZE(p->link_workers); i++) {
+            if (pl_thread_create(&p->link_workers[i], link_worker, (void *) gpu) != 0)
+                break;
+            p->num_link_workers++;
+        }
+
+        if (!p->num_link_workers)
+            PL_WARN(gpu, "Failed creating pipeline link workers, raster "
+                    "passes will not be link-time optimized!");
+    }
+
+    return p->num_link_workers && !p->link_quit;
+}
+
+static void link_queue(pl_gpu gpu, pl_pass pass)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+
+    pl_mutex_lock(&p->link_lock);
+    if (link_start(gpu) && !pass_vk->link_queued) {
+        PL_ARRAY_APPEND((void *) gpu, p->link_queue, pass);
+        pass_vk->link_queued = true;
+        pl_cond_signal(&p->link_work);
+    }
+    pl_mutex_unlock(&p->link_lock);
+}
+
+// Abandons any pending or finished link-time optimization of `pass`. If a
+// worker is still linking the pass, this either waits for it (if `wait` is
+// set), or hands it the current fragment library, which the worker destroys
+// once done. In the latter case, `frag_lib` is reset to VK_NULL_HANDLE.
+static void link_cancel(pl_gpu gpu, pl_pass pass, bool wait)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+
+    pl_mutex_lock(&p->link_lock);
+    if (pass_vk->link_queued) {
+        for (int i = 0; i < p->link_queue.num; i++) {
+            if (p->link_queue.elem[i] == pass) {
+                PL_ARRAY_REMOVE_AT(p->link_queue, i);
+                break;
+            }
+        }
+        pass_vk->link_queued = false;
+    }
+
+    while (wait && pass_vk->link_lib)
+        pl_cond_wait(&p->link_done, &p->link_lock);
+
+    if (pass_vk->link_lib && !pass_vk->link_stale) {
+        pl_assert(pass_vk->link_lib == pass_vk->frag_lib);
+        pass_vk->link_stale = true;
+        pass_vk->frag_lib = VK_NULL_HANDLE;
+    }
+
+    if (atomic_load(&pass_vk->opt_ready)) {
+        // Never used for rendering, so this can be destroyed immediately
+        vk->DestroyPipeline(vk->dev, pass_vk->opt_pipe, PL_VK_ALLOC);
+        pass_vk->opt_pipe = VK_NULL_HANDLE;
+        atomic_store(&pass_vk->opt_ready, false);
+    }
+    pl_mutex_unlock(&p->link_lock);
+}
+
+// Replaces the fast-linked pipeline by the optimized one, if available
+static void link_swap(pl_gpu gpu, pl_pass pass)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    if (!atomic_load(&pass_vk->opt_ready))
+        return;
+
+    pl_mutex_lock(&p->link_lock);
+    VkPipeline pipe = pass_vk->opt_pipe;
+    pass_vk->opt_pipe = VK_NULL_HANDLE;
+    atomic_store(&pass_vk->opt_ready, false);
+    pl_mutex_unlock(&p->link_lock);
+    if (!pipe)
+        return;
+
+    // The old pipeline may still be referenced by the current command
+    pl_mutex_lock(&p->recording);
+    if (p->cmd) {
+        vk_cmd_callback(p->cmd, (vk_cb) destroy_pipeline, vk, pass_vk->pipe);
+    } else {
+        vk_dev_callback(vk, (vk_cb) destroy_pipeline, vk, pass_vk->pipe);
+    }
+    pl_mutex_unlock(&p->recording);
+
+    PL_TRACE(gpu, "Replacing fast-linked pipeline by optimized pipeline");
+    pass_vk->pipe = pipe;
+}
+
+// Creates the pipeline libraries for a new raster pass and fast-links them.
+// The fragment library is compiled by a link worker while this thread
+// acquires the vertex library, which is usually shared with previously
+// created passes. If no worker picked up the fragment library by then, it is
+// compiled inline instead. The optimized link happens in the background, see
+// `link_queue`.
+static VkResult vk_create_libraries(pl_gpu gpu, pl_pass pass, pl_str vert)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+
+    pl_mutex_lock(&p->link_lock);
+    bool queued = link_start(gpu);
+    if (queued) {
+        PL_ARRAY_APPEND((void *) gpu, p->frag_queue, pass);
+        pass_vk->frag_queued = true;
+        pl_cond_signal(&p->link_work);
+    }
+    pl_mutex_unlock(&p->link_lock);
+
+    VkResult res = vert_lib_acquire(gpu, pass, vert_lib_key(&pass->params, vert));
+
+    // Wait for the worker, or take the job back if it was never started. This
+    // also happens on failure, since the pass is about to be destroyed
+    pl_mutex_lock(&p->link_lock);
+    while (pass_vk->frag_busy)
+        pl_cond_wait(&p->link_done, &p->link_lock);
+    if (pass_vk->frag_queued) {
+        for (int i = 0; i < p->frag_queue.num; i++) {
+            if (p->frag_queue.elem[i] == pass) {
+                PL_ARRAY_REMOVE_AT(p->frag_queue, i);
+                break;
+            }
+        }
+        pass_vk->frag_queued = false;
+        queued = false;
+    }
+    pl_mutex_unlock(&p->link_lock);
+
+    if (res != VK_SUCCESS)
+        return res;
+
+    if (!queued)
+        frag_compile(vk, pass);
+    if (pass_vk->frag_res != VK_SUCCESS)
+        return pass_vk->frag_res;
+
+    return vk_link_libraries(vk, pass, &pass_vk->pipe);
+}
+
+// Only the fragment library depends on the specialization constants, so
+// re-specializing just recompiles that and re-links the pipeline. Any
+// pending link-time optimization must have been cancelled beforehand.
+static VkResult vk_respec_libraries(struct vk_ctx *vk, pl_pass pass,
+                                    VkPipeline *out_pipe)
+{
+    struct pl_pass_vk *pass_vk = PL_PRIV(pass);
+    if (pass_vk->frag_lib) {
+        vk_dev_callback(vk, (vk_cb) destroy_pipeline, vk, pass_vk->frag_lib);
+        pass_vk->frag_lib = VK_NULL_HANDLE;
+    }
+
+    VkResult res;
+    res = create_graphics_pipeline(vk, pass, 0, VK_NULL_HANDLE, GPL_FRAGMENT,
+                                   NULL, 0, &pass_vk->frag_lib);
+    if (res != VK_SUCCESS)
+        return res;
+
+    return vk_link_libraries(vk, pass, out_pipe);
+}
+
+#else // !VK_EXT_graphics_pipeline_library
+
+// `pl_vk.gpl` is never set in this case
+static void vert_lib_release(pl_gpu gpu, struct vk_vert_lib *lib)
+{
+    pl_assert(!lib);
+}
+
+static void link_queue(pl_gpu gpu, pl_pass pass)
+{
+    pl_unreachable();
+}
+
+static void link_cancel(pl_gpu gpu, pl_pass pass, bool wait)
+{
+}
+
+static void link_swap(pl_gpu gpu, pl_pass pass)
+{
+}
+
+static VkResult vk_create_libraries(pl_gpu gpu, pl_pass pass, pl_str vert)
+{
+    pl_unreachable();
+}
+
+static VkResult vk_respec_libraries(struct vk_ctx *vk, pl_pass pass,
+                                    VkPipeline *out_pipe)
+{
+    pl_unreachable();
+}
+
+#endif // VK_EXT_graphics_pipeline_library
+
 static VkResult vk_recreate_pipelines(struct vk_ctx *vk, pl_pass pass,
                                       bool derivable, VkPipeline base,
                                       VkPipeline *out_pipe)
@@ -206,107 +952,11 @@ static VkResult vk_recreate_pipelines(struct vk_ctx *vk, pl_pass pass,
         specInfo = NULL;
 
     switch (params->type) {
-    case PL_PASS_RASTER: {
-        static const VkBlendFactor blendFactors[] = {
-            [PL_BLEND_ZERO]                = VK_BLEND_FACTOR_ZERO,
-            [PL_BLEND_ONE]                 = VK_BLEND_FACTOR_ONE,
-            [PL_BLEND_SRC_ALPHA]           = VK_BLEND_FACTOR_SRC_ALPHA,
-            [PL_BLEND_ONE_MINUS_SRC_ALPHA] = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-        };
-
-        VkPipelineColorBlendAttachmentState blendState = {
-            .colorBlendOp = VK_BLEND_OP_ADD,
-            .alphaBlendOp = VK_BLEND_OP_ADD,
-            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
-                              VK_COLOR_COMPONENT_G_BIT |
-                              VK_COLOR_COMPONENT_B_BIT |
-                              VK_COLOR_COMPONENT_A_BIT,
-        };
-
-        const struct pl_blend_params *blend = params->blend_params;
-        if (blend) {
-            blendState.blendEnable = true;
-            blendState.srcColorBlendFactor = blendFactors[blend->src_rgb];
-            blendState.dstColorBlendFactor = blendFactors[blend->dst_rgb];
-            blendState.srcAlphaBlendFactor = blendFactors[blend->src_alpha];
-            blendState.dstAlphaBlendFactor = blendFactors[blend->dst_alpha];
-        }
-
-        static const VkPrimitiveTopology topologies[PL_PRIM_TYPE_COUNT] = {
-            [PL_PRIM_TRIANGLE_LIST]  = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-            [PL_PRIM_TRIANGLE_STRIP] = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
-        };
-
-        VkGraphicsPipelineCreateInfo cinfo = {
-            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-            .flags = flags,
-            .stageCount = 2,
-            .pStages = (VkPipelineShaderStageCreateInfo[]) {
-                {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                    .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                    .module = pass_vk->vert,
-                    .pName = "main",
-                }, {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                    .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                    .module = pass_vk->shader,
-                    .pName = "main",
-                    .pSpecializationInfo = specInfo,
-                }
-            },
-            .pVertexInputState = &(VkPipelineVertexInputStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-                .vertexBindingDescriptionCount = 1,
-                .pVertexBindingDescriptions = &(VkVertexInputBindingDescription) {
-                    .binding = 0,
-                    .stride = params->vertex_stride,
-                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-                },
-                .vertexAttributeDescriptionCount = params->num_vertex_attribs,
-                .pVertexAttributeDescriptions = pass_vk->attrs,
-            },
-            .pInputAssemblyState = &(VkPipelineInputAssemblyStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-                .topology = topologies[params->vertex_type],
-            },
-            .pViewportState = &(VkPipelineViewportStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-                .viewportCount = 1,
-                .scissorCount = 1,
-            },
-            .pRasterizationState = &(VkPipelineRasterizationStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-                .polygonMode = VK_POLYGON_MODE_FILL,
-                .cullMode = VK_CULL_MODE_NONE,
-                .lineWidth = 1.0f,
-            },
-            .pMultisampleState = &(VkPipelineMultisampleStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-            },
-            .pColorBlendState = &(VkPipelineColorBlendStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-                .attachmentCount = 1,
-                .pAttachments = &blendState,
-            },
-            .pDynamicState = &(VkPipelineDynamicStateCreateInfo) {
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-                .dynamicStateCount = 2,
-                .pDynamicStates = (VkDynamicState[]){
-                    VK_DYNAMIC_STATE_VIEWPORT,
-                    VK_DYNAMIC_STATE_SCISSOR,
-                },
-            },
-            .layout = pass_vk->pipeLayout,
-            .renderPass = pass_vk->renderPass,
-            .basePipelineHandle = base,
-            .basePipelineIndex = -1,
-        };
-
-        return vk->CreateGraphicsPipelines(vk->dev, pass_vk->cache, 1, &cinfo,
-                                           PL_VK_ALLOC, out_pipe);
-    }
+    case PL_PASS_RASTER:
+        if (pass_vk->vert_lib)
+            return vk_respec_libraries(vk, pass, out_pipe);
+        return create_graphics_pipeline(vk, pass, flags, base, 0, NULL, 0,
+                                        out_pipe);
 
     case PL_PASS_COMPUTE: {
         VkComputePipelineCreateInfo cinfo = {
@@ -346,7 +996,6 @@ pl_pass vk_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
     pass->params = pl_pass_params_copy(pass, params);
 
     struct pl_pass_vk *pass_vk = PL_PRIV(pass);
-    pass_vk->dmask = -1; // all descriptors available
 
     // temporary allocations
     void *tmp = pl_tmp(NULL);
@@ -361,13 +1010,7 @@ pl_pass vk_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
         goto error;
     }
 
-    pass_vk->dswrite = pl_calloc(pass, num_desc, sizeof(VkWriteDescriptorSet));
-    pass_vk->dsiinfo = pl_calloc(pass, num_desc, sizeof(VkDescriptorImageInfo));
-    pass_vk->dsbinfo = pl_calloc(pass, num_desc, sizeof(VkDescriptorBufferInfo));
-
-#define NUM_DS (PL_ARRAY_SIZE(pass_vk->dss))
-
-    static int dsSize[PL_DESC_TYPE_COUNT] = {0};
+    pass_vk->dsdata = pl_calloc_ptr(pass, num_desc, pass_vk->dsdata);
     VkDescriptorSetLayoutBinding *bindings = pl_calloc_ptr(tmp, num_desc, bindings);
 
     uint32_t max_tex = vk->limits.maxPerStageDescriptorSampledImages,
@@ -392,7 +1035,6 @@ pl_pass vk_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
             goto error;
         }
 
-        dsSize[desc->type]++;
         bindings[i] = (VkDescriptorSetLayoutBinding) {
             .binding = desc->binding,
             .descriptorType = dsType[desc->type],
@@ -419,43 +1061,6 @@ pl_pass vk_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
     VK(vk->CreateDescriptorSetLayout(vk->dev, &dinfo, PL_VK_ALLOC,
                                      &pass_vk->dsLayout));
 
-    if (!pass_vk->use_pushd) {
-        PL_ARRAY(VkDescriptorPoolSize) dsPoolSizes = {0};
-
-        for (enum pl_desc_type t = 0; t < PL_DESC_TYPE_COUNT; t++) {
-            if (dsSize[t] > 0) {
-                PL_ARRAY_APPEND(tmp, dsPoolSizes, (VkDescriptorPoolSize) {
-                    .type = dsType[t],
-                    .descriptorCount = dsSize[t] * NUM_DS,
-                });
-            }
-        }
-
-        if (dsPoolSizes.num) {
-            VkDescriptorPoolCreateInfo pinfo = {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                .maxSets = NUM_DS,
-                .pPoolSizes = dsPoolSizes.elem,
-                .poolSizeCount = dsPoolSizes.num,
-            };
-
-            VK(vk->CreateDescriptorPool(vk->dev, &pinfo, PL_VK_ALLOC, &pass_vk->dsPool));
-
-            VkDescriptorSetLayout layouts[NUM_DS];
-            for (int i = 0; i < NUM_DS; i++)
-                layouts[i] = pass_vk->dsLayout;
-
-            VkDescriptorSetAllocateInfo ainfo = {
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                .descriptorPool = pass_vk->dsPool,
-                .descriptorSetCount = NUM_DS,
-                .pSetLayouts = layouts,
-            };
-
-            VK(vk->AllocateDescriptorSets(vk->dev, &ainfo, pass_vk->dss));
-        }
-    }
-
 no_descriptors: ;
 
     bool has_spec = params->num_constants;
@@ -504,6 +1109,36 @@ no_descriptors: ;
     VK(vk->CreatePipelineLayout(vk->dev, &linfo, PL_VK_ALLOC,
                                 &pass_vk->pipeLayout));
 
+    if (num_desc) {
+        VkDescriptorUpdateTemplateEntry *entries;
+        entries = pl_calloc_ptr(tmp, num_desc, entries);
+        for (int i = 0; i < num_desc; i++) {
+            entries[i] = (VkDescriptorUpdateTemplateEntry) {
+                .dstBinding = params->descriptors[i].binding,
+                .descriptorCount = 1,
+                .descriptorType = dsType[params->descriptors[i].type],
+                .offset = i * sizeof(union pl_desc_data_vk),
+                .stride = sizeof(union pl_desc_data_vk),
+            };
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo tinfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+            .descriptorUpdateEntryCount = num_desc,
+            .pDescriptorUpdateEntries = entries,
+            .templateType = pass_vk->use_pushd
+                ? VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR
+                : VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+            .descriptorSetLayout = pass_vk->dsLayout,
+            .pipelineBindPoint = bindPoint[params->type],
+            .pipelineLayout = pass_vk->pipeLayout,
+            .set = 0,
+        };
+
+        VK(vk->CreateDescriptorUpdateTemplate(vk->dev, &tinfo, PL_VK_ALLOC,
+                                              &pass_vk->dsTemplate));
+    }
+
     pl_str vert = {0}, frag = {0}, comp = {0}, pipecache = {0};
     uint64_t sig = cache_signature(gpu, params);
     if (vk_use_cached_program(params, p->spirv, &vert, &frag, &comp, &pipecache, sig)) {
@@ -611,8 +1246,12 @@ no_descriptors: ;
     pl_log_cpu_time(gpu->log, start, after_compilation, "compiling shader");
 
     // Create the graphics/compute pipeline
-    VkPipeline *pipe = has_spec ? &pass_vk->base : &pass_vk->pipe;
-    VK(vk_recreate_pipelines(vk, pass, has_spec, NULL, pipe));
+    if (p->gpl && params->type == PL_PASS_RASTER) {
+        VK(vk_create_libraries(gpu, pass, vert));
+    } else {
+        VkPipeline *pipe = has_spec ? &pass_vk->base : &pass_vk->pipe;
+        VK(vk_recreate_pipelines(vk, pass, has_spec, NULL, pipe));
+    }
     pl_log_cpu_time(gpu->log, after_compilation, clock(), "creating pipeline");
 
     if (!has_spec) {
@@ -656,6 +1295,11 @@ no_descriptors: ;
     pass->params.cached_program = prog.buf;
     pass->params.cached_program_len = prog.len;
 
+    // Only start optimizing once the pass is fully set up, since the link
+    // workers access it concurrently from here on
+    if (pass_vk->vert_lib)
+        link_queue(gpu, pass);
+
     success = true;
 
 error:
@@ -677,21 +1321,12 @@ static const VkPipelineStageFlags passStages[] = {
 };
 
 static void vk_update_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
-                                 struct pl_desc_binding db,
-                                 VkDescriptorSet ds, int idx)
+                                 struct pl_desc_binding db, int idx)
 {
     struct pl_vk *p = PL_PRIV(gpu);
     struct pl_pass_vk *pass_vk = PL_PRIV(pass);
     struct pl_desc *desc = &pass->params.descriptors[idx];
-
-    VkWriteDescriptorSet *wds = &pass_vk->dswrite[idx];
-    *wds = (VkWriteDescriptorSet) {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = ds,
-        .dstBinding = desc->binding,
-        .descriptorCount = 1,
-        .descriptorType = dsType[desc->type],
-    };
+    union pl_desc_data_vk *data = &pass_vk->dsdata[idx];
 
     static const VkAccessFlags access[PL_DESC_ACCESS_COUNT] = {
         [PL_DESC_ACCESS_READONLY]   = VK_ACCESS_SHADER_READ_BIT,
@@ -709,14 +1344,11 @@ static void vk_update_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
                       VK_ACCESS_SHADER_READ_BIT,
                       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false);
 
-        VkDescriptorImageInfo *iinfo = &pass_vk->dsiinfo[idx];
-        *iinfo = (VkDescriptorImageInfo) {
+        data->image = (VkDescriptorImageInfo) {
             .sampler = p->samplers[db.sample_mode][db.address_mode],
             .imageView = tex_vk->view,
             .imageLayout = tex_vk->layout,
         };
-
-        wds->pImageInfo = iinfo;
         return;
     }
     case PL_DESC_STORAGE_IMG: {
@@ -726,13 +1358,10 @@ static void vk_update_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
         vk_tex_barrier(gpu, cmd, tex, passStages[pass->params.type],
                        access[desc->access], VK_IMAGE_LAYOUT_GENERAL, false);
 
-        VkDescriptorImageInfo *iinfo = &pass_vk->dsiinfo[idx];
-        *iinfo = (VkDescriptorImageInfo) {
+        data->image = (VkDescriptorImageInfo) {
             .imageView = tex_vk->view,
             .imageLayout = tex_vk->layout,
         };
-
-        wds->pImageInfo = iinfo;
         return;
     }
     case PL_DESC_BUF_UNIFORM:
@@ -743,14 +1372,11 @@ static void vk_update_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
         vk_buf_barrier(gpu, cmd, buf, passStages[pass->params.type],
                        access[desc->access], 0, buf->params.size, false);
 
-        VkDescriptorBufferInfo *binfo = &pass_vk->dsbinfo[idx];
-        *binfo = (VkDescriptorBufferInfo) {
+        data->buffer = (VkDescriptorBufferInfo) {
             .buffer = buf_vk->mem.buf,
             .offset = buf_vk->mem.offset,
             .range = buf->params.size,
         };
-
-        wds->pBufferInfo = binfo;
         return;
     }
     case PL_DESC_BUF_TEXEL_UNIFORM:
@@ -761,7 +1387,7 @@ static void vk_update_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
         vk_buf_barrier(gpu, cmd, buf, passStages[pass->params.type],
                        access[desc->access], 0, buf->params.size, false);
 
-        wds->pTexelBufferView = &buf_vk->view;
+        data->texel = buf_vk->view;
         return;
     }
     case PL_DESC_INVALID:
@@ -798,11 +1424,6 @@ static void vk_release_descriptor(pl_gpu gpu, struct vk_cmd *cmd, pl_pass pass,
     pl_unreachable();
 }
 
-static void set_ds(struct pl_pass_vk *pass_vk, void *dsbit)
-{
-    pass_vk->dmask |= (uintptr_t) dsbit;
-}
-
 static bool need_respec(pl_pass pass, const struct pl_pass_run_params *params)
 {
     struct pl_pass_vk *pass_vk = PL_PRIV(pass);
@@ -827,6 +1448,96 @@ static bool need_respec(pl_pass pass, const struct pl_pass_run_params *params)
     return false;
 }
 
+// Returns whether the access described by `scope` was recorded into a
+// graphics command that has not been submitted to the device yet, either the
+// one currently being recorded (`cmd`) or one waiting in `vk->cmds_queued`.
+// Must be called with `p->recording` held.
+static bool graphics_pending(struct vk_ctx *vk, const struct vk_cmd *cmd,
+                             const struct vk_sem *sem,
+                             const struct vk_sync_scope *scope)
+{
+    if (!scope->queue)
+        return false;
+
+    if (cmd && cmd->pool == vk->pool_graphics && scope->queue == cmd->queue) {
+        for (int i = 0; i < cmd->sigs.num; i++) {
+            if (cmd->sigs.elem[i] == sem->semaphore &&
+                cmd->sigvalues.elem[i] == scope->value)
+                return true;
+        }
+    }
+
+    return vk_cmd_queued_sig(vk, vk->pool_graphics, sem->semaphore, scope->value);
+}
+
+// Picks the queue to run a compute pass on. Compute passes normally go to the
+// compute pool, which may be a separate (async) queue family, and any
+// dependencies on other queues are resolved by `vk_sem_barrier` using the
+// resources' timeline semaphores. A pass that depends on graphics commands
+// which were not even submitted yet can't run concurrently with them anyway,
+// and sending it to another queue would split the graphics work, costing an
+// extra submission plus a semaphore round trip in each direction. Such passes
+// are kept on the graphics queue instead. (Dependencies on commands that are
+// already executing only cost a wait on the GPU, so they don't count.)
+static enum queue_type compute_queue(pl_gpu gpu,
+                                     const struct pl_pass_run_params *params)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    pl_pass pass = params->pass;
+
+    if (vk->pool_compute == vk->pool_graphics ||
+        !(vk->pool_graphics->props.queueFlags & VK_QUEUE_COMPUTE_BIT))
+    {
+        return COMPUTE;
+    }
+
+    bool dependent = false;
+    pl_mutex_lock(&p->recording);
+    for (int i = 0; i < pass->params.num_descriptors && !dependent; i++) {
+        const struct pl_desc *desc = &pass->params.descriptors[i];
+        const struct vk_sem *sem = NULL;
+        bool writes = false;
+
+        switch (desc->type) {
+        case PL_DESC_STORAGE_IMG:
+            writes = desc->access != PL_DESC_ACCESS_READONLY;
+            // fall through
+        case PL_DESC_SAMPLED_TEX: {
+            pl_tex tex = params->desc_bindings[i].object;
+            struct pl_tex_vk *tex_vk = PL_PRIV(tex);
+            sem = &tex_vk->sem;
+            break;
+        }
+        case PL_DESC_BUF_STORAGE:
+        case PL_DESC_BUF_TEXEL_STORAGE:
+            writes = desc->access != PL_DESC_ACCESS_READONLY;
+            // fall through
+        case PL_DESC_BUF_UNIFORM:
+        case PL_DESC_BUF_TEXEL_UNIFORM: {
+            pl_buf buf = params->desc_bindings[i].object;
+            struct pl_buf_vk *buf_vk = PL_PRIV(buf);
+            sem = &buf_vk->sem;
+            break;
+        }
+        case PL_DESC_INVALID:
+        case PL_DESC_TYPE_COUNT:
+            pl_unreachable();
+        }
+
+        // Reads only depend on pending writes, writes also depend on
+        // pending reads
+        dependent = graphics_pending(vk, p->cmd, sem, &sem->write) ||
+                    (writes && graphics_pending(vk, p->cmd, sem, &sem->read));
+    }
+    pl_mutex_unlock(&p->recording);
+
+    if (dependent)
+        PL_TRACE(gpu, "Compute pass depends on unsubmitted rendering, keeping "
+                 "it on the graphics queue");
+    return dependent ? GRAPHICS : COMPUTE;
+}
+
 void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
 {
     struct pl_vk *p = PL_PRIV(gpu);
@@ -840,57 +1551,44 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
     // Check if we need to re-specialize this pipeline
     if (need_respec(pass, params)) {
         clock_t start = clock();
+        if (pass_vk->vert_lib)
+            link_cancel(gpu, pass, false);
         VK(vk_recreate_pipelines(vk, pass, false, pass_vk->base, &pass_vk->pipe));
         pl_log_cpu_time(gpu->log, start, clock(), "re-specializing shader");
+        if (pass_vk->vert_lib)
+            link_queue(gpu, pass);
+    } else if (pass_vk->vert_lib) {
+        link_swap(gpu, pass);
     }
 
-    if (!pass_vk->use_pushd) {
-        // Wait for a free descriptor set
-        while (!pass_vk->dmask) {
-            PL_TRACE(gpu, "No free descriptor sets! ...blocking (slow path)");
-            vk_poll_commands(vk, 10000000); // 10 ms
-        }
-    }
-
-    static const enum queue_type types[] = {
-        [PL_PASS_RASTER]  = GRAPHICS,
-        [PL_PASS_COMPUTE] = COMPUTE,
-    };
+    enum queue_type queue = GRAPHICS;
+    if (pass->params.type == PL_PASS_COMPUTE)
+        queue = compute_queue(gpu, params);
 
-    struct vk_cmd *cmd = CMD_BEGIN_TIMED(types[pass->params.type], params->timer);
+    struct vk_cmd *cmd = CMD_BEGIN_TIMED(queue, params->timer);
     if (!cmd)
         goto error;
 
-    // Find a descriptor set to use
+    // Allocate a descriptor set to use, if needed
     VkDescriptorSet ds = VK_NULL_HANDLE;
-    if (!pass_vk->use_pushd) {
-        for (int i = 0; i < PL_ARRAY_SIZE(pass_vk->dss); i++) {
-            uint16_t dsbit = 1u << i;
-            if (pass_vk->dmask & dsbit) {
-                ds = pass_vk->dss[i];
-                pass_vk->dmask &= ~dsbit; // unset
-                vk_cmd_callback(cmd, (vk_cb) set_ds, pass_vk,
-                                (void *)(uintptr_t) dsbit);
-                break;
-            }
+    if (pass->params.num_descriptors && !pass_vk->use_pushd) {
+        ds = dspool_alloc(gpu, cmd, pass);
+        if (!ds) {
+            CMD_FINISH(&cmd);
+            goto error;
         }
     }
 
-    // Update the dswrite structure with all of the new values
+    // Update the descriptor data with all of the new values
     for (int i = 0; i < pass->params.num_descriptors; i++)
-        vk_update_descriptor(gpu, cmd, pass, params->desc_bindings[i], ds, i);
+        vk_update_descriptor(gpu, cmd, pass, params->desc_bindings[i], i);
 
-    if (!pass_vk->use_pushd) {
-        vk->UpdateDescriptorSets(vk->dev, pass->params.num_descriptors,
-                                 pass_vk->dswrite, 0, NULL);
+    if (ds) {
+        vk->UpdateDescriptorSetWithTemplate(vk->dev, ds, pass_vk->dsTemplate,
+                                            pass_vk->dsdata);
     }
 
     // Bind the pipeline, descriptor set, etc.
-    static const VkPipelineBindPoint bindPoint[] = {
-        [PL_PASS_RASTER]  = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        [PL_PASS_COMPUTE] = VK_PIPELINE_BIND_POINT_COMPUTE,
-    };
-
     vk->CmdBindPipeline(cmd->buf, bindPoint[pass->params.type],
                         PL_DEF(pass_vk->pipe, pass_vk->base));
 
@@ -900,10 +1598,9 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
     }
 
     if (pass_vk->use_pushd) {
-        vk->CmdPushDescriptorSetKHR(cmd->buf, bindPoint[pass->params.type],
-                                    pass_vk->pipeLayout, 0,
-                                    pass->params.num_descriptors,
-                                    pass_vk->dswrite);
+        vk->CmdPushDescriptorSetWithTemplateKHR(cmd->buf, pass_vk->dsTemplate,
+                                                pass_vk->pipeLayout, 0,
+                                                pass_vk->dsdata);
     }
 
     if (pass->params.push_constants_size) {
@@ -978,6 +1675,7 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
             .renderArea.extent = {tex->params.w, tex->params.h},
         };
 
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdBeginRenderPass(cmd->buf, &binfo, VK_SUBPASS_CONTENTS_INLINE);
 
         if (index) {
@@ -993,6 +1691,7 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
         break;
     }
     case PL_PASS_COMPUTE:
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdDispatch(cmd->buf, params->compute_groups[0],
                         params->compute_groups[1],
                         params->compute_groups[2]);
@@ -17,6 +17,8 @@
 
 #include "gpu.h"
 
+static void vk_tex_move(pl_gpu gpu, struct vk_cmd *cmd, pl_tex tex);
+
 void vk_tex_barrier(pl_gpu gpu, struct vk_cmd *cmd, pl_tex tex,
                     VkPipelineStageFlags stage, VkAccessFlags access,
                     VkImageLayout layout, bool export)
@@ -24,6 +26,14 @@ void vk_tex_barrier(pl_gpu gpu, struct vk_cmd *cmd, pl_tex tex,
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
+
+    // Relocate idle images out of fragmented memory before their next use
+    if (tex_vk->movable && !export && pl_rc_count(&tex_vk->rc) == 1 &&
+        vk_malloc_should_move(vk->ma, &tex_vk->mem))
+    {
+        vk_tex_move(gpu, cmd, tex);
+    }
+
     pl_rc_ref(&tex_vk->rc);
     pl_assert(!tex_vk->held);
 
@@ -69,10 +79,8 @@ void vk_tex_barrier(pl_gpu gpu, struct vk_cmd *cmd, pl_tex tex,
     }
 
     bool is_xfer = barr.srcQueueFamilyIndex != barr.dstQueueFamilyIndex;
-    if (last.access || is_trans || is_xfer) {
-        vk->CmdPipelineBarrier(cmd->buf, last.stage, stage, 0, 0, NULL,
-                               0, NULL, 1, &barr);
-    }
+    if (last.access || is_trans || is_xfer)
+        vk_cmd_image_barrier(vk, cmd, last.stage, stage, &barr);
 
     tex_vk->layout = layout;
     vk_cmd_callback(cmd, (vk_cb) vk_tex_deref, gpu, tex);
@@ -110,32 +118,14 @@ void vk_tex_deref(pl_gpu gpu, pl_tex tex)
 }
 
 
-// Initializes non-VkImage values like the image view, framebuffers, etc.
-static bool vk_init_image(pl_gpu gpu, pl_tex tex, pl_debug_tag debug_tag)
+// Creates the image view and framebuffer (as needed) for `tex_vk->img`
+static bool vk_init_views(pl_gpu gpu, pl_tex tex, pl_debug_tag debug_tag)
 {
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
 
     const struct pl_tex_params *params = &tex->params;
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
-    pl_assert(tex_vk->img);
-    PL_VK_NAME(IMAGE, tex_vk->img, debug_tag);
-
-    pl_rc_init(&tex_vk->rc);
-    if (!vk_sem_init(vk, &tex_vk->sem, debug_tag))
-        return false;
-    tex_vk->layout = VK_IMAGE_LAYOUT_UNDEFINED;
-    tex_vk->transfer_queue = GRAPHICS;
-
-    // Always use the transfer pool if available, for efficiency
-    if ((params->host_writable || params->host_readable) && vk->pool_transfer)
-        tex_vk->transfer_queue = TRANSFER;
-
-    // For emulated formats: force usage of the compute queue, because we
-    // can't properly track cross-queue dependencies for buffers (yet?)
-    if (params->format->emulated)
-        tex_vk->transfer_queue = COMPUTE;
-
     bool ret = false;
     VkRenderPass dummyPass = VK_NULL_HANDLE;
 
@@ -222,7 +212,226 @@ error:
     return ret;
 }
 
-pl_tex vk_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
+// Initializes non-VkImage values like the image view, framebuffers, etc.
+static bool vk_init_image(pl_gpu gpu, pl_tex tex, pl_debug_tag debug_tag)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    const struct pl_tex_params *params = &tex->params;
+    struct pl_tex_vk *tex_vk = PL_PRIV(tex);
+    pl_assert(tex_vk->img);
+    PL_VK_NAME(IMAGE, tex_vk->img, debug_tag);
+
+    pl_rc_init(&tex_vk->rc);
+    if (!vk_sem_init(vk, &tex_vk->sem, debug_tag))
+        return false;
+    tex_vk->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    tex_vk->transfer_queue = GRAPHICS;
+
+    // Always use the transfer pool if available, for efficiency
+    if ((params->host_writable || params->host_readable) && vk->pool_transfer)
+        tex_vk->transfer_queue = TRANSFER;
+
+    // For emulated formats: force usage of the compute queue, because we
+    // can't properly track cross-queue dependencies for buffers (yet?)
+    if (params->format->emulated)
+        tex_vk->transfer_queue = COMPUTE;
+
+    return vk_init_views(gpu, tex, debug_tag);
+}
+
+// Vulkan objects left behind by `vk_tex_move`
+struct vk_tex_garbage {
+    VkImage img;
+    VkImageView view;
+    VkFramebuffer framebuffer;
+    struct vk_memslice mem;
+};
+
+static void vk_tex_garbage_cb(pl_gpu gpu, struct vk_tex_garbage *old)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+
+    vk->DestroyFramebuffer(vk->dev, old->framebuffer, PL_VK_ALLOC);
+    vk->DestroyImageView(vk->dev, old->view, PL_VK_ALLOC);
+    vk->DestroyImage(vk->dev, old->img, PL_VK_ALLOC);
+    vk_malloc_free(vk->ma, &old->mem);
+    pl_free(old);
+}
+
+// Moves an idle texture to a freshly allocated image, copying its contents
+// (if any) as part of `cmd`. The old image is released once `cmd` completes.
+// Since this replaces the underlying vulkan objects, it may only be used on
+// images which were never exposed to the user (`tex_vk->movable`).
+static void vk_tex_move(pl_gpu gpu, struct vk_cmd *cmd, pl_tex tex)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    struct pl_tex_vk *tex_vk = PL_PRIV(tex);
+    const struct pl_tex_params *params = &tex->params;
+    pl_assert(tex_vk->movable && !tex_vk->external_img);
+
+    uint32_t qfs[3] = {0};
+    for (int i = 0; i < vk->pools.num; i++)
+        qfs[i] = vk->pools.elem[i]->qf;
+
+    VkImageCreateInfo iinfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = tex_vk->type,
+        .format = tex_vk->img_fmt,
+        .extent = (VkExtent3D) {
+            .width  = params->w,
+            .height = PL_MAX(1, params->h),
+            .depth  = PL_MAX(1, params->d)
+        },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = tex_vk->usage_flags,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .sharingMode = vk->pools.num > 1 ? VK_SHARING_MODE_CONCURRENT
+                                         : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = vk->pools.num,
+        .pQueueFamilyIndices = qfs,
+    };
+
+    struct vk_tex_garbage *old = pl_alloc_ptr(NULL, old);
+    *old = (struct vk_tex_garbage) {
+        .img = tex_vk->img,
+        .view = tex_vk->view,
+        .framebuffer = tex_vk->framebuffer,
+        .mem = tex_vk->mem,
+    };
+
+    struct vk_tex_garbage next = {0};
+    VK(vk->CreateImage(vk->dev, &iinfo, PL_VK_ALLOC, &next.img));
+
+    VkMemoryDedicatedRequirements ded_reqs = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR,
+    };
+
+    VkMemoryRequirements2 reqs = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR,
+        .pNext = &ded_reqs,
+    };
+
+    VkImageMemoryRequirementsInfo2 req_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2_KHR,
+        .image = next.img,
+    };
+
+    vk->GetImageMemoryRequirements2(vk->dev, &req_info, &reqs);
+    struct vk_malloc_params mparams = {
+        .reqs = reqs.memoryRequirements,
+        .optimal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+    };
+
+    if (ded_reqs.prefersDedicatedAllocation)
+        mparams.ded_image = next.img;
+
+    if (!vk_malloc_slice(vk->ma, &next.mem, &mparams))
+        goto error;
+    VK(vk->BindImageMemory(vk->dev, next.img, next.mem.vkmem, next.mem.offset));
+
+    // Create the new views in place, then temporarily restore the old ones
+    tex_vk->img = next.img;
+    tex_vk->view = VK_NULL_HANDLE;
+    tex_vk->framebuffer = VK_NULL_HANDLE;
+    pl_debug_tag debug_tag = PL_DEF(params->debug_tag, "moved");
+    PL_VK_NAME(IMAGE, next.img, debug_tag);
+    bool ok = vk_init_views(gpu, tex, debug_tag);
+    next.view = tex_vk->view;
+    next.framebuffer = tex_vk->framebuffer;
+    tex_vk->img = old->img;
+    tex_vk->view = old->view;
+    tex_vk->framebuffer = old->framebuffer;
+    if (!ok)
+        goto error;
+
+    PL_TRACE(gpu, "Moving texture %dx%dx%d (%zu bytes) out of fragmented memory",
+             params->w, params->h, params->d, (size_t) old->mem.size);
+
+    bool copy = tex_vk->layout != VK_IMAGE_LAYOUT_UNDEFINED &&
+                !tex_vk->may_invalidate;
+
+    if (copy) {
+        // Avoid recursing into `vk_tex_move` from `vk_tex_barrier`
+        tex_vk->movable = false;
+        vk_tex_barrier(gpu, cmd, tex, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_ACCESS_TRANSFER_READ_BIT,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false);
+    }
+
+    tex_vk->img = next.img;
+    tex_vk->view = next.view;
+    tex_vk->framebuffer = next.framebuffer;
+    tex_vk->mem = next.mem;
+    tex_vk->movable = next.mem.block != NULL;
+    tex_vk->may_invalidate = false;
+
+    if (copy) {
+        // Subsequent accesses need to synchronize against the copy, rather
+        // than the read from the old image
+        vk_sem_barrier(vk, cmd, &tex_vk->sem, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_ACCESS_TRANSFER_WRITE_BIT, true);
+
+        uint32_t qf = vk->pools.num > 1 ? VK_QUEUE_FAMILY_IGNORED : cmd->pool->qf;
+        VkImageMemoryBarrier barr = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = qf,
+            .dstQueueFamilyIndex = qf,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .image = next.img,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .levelCount = 1,
+                .layerCount = 1,
+            },
+        };
+
+        vk_cmd_image_barrier(vk, cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, &barr);
+
+        static const VkImageSubresourceLayers layers = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .layerCount = 1,
+        };
+
+        VkImageCopy region = {
+            .srcSubresource = layers,
+            .dstSubresource = layers,
+            .extent = iinfo.extent,
+        };
+
+        vk_cmd_flush_barriers(vk, cmd);
+        vk->CmdCopyImage(cmd->buf, old->img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         next.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1, &region);
+        tex_vk->layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    } else {
+        tex_vk->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    vk_malloc_moved(vk->ma, &old->mem);
+    vk_cmd_callback(cmd, (vk_cb) vk_tex_garbage_cb, gpu, old);
+    return;
+
+error:
+    PL_WARN(gpu, "Failed moving texture, leaving it in place");
+    vk->DestroyFramebuffer(vk->dev, next.framebuffer, PL_VK_ALLOC);
+    vk->DestroyImageView(vk->dev, next.view, PL_VK_ALLOC);
+    vk->DestroyImage(vk->dev, next.img, PL_VK_ALLOC);
+    vk_malloc_free(vk->ma, &next.mem);
+    pl_free(old);
+}
+
+static pl_tex tex_create(pl_gpu gpu, const struct pl_tex_params *params,
+                         bool internal)
 {
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
@@ -292,6 +501,14 @@ pl_tex vk_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
     if (tex->params.host_writable || tex->params.blit_dst || params->initial_data)
         usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
+    // Internal images which are never shared with the outside world can have
+    // their memory relocated transparently (see `vk_tex_move`), using copies
+    bool movable = internal && !handle_type && !params->format->emulated &&
+                   !fmtp->blit_emulated &&
+                   (params->format->caps & PL_FMT_CAP_BLITTABLE);
+    if (movable)
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
     if (!usage) {
         // Vulkan requires images have at least *some* image usage set, but our
         // API is perfectly happy with a (useless) image. So just put
@@ -471,6 +688,9 @@ pl_tex vk_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
     if (!vk_init_image(gpu, tex, debug_tag))
         goto error;
 
+    // Dedicated allocations never need to be moved
+    tex_vk->movable = movable && mem->block;
+
     if (params->export_handle)
         tex->shared_mem = tex_vk->mem.shared_mem;
 
@@ -532,6 +752,16 @@ error:
     return NULL;
 }
 
+pl_tex vk_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
+{
+    return tex_create(gpu, params, false);
+}
+
+pl_tex vk_tex_create_internal(pl_gpu gpu, const struct pl_tex_params *params)
+{
+    return tex_create(gpu, params, true);
+}
+
 void vk_tex_invalidate(pl_gpu gpu, pl_tex tex)
 {
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
@@ -562,6 +792,7 @@ void vk_tex_clear_ex(pl_gpu gpu, pl_tex tex, const union pl_clear_color color)
         .layerCount = 1,
     };
 
+    vk_cmd_flush_barriers(vk, cmd);
     vk->CmdClearColorImage(cmd->buf, tex_vk->img, tex_vk->layout,
                            clearColor, 1, &range);
 
@@ -600,6 +831,8 @@ void vk_tex_blit(pl_gpu gpu, const struct pl_tex_blit_params *params)
                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                    false);
 
+    vk_cmd_flush_barriers(vk, cmd);
+
     static const VkImageSubresourceLayers layers = {
         .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
         .layerCount = 1,
@@ -704,6 +937,69 @@ static void tex_xfer_cb(void *ctx, void *arg)
     fun(arg);
 }
 
+// Minimum size of synchronous uploads for which the user's memory is imported
+// directly, rather than copied into staging memory first
+#define IMPORT_MIN_SIZE (1 << 20) // 1 MiB
+
+static void import_done_cb(void *priv)
+{
+    atomic_bool *done = priv;
+    atomic_store(done, true);
+}
+
+// Upload directly from the user's memory, by importing it as a transfer
+// source via VK_EXT_external_memory_host. Only done for synchronous uploads
+// from large, suitably aligned pointers, since asynchronous uploads are
+// already imported by `pl_tex_upload_pbo`. Returns false if the import was not
+// possible, in which case the caller should fall back to staging the data.
+static bool tex_upload_import(pl_gpu gpu, const struct pl_tex_transfer_params *params,
+                              bool *ok)
+{
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
+    size_t size = pl_tex_transfer_size(params);
+    size_t align = gpu->limits.align_host_ptr;
+    if (params->callback || !(gpu->import_caps.buf & PL_HANDLE_HOST_PTR) || !align)
+        return false;
+    if (size < IMPORT_MIN_SIZE || (uintptr_t) params->ptr % align)
+        return false;
+
+    // Rounding up the size only extends the import into the last page
+    // already containing the user's data, which is guaranteed to be mapped
+    pl_log_level_cap(gpu->log, PL_LOG_DEBUG);
+    pl_buf buf = pl_buf_create(gpu, pl_buf_params(
+        .size = size,
+        .import_handle = PL_HANDLE_HOST_PTR,
+        .shared_mem = {
+            .handle.ptr = params->ptr,
+            .size = PL_ALIGN2(size, align),
+        },
+        .debug_tag = PL_DEBUG_TAG,
+    ));
+    pl_log_level_cap(gpu->log, PL_LOG_NONE);
+    if (!buf)
+        return false;
+
+    atomic_bool done;
+    atomic_init(&done, false);
+    struct pl_tex_transfer_params fixed = *params;
+    fixed.buf = buf;
+    fixed.ptr = NULL;
+    fixed.callback = import_done_cb;
+    fixed.priv = &done;
+    *ok = vk_tex_upload(gpu, &fixed);
+
+    // The caller may reuse or free its memory as soon as this returns, so
+    // block until the transfer has actually completed. This only waits for
+    // the commands submitted so far, rather than for the device to go idle.
+    CMD_SUBMIT(NULL);
+    while (!atomic_load(&done) && vk_poll_commands(vk, UINT64_MAX))
+        ; // do nothing
+
+    pl_buf_destroy(gpu, &buf);
+    return true;
+}
+
 bool vk_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params)
 {
     struct pl_vk *p = PL_PRIV(gpu);
@@ -712,8 +1008,12 @@ bool vk_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params)
     pl_fmt fmt = tex->params.format;
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
 
-    if (!params->buf)
+    if (!params->buf) {
+        bool ok;
+        if (tex_upload_import(gpu, params, &ok))
+            return ok;
         return pl_tex_upload_pbo(gpu, params);
+    }
 
     pl_buf buf = params->buf;
     struct pl_buf_vk *buf_vk = PL_PRIV(buf);
@@ -771,6 +1071,7 @@ bool vk_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params)
                        false);
         vk_buf_barrier(gpu, cmd, tbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
                        VK_ACCESS_TRANSFER_WRITE_BIT, 0, size, false);
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdCopyBuffer(cmd->buf, buf_vk->mem.buf, tbuf_vk->mem.buf,
                           1, &region);
 
@@ -815,6 +1116,7 @@ bool vk_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params)
         vk_tex_barrier(gpu, cmd, tex, VK_PIPELINE_STAGE_TRANSFER_BIT,
                        VK_ACCESS_TRANSFER_WRITE_BIT,
                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false);
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdCopyBufferToImage(cmd->buf, buf_vk->mem.buf, tex_vk->img,
                                  tex_vk->layout, 1, &region);
 
@@ -895,6 +1197,7 @@ bool vk_tex_download(pl_gpu gpu, const struct pl_tex_transfer_params *params)
         vk_buf_barrier(gpu, cmd, buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
                        VK_ACCESS_TRANSFER_WRITE_BIT, params->buf_offset, size,
                        false);
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdCopyBuffer(cmd->buf, tbuf_vk->mem.buf, buf_vk->mem.buf,
                           1, &region);
         vk_buf_flush(gpu, cmd, buf, params->buf_offset, size);
@@ -933,6 +1236,7 @@ bool vk_tex_download(pl_gpu gpu, const struct pl_tex_transfer_params *params)
         vk_tex_barrier(gpu, cmd, tex, VK_PIPELINE_STAGE_TRANSFER_BIT,
                        VK_ACCESS_TRANSFER_READ_BIT,
                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false);
+        vk_cmd_flush_barriers(vk, cmd);
         vk->CmdCopyImageToBuffer(cmd->buf, tex_vk->img, tex_vk->layout,
                                  buf_vk->mem.buf, 1, &region);
         vk_buf_flush(gpu, cmd, buf, params->buf_offset, size);
@@ -971,6 +1275,8 @@ bool vk_tex_poll(pl_gpu gpu, pl_tex tex, uint64_t timeout)
 
 bool vk_tex_export(pl_gpu gpu, pl_tex tex, pl_sync sync)
 {
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
     struct pl_sync_vk *sync_vk = PL_PRIV(sync);
 
@@ -978,6 +1284,7 @@ bool vk_tex_export(pl_gpu gpu, pl_tex tex, pl_sync sync)
     if (!cmd)
         goto error;
 
+    tex_vk->movable = false;
     vk_tex_barrier(gpu, cmd, tex, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                    0, VK_IMAGE_LAYOUT_GENERAL, true);
 
@@ -985,7 +1292,7 @@ bool vk_tex_export(pl_gpu gpu, pl_tex tex, pl_sync sync)
     tex_vk->sem.write.queue = tex_vk->sem.read.queue = NULL;
 
     vk_cmd_sig(cmd, (pl_vulkan_sem){ sync_vk->wait });
-    if (!CMD_SUBMIT(&cmd))
+    if (!CMD_SUBMIT(&cmd) || !vk_flush_commands(vk))
         goto error;
 
     // Remember the other dependency and hold on to the sync object
@@ -1079,6 +1386,7 @@ VkImage pl_vulkan_unwrap(pl_gpu gpu, pl_tex tex, VkFormat *out_format,
                          VkImageUsageFlags *out_flags)
 {
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
+    tex_vk->movable = false; // the user may hold on to the VkImage
 
     if (out_format)
         *out_format = tex_vk->img_fmt;
@@ -1091,6 +1399,8 @@ VkImage pl_vulkan_unwrap(pl_gpu gpu, pl_tex tex, VkFormat *out_format,
 bool pl_vulkan_hold(pl_gpu gpu, pl_tex tex, VkImageLayout layout,
                     pl_vulkan_sem sem_out)
 {
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
     struct pl_tex_vk *tex_vk = PL_PRIV(tex);
     pl_assert(sem_out.sem);
 
@@ -1105,13 +1415,15 @@ bool pl_vulkan_hold(pl_gpu gpu, pl_tex tex, VkImageLayout layout,
         return false;
     }
 
+    tex_vk->movable = false;
+
     vk_tex_barrier(gpu, cmd, tex, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
                    0, layout, false);
 
     vk_cmd_sig(cmd, sem_out);
 
     tex_vk->sem.write.queue = tex_vk->sem.read.queue = NULL;
-    tex_vk->held = CMD_SUBMIT(&cmd);
+    tex_vk->held = CMD_SUBMIT(&cmd) && vk_flush_commands(vk);
     return tex_vk->held;
 }
 
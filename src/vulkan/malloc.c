@@ -19,6 +19,9 @@
 #include "command.h"
 #include "utils.h"
 #include "pl_thread.h"
+#include "../gpu.h"
+
+#include <string.h>
 
 #ifdef PL_HAVE_UNIX
 #include <errno.h>
@@ -26,37 +29,76 @@
 #include <unistd.h>
 #endif
 
-// Controls the page size alignment, to help coalesce allocations into the same
-// slab. Pages are rounded up to multiples of this value. (Default: 4 KB)
-#define PAGE_SIZE_ALIGN (1LLU << 12)
-
-// Controls the minimum/maximum number of pages for new slabs. As slabs are
-// exhausted of memory, the number of pages per new slab grows exponentially,
-// starting with the minimum until the maximum is reached.
-//
-// Note: The maximum must never exceed the size of `vk_slab.spacemap`.
-#define MINIMUM_PAGE_COUNT 4
-#define MAXIMUM_PAGE_COUNT (sizeof(uint64_t) * 8)
+// Controls the granularity of sub-allocations. Block offsets and sizes are
+// rounded up to multiples of this value. (Default: 256 bytes)
+#define BLOCK_SIZE_ALIGN (1LLU << 8)
 
-// Controls the maximum page size. Any allocations above this threshold
-// will be served by dedicated allocations. (Default: 64 MB)
-#define MAXIMUM_PAGE_SIZE (1LLU << 26)
+// Controls the maximum sub-allocation size. Any allocations above this
+// threshold will be served by dedicated allocations. (Default: 64 MB)
+#define MAXIMUM_BLOCK_SIZE (1LLU << 26)
 
 // Controls the minimum slab size, to avoid excessive re-allocation of very
 // small slabs. (Default: 256 KB)
 #define MINIMUM_SLAB_SIZE (1LLU << 18)
 
 // Controls the maximum slab size, to avoid ballooning memory requirements
-// due to overzealous allocation of extra pages. (Default: 256 MB)
+// due to overzealous allocation of extra space. (Default: 256 MB)
 #define MAXIMUM_SLAB_SIZE (1LLU << 28)
 
+// New slabs are sized to fit at least this many copies of the allocation
+// that triggered them, and otherwise grow along with the total pool size.
+#define MINIMUM_SLAB_BLOCKS 4
+
 // How long to wait before garbage collecting empty slabs. Slabs older than
 // this many invocations of `vk_malloc_garbage_collect` will be released.
 #define MAXIMUM_SLAB_AGE 8
 
+// How long to keep releasing empty slabs immediately after memory pressure,
+// to give cached resources (see `pl_gpu_evict`) a chance to be released.
+#define MAXIMUM_PRESSURE_AGE 4
+
+// Pooled slabs using at most 1/DEFRAG_THRESHOLD of their size are considered
+// fragmented, and may be picked for evacuation: new allocations avoid them,
+// and movable objects (see `vk_malloc_should_move`) are relocated out of them
+// until they become empty and can be released.
+#define DEFRAG_THRESHOLD 4
+
+// How long to keep trying to evacuate a slab before giving up, e.g. because
+// it's pinned by non-movable allocations. The same slab won't be picked
+// again for at least this many invocations of `vk_malloc_garbage_collect`.
+#define MAXIMUM_EVACUATION_AGE 64
+
+// Maximum number of bytes relocated per invocation of
+// `vk_malloc_garbage_collect` (i.e. per frame), to bound the GPU time spent
+// on defragmentation copies. (Default: 64 MB)
+#define DEFRAG_BUDGET (1LLU << 26)
+
+// Free space inside a slab is managed by a two-level segregated fit (TLSF)
+// allocator. Free blocks are sorted into lists by size: the first level
+// splits by power of two, and the second level splits each power of two
+// into 2^TLSF_SL_BITS linearly spaced lists. Together with a bitmap for each
+// level, this gives O(1) allocation and freeing with bounded fragmentation.
+#define TLSF_SL_BITS  4
+#define TLSF_SL_COUNT (1 << TLSF_SL_BITS)
+#define TLSF_FL_COUNT 32
+
+pl_static_assert(MAXIMUM_SLAB_SIZE < (1LLU << (TLSF_FL_COUNT - 1)));
+pl_static_assert(BLOCK_SIZE_ALIGN >= TLSF_SL_COUNT);
+
+// A contiguous region of a slab, which is either free or allocated. Blocks
+// are linked to their physical neighbours, so that adjacent free blocks can
+// be coalesced, and free blocks are additionally linked into a free list.
+struct vk_block {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    struct vk_block *prev, *next;           // physical neighbours
+    struct vk_block *prev_free, *next_free; // free list (only if `free`)
+    bool free;
+};
+
 // A single slab represents a contiguous region of allocated memory. Actual
-// allocations are served as pages of this. Slabs are organized into pools,
-// each of which contains a list of slabs of differing page sizes.
+// allocations are served as blocks of this. Slabs are organized into pools,
+// each of which contains a list of slabs.
 struct vk_slab {
     pl_mutex lock;
     VkDeviceMemory mem;     // underlying device allocation
@@ -66,10 +108,16 @@ struct vk_slab {
     bool imported;          // slab represents an imported memory allocation
 
     // free space accounting (only for non-dedicated slabs)
-    uint64_t spacemap;      // bitset of available pages
-    size_t pagesize;        // size in bytes per page
+    struct vk_block *free_lists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    uint32_t sl_bitmap[TLSF_FL_COUNT]; // bitsets of non-empty `free_lists`
+    uint32_t fl_bitmap;     // bitset of non-empty `sl_bitmap`
+    struct vk_block *spare; // unused vk_block structs, for re-use
+    int num_blocks;         // number of allocated blocks
+    size_t avail;           // number of bytes in free blocks
     size_t used;            // number of bytes actually in use
     uint64_t age;           // timestamp of last use
+    bool evacuate;          // slab is being defragmented, don't allocate
+    uint64_t evacuate_age;  // timestamp of last evacuation attempt
 
     // optional, depends on the memory type:
     VkBuffer buffer;        // buffer spanning the entire slab
@@ -84,22 +132,38 @@ struct vk_slab {
 // practice, because some combinations simply never occur, and others will
 // generally be the same for the same objects.
 //
-// Note: `vk_pool` addresses are not immutable, so we mustn't expose any
-// dangling references to a `vk_pool` from e.g. `vk_memslice.priv = vk_slab`.
+// Pools are allocated individually and live until `vk_malloc_destroy`, so
+// their addresses are stable. Each pool has its own lock, which guards the
+// list of slabs, so that allocations from different pools (e.g. textures and
+// staging buffers in use by different threads) don't contend with each other.
 struct vk_pool {
+    pl_mutex lock;
     struct vk_malloc_params params;   // allocation params (with some fields nulled)
     PL_ARRAY(struct vk_slab *) slabs; // array of slabs, unsorted
     int index;                        // running index in `vk_malloc.pools`
 };
 
 // The overall state of the allocator, which keeps track of a vk_pool for each
-// memory type.
+// memory type. `lock` only protects the list of pools itself, and is never
+// held while allocating or searching for memory.
 struct vk_malloc {
     struct vk_ctx *vk;
     pl_mutex lock;
     VkPhysicalDeviceMemoryProperties props;
-    PL_ARRAY(struct vk_pool) pools;
+    PL_ARRAY(struct vk_pool *) pools;
     uint64_t age;
+
+    // Per-heap memory accounting, excluding imported memory
+    _Atomic VkDeviceSize allocated[VK_MAX_MEMORY_HEAPS];
+    bool has_budget;       // VK_EXT_memory_budget is enabled
+    uint64_t evictions;    // number of times caches were signalled
+    uint64_t pressure_age; // value of `age` at the last eviction
+
+    // Defragmentation state
+    _Atomic int evacuating;         // number of slabs with `evacuate` set
+    _Atomic size_t defrag_budget;   // remaining bytes to relocate this frame
+    _Atomic uint64_t defrag_moves;  // number of `vk_malloc_moved` calls
+    _Atomic uint64_t defrag_bytes;  // total size of the moved slices
 };
 
 static inline float efficiency(size_t used, size_t total)
@@ -126,6 +190,41 @@ static const char *print_size(char buf[8], size_t size)
 
 #define PRINT_SIZE(x) (print_size((char[8]){0}, (size_t) (x)))
 
+// Returns the maximum amount of memory vk_malloc should allocate from a heap
+static VkDeviceSize heap_budget(struct vk_malloc *ma, uint32_t heap_idx)
+{
+    struct vk_ctx *vk = ma->vk;
+    const VkMemoryHeap *heap = &ma->props.memoryHeaps[heap_idx];
+    VkDeviceSize budget = heap->size;
+
+    if (ma->has_budget) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+        };
+
+        VkPhysicalDeviceMemoryProperties2 props = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+            .pNext = &budget_props,
+        };
+
+        vk->GetPhysicalDeviceMemoryProperties2(vk->physd, &props);
+
+        // `heapUsage` also counts memory allocated outside of vk_malloc (e.g.
+        // swapchain images, or other APIs sharing this device), which is not
+        // available to us
+        VkDeviceSize usage = budget_props.heapUsage[heap_idx];
+        VkDeviceSize ours = atomic_load(&ma->allocated[heap_idx]);
+        VkDeviceSize other = usage - PL_MIN(usage, ours);
+        budget = budget_props.heapBudget[heap_idx];
+        budget -= PL_MIN(budget, other);
+    }
+
+    if (vk->memory_budget && (heap->flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        budget = PL_MIN(budget, vk->memory_budget);
+
+    return budget;
+}
+
 void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
 {
     struct vk_ctx *vk = ma->vk;
@@ -136,8 +235,10 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
     PL_MSG(vk, lev, "Memory heaps supported by device:");
     for (int i = 0; i < ma->props.memoryHeapCount; i++) {
         VkMemoryHeap heap = ma->props.memoryHeaps[i];
-        PL_MSG(vk, lev, "    %d: flags 0x%x size %s",
-                i, (unsigned) heap.flags, PRINT_SIZE(heap.size));
+        PL_MSG(vk, lev, "    %d: flags 0x%x size %s budget %s alloc %s",
+                i, (unsigned) heap.flags, PRINT_SIZE(heap.size),
+                PRINT_SIZE(heap_budget(ma, i)),
+                PRINT_SIZE(atomic_load(&ma->allocated[i])));
     }
 
     PL_DEBUG(vk, "Memory types supported by device:");
@@ -149,8 +250,9 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
 
     pl_mutex_lock(&ma->lock);
     for (int i = 0; i < ma->pools.num; i++) {
-        struct vk_pool *pool = &ma->pools.elem[i];
+        struct vk_pool *pool = ma->pools.elem[i];
         const struct vk_malloc_params *par = &pool->params;
+        pl_mutex_lock(&pool->lock);
 
         PL_MSG(vk, lev, "Memory pool %d:", i);
         PL_MSG(vk, lev, "    Compatible types: 0x%"PRIx32, par->reqs.memoryTypeBits);
@@ -171,12 +273,11 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
             struct vk_slab *slab = pool->slabs.elem[j];
             pl_mutex_lock(&slab->lock);
 
-            size_t avail = __builtin_popcountll(slab->spacemap) * slab->pagesize;
-            size_t slab_res = slab->size - avail;
+            size_t slab_res = slab->size - slab->avail;
 
-            PL_MSG(vk, lev, "    Slab %2d: %8"PRIx64" x %s: "
+            PL_MSG(vk, lev, "    Slab %2d: %4d blocks: "
                    "%s used %s res %s alloc from heap %d, efficiency %.2f%%",
-                   j, slab->spacemap, PRINT_SIZE(slab->pagesize),
+                   j, slab->num_blocks,
                    PRINT_SIZE(slab->used), PRINT_SIZE(slab_res),
                    PRINT_SIZE(slab->size), (int) slab->mtype.heapIndex,
                    efficiency(slab->used, slab_res));
@@ -196,6 +297,7 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
         total_size += pool_size;
         total_used += pool_used;
         total_res += pool_res;
+        pl_mutex_unlock(&pool->lock);
     }
     pl_mutex_unlock(&ma->lock);
 
@@ -206,8 +308,9 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
            efficiency(total_res, total_size));
 }
 
-static void slab_free(struct vk_ctx *vk, struct vk_slab *slab)
+static void slab_free(struct vk_malloc *ma, struct vk_slab *slab)
 {
+    struct vk_ctx *vk = ma->vk;
     if (!slab)
         return;
 
@@ -268,6 +371,8 @@ static void slab_free(struct vk_ctx *vk, struct vk_slab *slab)
     vk->DestroyBuffer(vk->dev, slab->buffer, PL_VK_ALLOC);
     // also implicitly unmaps the memory if needed
     vk->FreeMemory(vk->dev, slab->mem, PL_VK_ALLOC);
+    if (slab->mem && !slab->imported)
+        atomic_fetch_sub(&ma->allocated[slab->mtype.heapIndex], slab->size);
 
     pl_mutex_destroy(&slab->lock);
     pl_free(slab);
@@ -344,6 +449,9 @@ static bool buf_external_check(struct vk_ctx *vk, VkBufferUsageFlags usage,
                                  handle_type, import);
 }
 
+static bool vk_malloc_evict(struct vk_malloc *ma, uint32_t heap_idx,
+                            VkDeviceSize size, VkDeviceSize budget);
+
 // thread-safety: safe
 static struct vk_slab *slab_alloc(struct vk_malloc *ma,
                                   const struct vk_malloc_params *params)
@@ -442,7 +550,26 @@ static struct vk_slab *slab_alloc(struct vk_malloc *ma,
              (size_t) slab->size, (unsigned) mtype->propertyFlags,
              (int) minfo.memoryTypeIndex, (int) mtype->heapIndex);
 
+    // Try to make room before exceeding the heap's budget
+    VkDeviceSize heap_used = atomic_load(&ma->allocated[mtype->heapIndex]);
+    VkDeviceSize budget = heap_budget(ma, mtype->heapIndex);
+    if (heap_used + slab->size > budget) {
+        PL_DEBUG(vk, "Allocation would exceed budget of heap %d (%s of %s "
+                 "used), evicting cached resources", (int) mtype->heapIndex,
+                 PRINT_SIZE(heap_used), PRINT_SIZE(budget));
+        vk_malloc_evict(ma, mtype->heapIndex, slab->size, budget);
+    }
+
     VkResult res = vk->AllocateMemory(vk->dev, &minfo, PL_VK_ALLOC, &slab->mem);
+    if (res == VK_ERROR_OUT_OF_DEVICE_MEMORY &&
+        vk_malloc_evict(ma, mtype->heapIndex, slab->size, UINT64_MAX))
+    {
+        // Only retry if some memory was actually released
+        PL_DEBUG(vk, "Allocation of size %s failed, retrying after evicting "
+                 "cached resources", PRINT_SIZE(slab->size));
+        res = vk->AllocateMemory(vk->dev, &minfo, PL_VK_ALLOC, &slab->mem);
+    }
+
     switch (res) {
     case VK_ERROR_OUT_OF_DEVICE_MEMORY:
     case VK_ERROR_OUT_OF_HOST_MEMORY:
@@ -457,6 +584,7 @@ static struct vk_slab *slab_alloc(struct vk_malloc *ma,
     }
 
     slab->mtype = *mtype;
+    atomic_fetch_add(&ma->allocated[mtype->heapIndex], slab->size);
     if (mtype->propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
         VK(vk->MapMemory(vk->dev, slab->mem, 0, VK_WHOLE_SIZE, 0, &slab->data));
         slab->coherent = mtype->propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -498,17 +626,206 @@ static struct vk_slab *slab_alloc(struct vk_malloc *ma,
     return slab;
 
 error:
-    slab_free(vk, slab);
+    slab_free(ma, slab);
     return NULL;
 }
 
-static void pool_uninit(struct vk_ctx *vk, struct vk_pool *pool)
+static inline int tlsf_log2(VkDeviceSize x)
+{
+    return 63 - __builtin_clzll(x);
+}
+
+// Maps a block size to the free list containing blocks of that size
+static inline void tlsf_mapping(VkDeviceSize size, int *fl, int *sl)
+{
+    *fl = tlsf_log2(size);
+    *sl = (int) (size >> (*fl - TLSF_SL_BITS)) ^ TLSF_SL_COUNT;
+}
+
+static void tlsf_insert(struct vk_slab *slab, struct vk_block *block)
+{
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+
+    struct vk_block *head = slab->free_lists[fl][sl];
+    block->free = true;
+    block->prev_free = NULL;
+    block->next_free = head;
+    if (head)
+        head->prev_free = block;
+
+    slab->free_lists[fl][sl] = block;
+    slab->fl_bitmap |= 1U << fl;
+    slab->sl_bitmap[fl] |= 1U << sl;
+    slab->avail += block->size;
+}
+
+static void tlsf_remove(struct vk_slab *slab, struct vk_block *block)
+{
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+    pl_assert(block->free);
+
+    if (block->next_free)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        slab->free_lists[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            slab->sl_bitmap[fl] &= ~(1U << sl);
+            if (!slab->sl_bitmap[fl])
+                slab->fl_bitmap &= ~(1U << fl);
+        }
+    }
+
+    block->free = false;
+    block->prev_free = block->next_free = NULL;
+    slab->avail -= block->size;
+}
+
+// Returns a free block of at least `size` bytes, or NULL
+static struct vk_block *tlsf_find(const struct vk_slab *slab, VkDeviceSize size)
+{
+    int fl, sl;
+    tlsf_mapping(size, &fl, &sl);
+
+    // Every block in the list after the one `size` maps to is large enough,
+    // so searching from there guarantees a fit without walking any lists
+    int fl_fit, sl_fit;
+    tlsf_mapping(size + (1LLU << (fl - TLSF_SL_BITS)) - 1, &fl_fit, &sl_fit);
+    if (fl_fit < TLSF_FL_COUNT) {
+        uint32_t sl_map = slab->sl_bitmap[fl_fit] & (~0U << sl_fit);
+        if (!sl_map && fl_fit + 1 < TLSF_FL_COUNT) {
+            uint32_t fl_map = slab->fl_bitmap & (~0U << (fl_fit + 1));
+            if (fl_map) {
+                fl_fit = __builtin_ctz(fl_map);
+                sl_map = slab->sl_bitmap[fl_fit];
+            }
+        }
+
+        if (sl_map)
+            return slab->free_lists[fl_fit][__builtin_ctz(sl_map)];
+    }
+
+    // Otherwise, the head of the list `size` maps to may still fit. This
+    // mainly matters for freshly allocated slabs, which are sized to fit
+    struct vk_block *block = slab->free_lists[fl][sl];
+    return block && block->size >= size ? block : NULL;
+}
+
+static struct vk_block *block_new(struct vk_slab *slab)
+{
+    struct vk_block *block = slab->spare;
+    if (block) {
+        slab->spare = block->next_free;
+    } else {
+        block = pl_alloc_ptr(slab, block);
+    }
+
+    *block = (struct vk_block) {0};
+    return block;
+}
+
+static void block_recycle(struct vk_slab *slab, struct vk_block *block)
+{
+    block->next_free = slab->spare;
+    slab->spare = block;
+}
+
+// Initializes the free space accounting for a newly allocated slab
+static void slab_init_blocks(struct vk_slab *slab)
+{
+    struct vk_block *block = block_new(slab);
+    block->size = slab->size & ~(BLOCK_SIZE_ALIGN - 1);
+    tlsf_insert(slab, block);
+}
+
+// Allocates a block of `size` bytes at an offset aligned to `align`, both of
+// which must be multiples of BLOCK_SIZE_ALIGN. Returns NULL if there is no
+// sufficiently large free block in this slab.
+static struct vk_block *slab_get_block(struct vk_slab *slab, VkDeviceSize size,
+                                       VkDeviceSize align)
+{
+    // Reserve enough space for the worst-case alignment padding
+    struct vk_block *block = tlsf_find(slab, size + align - BLOCK_SIZE_ALIGN);
+    if (!block)
+        return NULL;
+
+    tlsf_remove(slab, block);
+
+    VkDeviceSize pad = PL_ALIGN(block->offset, align) - block->offset;
+    if (pad) {
+        // Return the padding to the free lists. Since `block` was free, its
+        // predecessor can't be, so there's nothing to coalesce with here.
+        struct vk_block *head = block_new(slab);
+        head->offset = block->offset;
+        head->size = pad;
+        head->prev = block->prev;
+        head->next = block;
+        if (block->prev)
+            block->prev->next = head;
+        block->prev = head;
+        block->offset += pad;
+        block->size -= pad;
+        tlsf_insert(slab, head);
+    }
+
+    if (block->size > size) {
+        // Split off the remainder as a new free block
+        struct vk_block *tail = block_new(slab);
+        tail->offset = block->offset + size;
+        tail->size = block->size - size;
+        tail->prev = block;
+        tail->next = block->next;
+        if (block->next)
+            block->next->prev = tail;
+        block->next = tail;
+        block->size = size;
+        tlsf_insert(slab, tail);
+    }
+
+    slab->num_blocks++;
+    return block;
+}
+
+// Releases a block back to the slab, merging it with any free neighbours
+static void slab_put_block(struct vk_slab *slab, struct vk_block *block)
+{
+    pl_assert(!block->free);
+    struct vk_block *prev = block->prev, *next = block->next;
+
+    if (prev && prev->free) {
+        tlsf_remove(slab, prev);
+        prev->size += block->size;
+        prev->next = next;
+        if (next)
+            next->prev = prev;
+        block_recycle(slab, block);
+        block = prev;
+    }
+
+    if (next && next->free) {
+        tlsf_remove(slab, next);
+        block->size += next->size;
+        block->next = next->next;
+        if (next->next)
+            next->next->prev = block;
+        block_recycle(slab, next);
+    }
+
+    tlsf_insert(slab, block);
+    slab->num_blocks--;
+}
+
+static void pool_uninit(struct vk_malloc *ma, struct vk_pool *pool)
 {
     for (int i = 0; i < pool->slabs.num; i++)
-        slab_free(vk, pool->slabs.elem[i]);
+        slab_free(ma, pool->slabs.elem[i]);
 
     pl_free(pool->slabs.elem);
-    *pool = (struct vk_pool) {0};
+    pl_mutex_destroy(&pool->lock);
+    pl_free(pool);
 }
 
 struct vk_malloc *vk_malloc_create(struct vk_ctx *vk)
@@ -518,6 +835,15 @@ struct vk_malloc *vk_malloc_create(struct vk_ctx *vk)
     vk->GetPhysicalDeviceMemoryProperties(vk->physd, &ma->props);
     ma->vk = vk;
 
+    for (int i = 0; i < PL_ARRAY_SIZE(ma->allocated); i++)
+        atomic_init(&ma->allocated[i], 0);
+    atomic_init(&ma->evacuating, 0);
+    atomic_init(&ma->defrag_budget, DEFRAG_BUDGET);
+    for (int i = 0; i < vk->exts.num; i++) {
+        if (strcmp(vk->exts.elem[i], VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+            ma->has_budget = true;
+    }
+
     vk_malloc_print_stats(ma, PL_LOG_INFO);
     return ma;
 }
@@ -529,41 +855,238 @@ void vk_malloc_destroy(struct vk_malloc **ma_ptr)
         return;
 
     for (int i = 0; i < ma->pools.num; i++)
-        pool_uninit(ma->vk, &ma->pools.elem[i]);
+        pool_uninit(ma, ma->pools.elem[i]);
 
     pl_mutex_destroy(&ma->lock);
     pl_free_ptr(ma_ptr);
 }
 
-void vk_malloc_garbage_collect(struct vk_malloc *ma)
+// Picks the most sparsely used slab of a pool for evacuation, as long as the
+// remaining slabs have enough free space to take over its contents. Only one
+// slab per pool is evacuated at a time. Must be called with `pool->lock` held.
+static void pool_defrag(struct vk_malloc *ma, struct vk_pool *pool)
 {
     struct vk_ctx *vk = ma->vk;
+    struct vk_slab *best = NULL;
+    VkDeviceSize avail = 0;
 
-    pl_mutex_lock(&ma->lock);
-    ma->age++;
+    for (int i = 0; i < pool->slabs.num; i++) {
+        struct vk_slab *slab = pool->slabs.elem[i];
+        pl_mutex_lock(&slab->lock);
+        if (slab->evacuate) {
+            if (ma->age - slab->evacuate_age <= MAXIMUM_EVACUATION_AGE) {
+                pl_mutex_unlock(&slab->lock);
+                return; // still in progress
+            }
+
+            PL_DEBUG(vk, "Giving up on evacuating slab of size %s from pool "
+                     "%d, %s remaining", PRINT_SIZE(slab->size), pool->index,
+                     PRINT_SIZE(slab->used));
+            slab->evacuate = false;
+            slab->evacuate_age = ma->age;
+            atomic_fetch_sub(&ma->evacuating, 1);
+        }
+
+        avail += slab->avail;
+        bool sparse = slab->used && slab->used <= slab->size / DEFRAG_THRESHOLD;
+        if (sparse && ma->age - slab->evacuate_age > MAXIMUM_EVACUATION_AGE &&
+            (!best || slab->used * best->size < best->used * slab->size))
+        {
+            best = slab;
+        }
+        pl_mutex_unlock(&slab->lock);
+    }
+
+    if (!best)
+        return;
+
+    pl_mutex_lock(&best->lock);
+    if (avail - best->avail >= best->used) {
+        PL_DEBUG(vk, "Evacuating fragmented slab of size %s from pool %d "
+                 "(%s used, %d blocks)", PRINT_SIZE(best->size), pool->index,
+                 PRINT_SIZE(best->used), best->num_blocks);
+        best->evacuate = true;
+        best->evacuate_age = ma->age;
+        atomic_fetch_add(&ma->evacuating, 1);
+    }
+    pl_mutex_unlock(&best->lock);
+}
+
+// Releases empty slabs, either once they're old enough, or unconditionally
+// if `force` is set. Must be called with `ma->lock` held.
+static void garbage_collect(struct vk_malloc *ma, bool force)
+{
+    struct vk_ctx *vk = ma->vk;
 
     for (int i = 0; i < ma->pools.num; i++) {
-        struct vk_pool *pool = &ma->pools.elem[i];
+        struct vk_pool *pool = ma->pools.elem[i];
+        pl_mutex_lock(&pool->lock);
         for (int n = 0; n < pool->slabs.num; n++) {
             struct vk_slab *slab = pool->slabs.elem[n];
             pl_mutex_lock(&slab->lock);
-            if (slab->used || (ma->age - slab->age) <= MAXIMUM_SLAB_AGE) {
+            bool expired = force || slab->evacuate ||
+                           (ma->age - slab->age) > MAXIMUM_SLAB_AGE;
+            if (slab->used || !expired) {
                 pl_mutex_unlock(&slab->lock);
                 continue;
             }
 
-            PL_DEBUG(vk, "Garbage collected slab of size %s from pool %d",
+            PL_DEBUG(vk, "Garbage collected %sslab of size %s from pool %d",
+                     slab->evacuate ? "evacuated " : "",
                      PRINT_SIZE(slab->size), pool->index);
 
+            if (slab->evacuate)
+                atomic_fetch_sub(&ma->evacuating, 1);
             pl_mutex_unlock(&slab->lock);
-            slab_free(ma->vk, slab);
+            slab_free(ma, slab);
             PL_ARRAY_REMOVE_AT(pool->slabs, n--);
         }
+
+        // Only start defragmenting once the allocator has settled
+        if (!force)
+            pool_defrag(ma, pool);
+        pl_mutex_unlock(&pool->lock);
     }
+}
 
+void vk_malloc_garbage_collect(struct vk_malloc *ma)
+{
+    pl_mutex_lock(&ma->lock);
+    ma->age++;
+
+    // Shortly after memory pressure, don't keep empty slabs around
+    bool pressure = ma->evictions && ma->age - ma->pressure_age <= MAXIMUM_PRESSURE_AGE;
+    garbage_collect(ma, pressure);
+    atomic_store(&ma->defrag_budget, DEFRAG_BUDGET);
     pl_mutex_unlock(&ma->lock);
 }
 
+bool vk_malloc_should_move(struct vk_malloc *ma, const struct vk_memslice *slice)
+{
+    if (!atomic_load(&ma->evacuating) || !slice->block)
+        return false;
+
+    struct vk_slab *slab = slice->priv;
+    pl_mutex_lock(&slab->lock);
+    bool evacuate = slab->evacuate;
+    pl_mutex_unlock(&slab->lock);
+    if (!evacuate)
+        return false;
+
+    size_t budget = atomic_load(&ma->defrag_budget);
+    do {
+        if (budget < slice->size)
+            return false;
+    } while (!atomic_compare_exchange_weak(&ma->defrag_budget, &budget,
+                                           budget - slice->size));
+
+    return true;
+}
+
+void vk_malloc_moved(struct vk_malloc *ma, const struct vk_memslice *slice)
+{
+    atomic_fetch_add(&ma->defrag_moves, 1);
+    atomic_fetch_add(&ma->defrag_bytes, slice->size);
+}
+
+// Returns the total size of the empty slabs in a heap, i.e. the amount of
+// memory `garbage_collect` could release right away. Must be called with
+// `ma->lock` held.
+static VkDeviceSize heap_reclaimable(struct vk_malloc *ma, uint32_t heap_idx)
+{
+    VkDeviceSize size = 0;
+    for (int i = 0; i < ma->pools.num; i++) {
+        struct vk_pool *pool = ma->pools.elem[i];
+        pl_mutex_lock(&pool->lock);
+        for (int n = 0; n < pool->slabs.num; n++) {
+            struct vk_slab *slab = pool->slabs.elem[n];
+            pl_mutex_lock(&slab->lock);
+            if (!slab->used && slab->mtype.heapIndex == heap_idx)
+                size += slab->size;
+            pl_mutex_unlock(&slab->lock);
+        }
+        pl_mutex_unlock(&pool->lock);
+    }
+
+    return size;
+}
+
+// Handles memory pressure while trying to allocate `size` bytes from the
+// given heap. Registered caches are signalled at most once per invocation of
+// `vk_malloc_garbage_collect`, since they only release their resources lazily
+// anyway. Empty slabs are released immediately, but only if doing so makes
+// enough room for the allocation to fit into `budget`. Returns whether any
+// memory was released. Must be called without holding any locks.
+static bool vk_malloc_evict(struct vk_malloc *ma, uint32_t heap_idx,
+                            VkDeviceSize size, VkDeviceSize budget)
+{
+    pl_mutex_lock(&ma->lock);
+    bool signal = !ma->evictions || ma->pressure_age != ma->age;
+    if (signal) {
+        ma->evictions++;
+        ma->pressure_age = ma->age;
+    }
+
+    VkDeviceSize used = atomic_load(&ma->allocated[heap_idx]);
+    VkDeviceSize reclaimable = heap_reclaimable(ma, heap_idx);
+    used -= PL_MIN(used, reclaimable);
+    bool release = reclaimable && size <= budget && used <= budget - size;
+    pl_mutex_unlock(&ma->lock);
+
+    // The pl_gpu does not exist yet while it's being created
+    pl_vulkan pl_vk = ma->vk->vulkan;
+    if (signal && pl_vk->gpu)
+        pl_gpu_evict(pl_vk->gpu);
+
+    if (release) {
+        pl_mutex_lock(&ma->lock);
+        garbage_collect(ma, true);
+        pl_mutex_unlock(&ma->lock);
+    }
+
+    return release;
+}
+
+void vk_malloc_stats(struct vk_malloc *ma, struct pl_vulkan_memory_stats *out)
+{
+    *out = (struct pl_vulkan_memory_stats) {
+        .num_heaps = ma->props.memoryHeapCount,
+    };
+
+    for (int i = 0; i < out->num_heaps; i++) {
+        VkDeviceSize allocated = atomic_load(&ma->allocated[i]);
+        out->heaps[i] = (struct pl_vulkan_heap_stats) {
+            .flags      = ma->props.memoryHeaps[i].flags,
+            .size       = ma->props.memoryHeaps[i].size,
+            .budget     = heap_budget(ma, i),
+            .allocated  = allocated,
+            .used       = allocated,
+        };
+    }
+
+    // Dedicated slabs are always fully used, so only the free space inside
+    // pooled slabs needs to be subtracted
+    pl_mutex_lock(&ma->lock);
+    for (int i = 0; i < ma->pools.num; i++) {
+        struct vk_pool *pool = ma->pools.elem[i];
+        pl_mutex_lock(&pool->lock);
+        for (int j = 0; j < pool->slabs.num; j++) {
+            struct vk_slab *slab = pool->slabs.elem[j];
+            struct pl_vulkan_heap_stats *heap = &out->heaps[slab->mtype.heapIndex];
+            pl_mutex_lock(&slab->lock);
+            heap->used -= PL_MIN(heap->used, slab->size - slab->used);
+            pl_mutex_unlock(&slab->lock);
+        }
+        pl_mutex_unlock(&pool->lock);
+    }
+
+    out->evictions = ma->evictions;
+    pl_mutex_unlock(&ma->lock);
+
+    out->defrag_moves = atomic_load(&ma->defrag_moves);
+    out->defrag_bytes = atomic_load(&ma->defrag_bytes);
+}
+
 pl_handle_caps vk_malloc_handle_caps(const struct vk_malloc *ma, bool import)
 {
     struct vk_ctx *vk = ma->vk;
@@ -587,14 +1110,13 @@ void vk_malloc_free(struct vk_malloc *ma, struct vk_memslice *slice)
     struct vk_ctx *vk = ma->vk;
     struct vk_slab *slab = slice->priv;
     if (!slab || slab->dedicated) {
-        slab_free(vk, slab);
+        slab_free(ma, slab);
         goto done;
     }
 
     pl_mutex_lock(&slab->lock);
 
-    int page_idx = slice->offset / slab->pagesize;
-    slab->spacemap |= 0x1LLU << page_idx;
+    slab_put_block(slab, slice->block);
     slab->used -= slice->size;
     slab->age = ma->age;
     pl_assert(slab->used >= 0);
@@ -628,84 +1150,82 @@ static struct vk_pool *find_pool(struct vk_malloc *ma,
     fixed.reqs.size = 0;
     fixed.shared_mem = (struct pl_shared_mem) {0};
 
+    struct vk_pool *pool = NULL;
+    pl_mutex_lock(&ma->lock);
     for (int i = 0; i < ma->pools.num; i++) {
-        if (pool_params_eq(&ma->pools.elem[i].params, &fixed))
-            return &ma->pools.elem[i];
+        if (pool_params_eq(&ma->pools.elem[i]->params, &fixed)) {
+            pool = ma->pools.elem[i];
+            goto done;
+        }
     }
 
     // Not found => add it
-    PL_ARRAY_GROW(ma, ma->pools);
-    size_t idx = ma->pools.num++;
-    ma->pools.elem[idx] = (struct vk_pool) {
+    pool = pl_alloc_ptr(NULL, pool);
+    *pool = (struct vk_pool) {
         .params = fixed,
-        .index = idx,
+        .index = ma->pools.num,
     };
-    return &ma->pools.elem[idx];
+    pl_mutex_init(&pool->lock);
+    PL_ARRAY_APPEND(ma, ma->pools, pool);
+
+done:
+    pl_mutex_unlock(&ma->lock);
+    return pool;
 }
 
-// Returns a suitable memory page from the pool. A new slab will be allocated
+// Returns a suitable memory block from the pool. A new slab will be allocated
 // under the hood, if necessary.
 //
-// Note: This locks the slab it returns
-static struct vk_slab *pool_get_page(struct vk_malloc *ma, struct vk_pool *pool,
-                                     size_t size, size_t align,
-                                     VkDeviceSize *offset)
+// Note: This locks the slab it returns. Must be called without holding
+// `pool->lock`.
+static struct vk_slab *pool_get_block(struct vk_malloc *ma, struct vk_pool *pool,
+                                      size_t size, size_t align,
+                                      struct vk_block **block)
 {
     struct vk_slab *slab = NULL;
-    int slab_pages = MINIMUM_PAGE_COUNT;
-    size = PL_ALIGN2(size, PAGE_SIZE_ALIGN);
-    const size_t pagesize = PL_ALIGN(size, align);
+    VkDeviceSize pool_size = 0;
+    size = PL_ALIGN2(size, BLOCK_SIZE_ALIGN);
+    align = pl_lcm(align, BLOCK_SIZE_ALIGN);
 
+    pl_mutex_lock(&pool->lock);
     for (int i = 0; i < pool->slabs.num; i++) {
         slab = pool->slabs.elem[i];
-        if (slab->pagesize < size)
-            continue;
-        if (slab->pagesize > pagesize * MINIMUM_PAGE_COUNT) // rough heuristic
-            continue;
-        if (slab->pagesize % align)
-            continue;
+        pool_size += slab->size;
 
         pl_mutex_lock(&slab->lock);
-        int page_idx = __builtin_ffsll(slab->spacemap);
-        if (!page_idx--) {
-            pl_mutex_unlock(&slab->lock);
-            // Increase the number of slabs to allocate for new slabs the
-            // more existing full slabs exist for this size range
-            slab_pages = PL_MIN(slab_pages << 1, MAXIMUM_PAGE_COUNT);
-            continue;
+        *block = slab->evacuate ? NULL : slab_get_block(slab, size, align);
+        if (*block) {
+            pl_mutex_unlock(&pool->lock);
+            return slab;
         }
-
-        slab->spacemap ^= 0x1LLU << page_idx;
         pl_mutex_unlock(&slab->lock);
-        *offset = page_idx * slab->pagesize;
-        return slab;
     }
 
-    // Otherwise, allocate a new vk_slab and append it to the list.
-    VkDeviceSize slab_size = slab_pages * pagesize;
-    pl_static_assert(MINIMUM_SLAB_SIZE <= PAGE_SIZE_ALIGN * MAXIMUM_PAGE_COUNT);
+    // Otherwise, allocate a new vk_slab and append it to the list. Grow
+    // the slab size along with the pool, so the number of slabs per pool
+    // stays logarithmic in the amount of memory used.
+    VkDeviceSize slab_size = PL_MAX(pool_size, MINIMUM_SLAB_BLOCKS * size);
     slab_size = PL_CLAMP(slab_size, MINIMUM_SLAB_SIZE, MAXIMUM_SLAB_SIZE);
-    slab_pages = slab_size / pagesize;
+    slab_size = PL_MAX(slab_size, size + align - BLOCK_SIZE_ALIGN);
 
     struct vk_malloc_params params = pool->params;
     params.reqs.size = slab_size;
 
     // Don't hold the lock while allocating the slab, because it can be a
     // potentially very costly operation.
-    pl_mutex_unlock(&ma->lock);
+    pl_mutex_unlock(&pool->lock);
     slab = slab_alloc(ma, &params);
-    pl_mutex_lock(&ma->lock);
     if (!slab)
         return NULL;
     pl_mutex_lock(&slab->lock);
 
-    slab->spacemap = (slab_pages == sizeof(uint64_t) * 8) ? ~0LLU : ~(~0LLU << slab_pages);
-    slab->pagesize = pagesize;
-    PL_ARRAY_APPEND(NULL, pool->slabs, slab);
+    slab_init_blocks(slab);
+    *block = slab_get_block(slab, size, align);
+    pl_assert(*block);
 
-    // Return the first page in this newly allocated slab
-    slab->spacemap ^= 0x1;
-    *offset = 0;
+    pl_mutex_lock(&pool->lock);
+    PL_ARRAY_APPEND(NULL, pool->slabs, slab);
+    pl_mutex_unlock(&pool->lock);
     return slab;
 }
 
@@ -950,19 +1470,18 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
     align = pl_lcm(align, vk->limits.nonCoherentAtomSize);
 
     struct vk_slab *slab;
+    struct vk_block *block = NULL;
     VkDeviceSize offset;
 
-    if (params->ded_image || size > MAXIMUM_PAGE_SIZE) {
+    if (params->ded_image || size > MAXIMUM_BLOCK_SIZE) {
         slab = slab_alloc(ma, params);
         if (!slab)
             return false;
         slab->dedicated = true;
         offset = 0;
     } else {
-        pl_mutex_lock(&ma->lock);
         struct vk_pool *pool = find_pool(ma, params);
-        slab = pool_get_page(ma, pool, size, align, &offset);
-        pl_mutex_unlock(&ma->lock);
+        slab = pool_get_block(ma, pool, PL_ALIGN(size, align), align, &block);
         if (!slab) {
             PL_ERR(ma->vk, "No slab to serve request for %s bytes (with "
                    "alignment 0x%zx) in pool %d!",
@@ -974,6 +1493,7 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
         // Doing it this way makes sure that the sizes reported to vk_memslice
         // consumers are always aligned properly.
         size = PL_ALIGN(size, align);
+        offset = block->offset;
         slab->used += size;
         slab->age = ma->age;
         pl_mutex_unlock(&slab->lock);
@@ -990,6 +1510,7 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
         .map_offset = slab->data ? offset : 0,
         .map_size = slab->data ? size : 0,
         .priv = slab,
+        .block = block,
         .shared_mem = {
             .handle = slab->handle,
             .offset = offset,
@@ -34,6 +34,7 @@ struct vk_memslice {
     VkDeviceSize offset;
     VkDeviceSize size;
     void *priv;
+    struct vk_block *block; // sub-allocation within `priv` (if not dedicated)
     // depending on the type/flags:
     struct pl_shared_mem shared_mem;
     VkBuffer buf;   // associated buffer (when `buf_usage` is nonzero)
@@ -60,8 +61,22 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
 void vk_malloc_free(struct vk_malloc *ma, struct vk_memslice *slice);
 
 // Clean up unused slabs. Call this roughly once per frame to reduce
-// memory pressure / memory leaks.
+// memory pressure / memory leaks. This also picks fragmented slabs to be
+// evacuated, see `vk_malloc_should_move`.
 void vk_malloc_garbage_collect(struct vk_malloc *ma);
 
+// Returns whether the owner of an idle slice should move its contents to a
+// new allocation (and free this one), to allow a fragmented slab to be
+// released. Returning true charges the size of the slice against a per-frame
+// budget, so callers should follow through with the move.
+bool vk_malloc_should_move(struct vk_malloc *ma, const struct vk_memslice *slice);
+
+// Records that the contents of `slice` were relocated to a new allocation,
+// for `pl_vulkan_memory_stats`. Call this before freeing the old slice.
+void vk_malloc_moved(struct vk_malloc *ma, const struct vk_memslice *slice);
+
 // For debugging purposes. Doesn't include dedicated slab allocations!
 void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level);
+
+// Per-heap memory usage and budget, see `pl_vulkan_memory_stats`
+void vk_malloc_stats(struct vk_malloc *ma, struct pl_vulkan_memory_stats *out);
@@ -774,7 +774,7 @@ static bool vk_sw_submit_frame(pl_swapchain sw)
 
     pl_rc_ref(&p->frames_in_flight);
     vk_cmd_callback(cmd, (vk_cb) present_cb, p, NULL);
-    if (!vk_cmd_submit(vk, &cmd)) {
+    if (!pl_vk_submit_stolen(gpu, &cmd) || !vk_flush_commands(vk)) {
         pl_mutex_unlock(&p->lock);
         return false;
     }